@@ -13,7 +13,7 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
 {
   constexpr size_t buffer_size = 1048576;
 
-  EventLoop _eventloop {};
+  EventLoop _eventloop { EventLoop::Backend::Poll, EventLoop::Dispatch::All };
   FileDescriptor _input { STDIN_FILENO };
   FileDescriptor _output { STDOUT_FILENO };
   ByteStream _outbound { buffer_size };
@@ -56,9 +56,7 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
     socket,
     Direction::Out,
     [&] {
-      if ( _outbound.reader().bytes_buffered() ) {
-        _outbound.reader().pop( socket.write( _outbound.reader().peek() ) );
-      }
+      drain( _outbound.reader(), socket );
       if ( _outbound.reader().is_finished() ) {
         socket.shutdown( SHUT_WR );
         _outbound_shutdown = true;
@@ -106,9 +104,7 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
     _output,
     Direction::Out,
     [&] {
-      if ( _inbound.reader().bytes_buffered() ) {
-        _inbound.reader().pop( _output.write( _inbound.reader().peek() ) );
-      }
+      drain( _inbound.reader(), _output );
       if ( _inbound.reader().is_finished() ) {
         _output.close();
         _inbound_shutdown = true;
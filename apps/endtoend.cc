@@ -134,6 +134,7 @@ public:
   }
   void write( const TCPMessage& msg ) { _interface.send_datagram( wrap_tcp_in_ip( msg ), _next_hop ); }
   void tick( const size_t ms_since_last_tick ) { _interface.tick( ms_since_last_tick ); }
+  optional<uint64_t> ms_until_deadline() const { return _interface.ms_until_deadline(); }
   NetworkInterface& interface() { return _interface; }
 
   FileDescriptor& fd() { return sender_->sockets.first; }
@@ -238,7 +239,7 @@ void program_body( bool is_client, const string& bounce_host, const string& boun
   /* set up the network */
   thread network_thread( [&]() {
     try {
-      EventLoop event_loop;
+      EventLoop event_loop { EventLoop::Backend::Poll, EventLoop::Dispatch::All };
       // Frames from host to router
       event_loop.add_rule( "frames from host to router", sock.adapter().frame_fd(), Direction::In, [&] {
         auto frame_opt = maybe_receive_frame( sock.adapter().frame_fd() );
@@ -297,13 +298,42 @@ void program_body( bool is_client, const string& bounce_host, const string& boun
         router.route();
       } );
 
+      // Wake when an ARP entry or request on either side of the router expires, and check for exit in between.
+      const size_t timer_category = event_loop.add_category( "router timer" );
+      optional<EventLoop::RuleHandle> timer;
+      optional<uint64_t> timer_deadline;
+      auto base_time = timestamp_ms();
+
       while ( true ) {
-        if ( EventLoop::Result::Exit == event_loop.wait_next_event( 10 ) ) {
+        optional<uint64_t> deadline;
+        for ( const auto side : { host_side, internet_side } ) {
+          if ( const auto wait = router.interface( side )->ms_until_deadline() ) {
+            deadline = min( deadline.value_or( base_time + wait.value() ), base_time + wait.value() );
+          }
+        }
+
+        if ( deadline != timer_deadline ) {
+          if ( timer.has_value() ) {
+            timer->cancel();
+            timer.reset();
+          }
+          if ( deadline.has_value() ) {
+            const auto now = timestamp_ms();
+            const auto delay = deadline.value() > now ? deadline.value() - now : 0;
+            timer = event_loop.add_timer( timer_category, delay, [&] { timer_deadline.reset(); } );
+          }
+          timer_deadline = deadline;
+        }
+
+        if ( EventLoop::Result::Exit == event_loop.wait_next_event( 100 ) ) {
           cerr << "Exiting...\n";
           return;
         }
-        router.interface( host_side )->tick( 10 );
-        router.interface( internet_side )->tick( 10 );
+
+        const auto next_time = timestamp_ms();
+        router.interface( host_side )->tick( next_time - base_time );
+        router.interface( internet_side )->tick( next_time - base_time );
+        base_time = next_time;
 
         if ( exit_flag ) {
           return;
@@ -12,6 +12,8 @@
 #include <string>
 #include <tuple>
 
+#include <strings.h>
+
 using namespace std;
 
 constexpr const char* TUN_DFLT = "tun144";
@@ -31,9 +33,15 @@ void show_usage( const char* argv0, const char* msg )
        << "   -s <port>       Set source port (client mode only)              (random)\n\n"
 
        << "   -w <winsz>      Use a window of <winsz> bytes                   " << TCPConfig::MAX_PAYLOAD_SIZE
-       << "\n\n"
+       << "\n"
+       << "   -W              Scale the window to cover it (up to 1 GiB)      (64 KiB at most)\n\n"
 
-       << "   -t <tmout>      Set rt_timeout to tmout                         " << TCPConfig::TIMEOUT_DFLT << "\n\n"
+       << "   -t <tmout>      Set rt_timeout to tmout                         " << TCPConfig::TIMEOUT_DFLT << "\n"
+       << "   -R <min>        Adapt the RTO to the RTT, down to <min> ms      (fixed RTO)\n"
+       << "   -F              Retransmit after three duplicate ACKs           (on timeout only)\n"
+       << "   -S              Permit SACK, and retransmit only the holes      (no SACK)\n"
+       << "   -D <delay>      Delay ACKs by up to <delay> ms                  (ACK every segment)\n"
+       << "   -C <algorithm>  Congestion control: newreno, cubic or bbr       (none)\n\n"
 
        << "   -d <tundev>     Connect to tun <tundev>                         " << TUN_DFLT << "\n\n"
 
@@ -96,6 +104,45 @@ tuple<TCPConfig, FdAdapterConfig, bool, const char*> get_config( const span<char
       c_fsm.rt_timeout = strtol( args[curr + 1], nullptr, 0 );
       curr += 2;
 
+    } else if ( strncmp( "-R", args[curr], 3 ) == 0 ) {
+      check_argc( args, curr, "ERROR: -R requires one argument." );
+      c_fsm.adaptive_rto = true;
+      c_fsm.rto_min = strtol( args[curr + 1], nullptr, 0 );
+      curr += 2;
+
+    } else if ( strncmp( "-F", args[curr], 3 ) == 0 ) {
+      c_fsm.fast_retransmit = true;
+      curr += 1;
+
+    } else if ( strncmp( "-W", args[curr], 3 ) == 0 ) {
+      c_fsm.window_scaling = true;
+      curr += 1;
+
+    } else if ( strncmp( "-S", args[curr], 3 ) == 0 ) {
+      c_fsm.sack = true;
+      curr += 1;
+
+    } else if ( strncmp( "-D", args[curr], 3 ) == 0 ) {
+      check_argc( args, curr, "ERROR: -D requires one argument." );
+      c_fsm.ack_delay = strtol( args[curr + 1], nullptr, 0 );
+      curr += 2;
+
+    } else if ( strncmp( "-C", args[curr], 3 ) == 0 ) {
+      check_argc( args, curr, "ERROR: -C requires one argument." );
+      using enum CongestionControl::Algorithm;
+      bool known = false;
+      for ( const auto algorithm : { None, NewReno, Cubic, BBR } ) {
+        if ( strcasecmp( CongestionControl::name( algorithm ), args[curr + 1] ) == 0 ) {
+          c_fsm.congestion_control = algorithm;
+          known = true;
+        }
+      }
+      if ( not known ) {
+        show_usage( args[0], "ERROR: -C must be newreno, cubic or bbr." );
+        exit( 1 );
+      }
+      curr += 2;
+
     } else if ( strncmp( "-d", args[curr], 3 ) == 0 ) {
       check_argc( args, curr, "ERROR: -t requires one argument." );
       tundev = args[curr + 1];
@@ -38,6 +38,15 @@ ttest(wrapping_integers_unwrap)
 ttest(wrapping_integers_roundtrip)
 ttest(wrapping_integers_extra)
 
+ttest(internet_checksum)
+ttest(serializer_frame)
+ttest(parse_in_place)
+ttest(timer_wheel)
+ttest(eventloop_cancel)
+ttest(slot_map)
+ttest(spsc_ring)
+ttest(toeplitz)
+
 ttest(recv_connect)
 ttest(recv_transmit)
 ttest(recv_window)
@@ -45,6 +54,8 @@ ttest(recv_reorder)
 ttest(recv_reorder_more)
 ttest(recv_close)
 ttest(recv_special)
+ttest(recv_sack)
+ttest(recv_window_scale)
 
 ttest(send_connect)
 ttest(send_transmit)
@@ -53,6 +64,14 @@ ttest(send_window)
 ttest(send_ack)
 ttest(send_close)
 ttest(send_extra)
+ttest(send_congestion)
+ttest(send_rto)
+ttest(send_fast_retx)
+ttest(send_sack)
+ttest(send_window_scale)
+
+ttest(peer_fast_retx)
+ttest(peer_delayed_ack)
 
 ttest(net_interface)
 
@@ -90,3 +109,19 @@ set_tests_properties(${compile_name_opt} PROPERTIES FIXTURES_SETUP compile_opt)
 
 stest(byte_stream_speed_test)
 stest(reassembler_speed_test)
+stest(reassembler_sweep_speed_test)
+stest(checksum_speed_test)
+stest(router_speed_test)
+stest(parser_speed_test)
+stest(tcp_over_ip_speed_test)
+stest(eventloop_speed_test)
+stest(tcp_stack_speed_test)
+stest(sharded_tcp_stack_speed_test)
+stest(tun_read_speed_test)
+stest(tun_batch_speed_test)
+stest(delayed_ack_speed_test)
+stest(congestion_control_speed_test)
+stest(adaptive_rto_speed_test)
+stest(fast_retransmit_speed_test)
+stest(sack_speed_test)
+stest(window_scale_speed_test)
@@ -1,8 +1,13 @@
 #include "byte_stream.hh"
+#include "buffer_pool.hh"
+
+#include <algorithm>
 
 using namespace std;
 
-ByteStream::ByteStream( uint64_t capacity ) : capacity_( capacity ) {}
+ByteStream::ByteStream( uint64_t capacity, Mode mode )
+  : capacity_( capacity ), mode_( mode ), buffer_( mode == Mode::Ring ? capacity : 0, '\0' )
+{}
 
 bool Writer::is_closed() const
 {
@@ -11,13 +16,34 @@ bool Writer::is_closed() const
 
 void Writer::push( string data )
 {
-  uint64_t push_length = min( capacity_, data.size() );
-  if ( !is_closed() ) {
-    data = data.substr( 0, push_length );
-    stream_data.append( data );
-    capacity_ -= push_length;
+  const uint64_t push_length = min( available_capacity(), static_cast<uint64_t>( data.size() ) );
+  if ( is_closed() or push_length == 0 ) {
+    return;
+  }
+
+  if ( mode_ == Mode::Chunked ) {
     total_bytes_pushed += push_length;
+    data.resize( push_length );
+    // don't let a short string pin a much larger allocation (e.g. a read buffer) for as long as it is buffered;
+    // a BufferPool buffer may be up to a quarter full (a 536-byte segment, say), as it is recycled once read
+    const uint64_t slack = BufferPool::is_buffer( data ) ? 4 : 2;
+    if ( data.capacity() / slack > data.size() ) {
+      data.shrink_to_fit();
+    }
+    chunks_.push_back( move( data ) );
+    return;
   }
+
+  // copy into the free region after the buffered bytes, wrapping around to the front if needed
+  uint64_t tail = head_ + reader().bytes_buffered();
+  if ( tail >= capacity_ ) {
+    tail -= capacity_;
+  }
+  const uint64_t first_part = min( push_length, capacity_ - tail );
+  data.copy( buffer_.data() + tail, first_part );
+  data.copy( buffer_.data(), push_length - first_part, first_part );
+  total_bytes_pushed += push_length;
+  BufferPool::recycle( move( data ) );
 }
 
 void Writer::close()
@@ -27,7 +53,7 @@ void Writer::close()
 
 uint64_t Writer::available_capacity() const
 {
-  return capacity_;
+  return capacity_ - reader().bytes_buffered();
 }
 
 uint64_t Writer::bytes_pushed() const
@@ -47,14 +73,85 @@ uint64_t Reader::bytes_popped() const
 
 string_view Reader::peek() const
 {
-  return stream_data;
+  if ( mode_ == Mode::Chunked ) {
+    return chunks_.empty() ? string_view {} : string_view { chunks_.front() }.substr( head_ );
+  }
+  return string_view { buffer_ }.substr( head_, min( bytes_buffered(), capacity_ - head_ ) );
+}
+
+string_view Reader::peek_wrapped() const
+{
+  if ( mode_ == Mode::Chunked ) {
+    return chunks_.size() < 2 ? string_view {} : string_view { chunks_[1] };
+  }
+  return string_view { buffer_ }.substr( 0, bytes_buffered() - peek().size() );
+}
+
+vector<string_view> Reader::peek_iov( size_t max_segments ) const
+{
+  vector<string_view> segments;
+  if ( max_segments == 0 or bytes_buffered() == 0 ) {
+    return segments;
+  }
+
+  if ( mode_ == Mode::Ring ) {
+    segments.push_back( peek() );
+    if ( max_segments > 1 and not peek_wrapped().empty() ) {
+      segments.push_back( peek_wrapped() );
+    }
+    return segments;
+  }
+
+  segments.reserve( min( max_segments, chunks_.size() ) );
+  segments.push_back( peek() );
+  for ( auto it = next( chunks_.begin() ); it != chunks_.end() and segments.size() < max_segments; ++it ) {
+    segments.emplace_back( *it );
+  }
+  return segments;
 }
 
 void Reader::pop( uint64_t len )
 {
-  stream_data.erase( 0, len );
+  len = min( len, bytes_buffered() );
   total_bytes_poped += len;
-  capacity_ += len;
+
+  if ( mode_ == Mode::Chunked ) {
+    while ( len > 0 ) {
+      const uint64_t front_remaining = chunks_.front().size() - head_;
+      if ( len < front_remaining ) {
+        head_ += len;
+        return;
+      }
+      len -= front_remaining;
+      BufferPool::recycle( move( chunks_.front() ) );
+      chunks_.pop_front();
+      head_ = 0;
+    }
+    return;
+  }
+
+  head_ += len;
+  if ( head_ >= capacity_ ) {
+    head_ -= capacity_;
+  }
+  // keep the next push contiguous when the buffer drains
+  if ( bytes_buffered() == 0 ) {
+    head_ = 0;
+  }
+}
+
+string Reader::pop_string( uint64_t len )
+{
+  if ( mode_ == Mode::Chunked and head_ == 0 and not chunks_.empty() and chunks_.front().size() <= len ) {
+    string chunk = move( chunks_.front() );
+    chunks_.pop_front();
+    total_bytes_poped += chunk.size();
+    return chunk;
+  }
+
+  string out { peek().substr( 0, len ) };
+  pop( out.size() );
+  return out;
 }
 
 uint64_t Reader::bytes_buffered() const
@@ -1,16 +1,26 @@
 #pragma once
 
 #include <cstdint>
+#include <deque>
 #include <string>
 #include <string_view>
+#include <vector>
 
 class Reader;
 class Writer;
+class FileDescriptor;
 
 class ByteStream
 {
 public:
-  explicit ByteStream( uint64_t capacity );
+  // How the buffered bytes are stored
+  enum class Mode
+  {
+    Ring,   // fixed-capacity circular buffer; pushed strings are copied in
+    Chunked // queue of the pushed strings themselves; pushed strings are moved in without copying
+  };
+
+  explicit ByteStream( uint64_t capacity, Mode mode = Mode::Ring );
 
   // Helper functions (provided) to access the ByteStream's Reader and Writer interfaces
   Reader& reader();
@@ -25,7 +35,10 @@ protected:
   // Please add any additional state to the ByteStream here, and not to the Writer and Reader interfaces.
   uint64_t capacity_;
   bool error_ {};
-  std::string stream_data {};
+  Mode mode_;
+  std::string buffer_;                // Ring: circular buffer of `capacity_` bytes, allocated once at construction
+  std::deque<std::string> chunks_ {}; // Chunked: pushed strings that have not been fully popped
+  uint64_t head_ {}; // Ring: index in `buffer_` of the next byte to pop; Chunked: offset into chunks_.front()
   bool write_have_been_closed = false;
   uint64_t total_bytes_pushed = 0;
   uint64_t total_bytes_poped = 0;
@@ -45,8 +58,13 @@ public:
 class Reader : public ByteStream
 {
 public:
-  std::string_view peek() const; // Peek at the next bytes in the buffer
-  void pop( uint64_t len );      // Remove `len` bytes from the buffer
+  std::string_view peek() const;         // Peek at the next bytes in the buffer (largest contiguous run)
+  std::string_view peek_wrapped() const; // Peek at the contiguous run that follows peek()
+  void pop( uint64_t len );              // Remove `len` bytes from the buffer
+  std::string pop_string( uint64_t len ); // Remove and return up to `len` bytes of peek() (moved when possible)
+
+  // Peek at everything buffered, as up to `max_segments` contiguous runs (in order)
+  std::vector<std::string_view> peek_iov( size_t max_segments = 64 ) const;
 
   bool is_finished() const;        // Is the stream finished (closed and fully popped)?
   uint64_t bytes_buffered() const; // Number of bytes currently buffered (pushed and not popped)
@@ -58,3 +76,10 @@ public:
  * from a ByteStream Reader into a string;
  */
 void read( Reader& reader, uint64_t len, std::string& out );
+
+/*
+ * drain: A helper function that writes the buffered bytes of a ByteStream Reader
+ * to a file descriptor with a single writev, and pops exactly what was written.
+ * Returns the number of bytes written.
+ */
+uint64_t drain( Reader& reader, FileDescriptor& fd );
@@ -1,4 +1,5 @@
 #include "byte_stream.hh"
+#include "file_descriptor.hh"
 
 #include <cstdint>
 #include <stdexcept>
@@ -12,18 +13,29 @@ void read( Reader& reader, uint64_t len, std::string& out )
   out.clear();
 
   while ( reader.bytes_buffered() and out.size() < len ) {
-    auto view = reader.peek();
-
-    if ( view.empty() ) {
+    if ( reader.peek().empty() ) {
       throw std::runtime_error( "Reader::peek() returned empty string_view" );
     }
 
-    view = view.substr( 0, len - out.size() ); // Don't return more bytes than desired.
-    out += view;
-    reader.pop( view.size() );
+    if ( out.empty() ) {
+      out = reader.pop_string( len ); // Don't return more bytes than desired.
+    } else {
+      out += reader.pop_string( len - out.size() );
+    }
   }
 }
 
+uint64_t drain( Reader& reader, FileDescriptor& fd )
+{
+  if ( not reader.bytes_buffered() ) {
+    return 0;
+  }
+
+  const uint64_t bytes_written = fd.write( reader.peek_iov() );
+  reader.pop( bytes_written );
+  return bytes_written;
+}
+
 Reader& ByteStream::reader()
 {
   static_assert( sizeof( Reader ) == sizeof( ByteStream ),
@@ -0,0 +1,227 @@
+#include "congestion_control.hh"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+constexpr uint64_t INITIAL_WINDOW_SEGMENTS = 10; // RFC 6928
+} // namespace
+
+unique_ptr<CongestionControl> CongestionControl::make( Algorithm algorithm, uint64_t mss )
+{
+  switch ( algorithm ) {
+    case Algorithm::NewReno:
+      return make_unique<NewReno>( mss );
+    case Algorithm::Cubic:
+      return make_unique<Cubic>( mss );
+    case Algorithm::BBR:
+      return make_unique<BBR>( mss );
+    case Algorithm::None:
+      break;
+  }
+  return {};
+}
+
+const char* CongestionControl::name( Algorithm algorithm )
+{
+  switch ( algorithm ) {
+    case Algorithm::NewReno:
+      return "NewReno";
+    case Algorithm::Cubic:
+      return "CUBIC";
+    case Algorithm::BBR:
+      return "BBR";
+    case Algorithm::None:
+      break;
+  }
+  return "none";
+}
+
+NewReno::NewReno( uint64_t mss ) : mss_( mss ), cwnd_( INITIAL_WINDOW_SEGMENTS * mss ) {}
+
+void NewReno::on_ack( const AckSample& sample )
+{
+  if ( sample.in_recovery ) {
+    return;
+  }
+
+  if ( cwnd_ < ssthresh_ ) {
+    cwnd_ += min( sample.bytes_acked, mss_ );
+    return;
+  }
+
+  bytes_acked_ += sample.bytes_acked;
+  if ( bytes_acked_ >= cwnd_ ) {
+    bytes_acked_ -= cwnd_;
+    cwnd_ += mss_;
+  }
+}
+
+void NewReno::on_timeout( uint64_t /* now_ms */, uint64_t bytes_in_flight )
+{
+  ssthresh_ = max( bytes_in_flight / 2, 2 * mss_ );
+  cwnd_ = mss_;
+  bytes_acked_ = 0;
+}
+
+void NewReno::on_fast_retransmit( uint64_t /* now_ms */, uint64_t bytes_in_flight )
+{
+  ssthresh_ = max( bytes_in_flight / 2, 2 * mss_ );
+  cwnd_ = ssthresh_;
+  bytes_acked_ = 0;
+}
+
+Cubic::Cubic( uint64_t mss ) : mss_( mss ), cwnd_( INITIAL_WINDOW_SEGMENTS ) {}
+
+uint64_t Cubic::window() const
+{
+  return static_cast<uint64_t>( max( cwnd_, 1.0 ) * static_cast<double>( mss_ ) );
+}
+
+void Cubic::on_ack( const AckSample& sample )
+{
+  const double acked = static_cast<double>( sample.bytes_acked ) / static_cast<double>( mss_ );
+  rtt_ms_ = sample.rtt_ms.value_or( rtt_ms_ );
+  if ( sample.in_recovery ) {
+    return;
+  }
+
+  if ( cwnd_ < ssthresh_ ) {
+    cwnd_ += min( acked, 1.0 );
+    return;
+  }
+
+  if ( not epoch_start_.has_value() ) {
+    epoch_start_ = sample.now_ms;
+    if ( cwnd_ < w_max_ ) {
+      k_ = cbrt( ( w_max_ - cwnd_ ) / C );
+    } else {
+      k_ = 0;
+      w_max_ = cwnd_;
+    }
+    w_est_ = cwnd_;
+  }
+
+  // where the cubic curve will be an RTT from now, and where NewReno would be
+  const double t = static_cast<double>( sample.now_ms - epoch_start_.value() + rtt_ms_ ) / 1000;
+  const double target = C * pow( t - k_, 3 ) + w_max_;
+  w_est_ += 3 * ( 1 - BETA ) / ( 1 + BETA ) * acked / cwnd_;
+
+  if ( target < w_est_ ) {
+    cwnd_ = w_est_;
+  } else {
+    cwnd_ += ( min( target, 1.5 * cwnd_ ) - cwnd_ ) / cwnd_ * acked;
+  }
+}
+
+void Cubic::on_timeout( uint64_t now_ms, uint64_t bytes_in_flight )
+{
+  on_fast_retransmit( now_ms, bytes_in_flight );
+  cwnd_ = 1;
+}
+
+void Cubic::on_fast_retransmit( uint64_t /* now_ms */, uint64_t /* bytes_in_flight */ )
+{
+  // (fast convergence: a window that stopped short of the last one leaves room for other flows)
+  w_max_ = cwnd_ < w_max_ ? cwnd_ * ( 1 + BETA ) / 2 : cwnd_;
+  ssthresh_ = max( cwnd_ * BETA, 2.0 );
+  cwnd_ = ssthresh_;
+  epoch_start_.reset();
+}
+
+BBR::BBR( uint64_t mss ) : mss_( mss ) {}
+
+uint64_t BBR::bdp() const
+{
+  return bandwidth() * min_rtt_.value_or( 0 ) / 1000;
+}
+
+uint64_t BBR::window() const
+{
+  if ( restarting_ ) {
+    return mss_;
+  }
+  if ( bandwidth() == 0 or not min_rtt_.has_value() ) {
+    return INITIAL_WINDOW_SEGMENTS * mss_;
+  }
+  return max( static_cast<uint64_t>( cwnd_gain_ * static_cast<double>( bdp() ) ), 4 * mss_ );
+}
+
+optional<uint64_t> BBR::pacing_rate() const
+{
+  if ( bandwidth() == 0 ) {
+    return {};
+  }
+  return static_cast<uint64_t>( pacing_gain_ * static_cast<double>( bandwidth() ) );
+}
+
+void BBR::on_ack( const AckSample& sample )
+{
+  static constexpr array<double, 8> PROBE_GAINS { 1.25, 0.75, 1, 1, 1, 1, 1, 1 };
+
+  restarting_ = false;
+
+  if ( sample.rtt_ms.has_value()
+       and ( not min_rtt_.has_value() or sample.rtt_ms.value() <= min_rtt_.value()
+             or sample.now_ms - min_rtt_stamp_ > MIN_RTT_WINDOW_MS ) ) {
+    min_rtt_ = sample.rtt_ms;
+    min_rtt_stamp_ = sample.now_ms;
+  }
+
+  // a round trip is a min RTT of the sender's clock
+  const bool new_round = sample.now_ms >= round_start_ + max<uint64_t>( min_rtt_.value_or( 0 ), 1 );
+  if ( new_round ) {
+    ++round_;
+    round_start_ = sample.now_ms;
+  }
+
+  if ( sample.delivery_rate.has_value() ) {
+    while ( not bandwidth_.empty() and bandwidth_.back().second <= sample.delivery_rate.value() ) {
+      bandwidth_.pop_back();
+    }
+    bandwidth_.emplace_back( round_, sample.delivery_rate.value() );
+  }
+  while ( not bandwidth_.empty() and bandwidth_.front().first + BANDWIDTH_WINDOW_ROUNDS <= round_ ) {
+    bandwidth_.pop_front();
+  }
+
+  switch ( mode_ ) {
+    case Mode::Startup:
+      if ( new_round and bandwidth() > 0 ) {
+        if ( bandwidth() * 4 >= full_bandwidth_ * 5 ) {
+          full_bandwidth_ = bandwidth();
+          full_bandwidth_count_ = 0;
+        } else if ( ++full_bandwidth_count_ >= 3 ) {
+          mode_ = Mode::Drain;
+          pacing_gain_ = 1 / STARTUP_GAIN;
+        }
+      }
+      break;
+
+    case Mode::Drain:
+      if ( sample.bytes_in_flight <= bdp() ) {
+        mode_ = Mode::ProbeBandwidth;
+        cwnd_gain_ = 2;
+        cycle_index_ = 0;
+        cycle_start_ = sample.now_ms;
+        pacing_gain_ = PROBE_GAINS[cycle_index_];
+      }
+      break;
+
+    case Mode::ProbeBandwidth:
+      if ( sample.now_ms >= cycle_start_ + min_rtt_.value_or( 0 ) ) {
+        cycle_index_ = ( cycle_index_ + 1 ) % PROBE_GAINS.size();
+        cycle_start_ = sample.now_ms;
+        pacing_gain_ = PROBE_GAINS[cycle_index_];
+      }
+      break;
+  }
+}
+
+void BBR::on_timeout( uint64_t /* now_ms */, uint64_t /* bytes_in_flight */ )
+{
+  restarting_ = true;
+}
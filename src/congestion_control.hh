@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <utility>
+
+/* What the TCPSender learned from an ACK that acknowledged new data */
+struct AckSample
+{
+  uint64_t now_ms {};                       // the sender's clock (the time passed to its tick() so far)
+  uint64_t bytes_acked {};                  // sequence numbers newly acknowledged
+  uint64_t bytes_in_flight {};              // sequence numbers still outstanding after the ACK
+  std::optional<uint64_t> rtt_ms {};        // RTT of the newest segment acknowledged, if none was retransmitted
+  std::optional<uint64_t> delivery_rate {}; // bytes per second acknowledged while that segment was in flight
+  bool in_recovery {};                      // the sender is recovering from a fast retransmit
+};
+
+/* A congestion controller: the TCPSender asks it how many sequence numbers may be outstanding (the congestion
+   window) and how fast to send them (the pacing rate), and tells it about ACKs and retransmission timeouts. */
+class CongestionControl
+{
+public:
+  enum class Algorithm : uint8_t
+  {
+    None,    // no congestion control: send whatever the receiver's window allows
+    NewReno, // slow start and additive increase, halving on loss (RFC 5681)
+    Cubic,   // window growth as a cubic function of the time since the last loss (RFC 9438)
+    BBR,     // a model of the bottleneck bandwidth and minimum RTT, pacing at the bandwidth it measures
+  };
+
+  /* Make a controller for the given algorithm and maximum segment size (none for Algorithm::None) */
+  static std::unique_ptr<CongestionControl> make( Algorithm algorithm, uint64_t mss );
+
+  /* Name of the given algorithm */
+  static const char* name( Algorithm algorithm );
+
+  virtual ~CongestionControl() = default;
+
+  /* How many sequence numbers may be outstanding */
+  virtual uint64_t window() const = 0;
+
+  /* How fast to send, in bytes per second (none to send as soon as the window allows) */
+  virtual std::optional<uint64_t> pacing_rate() const { return {}; }
+
+  /* An ACK acknowledged new data */
+  virtual void on_ack( const AckSample& sample ) = 0;
+
+  /* The retransmission timer expired with `bytes_in_flight` sequence numbers outstanding */
+  virtual void on_timeout( uint64_t now_ms, uint64_t bytes_in_flight ) = 0;
+
+  /* Duplicate ACKs made the sender retransmit with `bytes_in_flight` outstanding; recovery lasts until everything
+     outstanding now is acknowledged */
+  virtual void on_fast_retransmit( uint64_t now_ms, uint64_t bytes_in_flight ) = 0;
+
+protected:
+  CongestionControl() = default;
+  CongestionControl( const CongestionControl& other ) = default;
+  CongestionControl& operator=( const CongestionControl& other ) = default;
+};
+
+/* NewReno's window: grow by a segment per ACK in slow start and by a segment per window after that. On a loss,
+   remember half the flight as the slow-start threshold, and continue from there after a fast retransmit or from
+   one segment after a timeout. */
+class NewReno : public CongestionControl
+{
+public:
+  explicit NewReno( uint64_t mss );
+
+  uint64_t window() const override { return cwnd_; }
+  void on_ack( const AckSample& sample ) override;
+  void on_timeout( uint64_t now_ms, uint64_t bytes_in_flight ) override;
+  void on_fast_retransmit( uint64_t now_ms, uint64_t bytes_in_flight ) override;
+
+private:
+  uint64_t mss_;
+  uint64_t cwnd_;
+  uint64_t ssthresh_ { UINT64_MAX };
+  uint64_t bytes_acked_ {}; // acknowledged since the window last grew, in congestion avoidance
+};
+
+/* CUBIC's window: after a loss, grow along W(t) = C (t - K)^3 + W_max back to the window where the loss happened
+   and then beyond it, but never slower than NewReno would have */
+class Cubic : public CongestionControl
+{
+public:
+  explicit Cubic( uint64_t mss );
+
+  uint64_t window() const override;
+  void on_ack( const AckSample& sample ) override;
+  void on_timeout( uint64_t now_ms, uint64_t bytes_in_flight ) override;
+  void on_fast_retransmit( uint64_t now_ms, uint64_t bytes_in_flight ) override;
+
+private:
+  static constexpr double C = 0.4;    // in segments per second cubed
+  static constexpr double BETA = 0.7; // multiplicative decrease
+
+  uint64_t mss_;
+  double cwnd_;                            // in segments
+  double ssthresh_ { 1e12 };               // in segments
+  double w_max_ {};                        // window (in segments) when the last loss happened
+  double w_est_ {};                        // what NewReno's window would be, in segments
+  double k_ {};                            // seconds it takes to grow back to w_max_
+  std::optional<uint64_t> epoch_start_ {}; // when the current growth began
+  uint64_t rtt_ms_ {};                     // the latest RTT sample
+};
+
+/* A simplified BBR: measure the bottleneck bandwidth (the highest delivery rate recently seen) and the minimum RTT,
+   pace at the bandwidth and keep about twice their product in flight. Starts by doubling the pacing rate each
+   round trip until the bandwidth stops growing, drains the queue that built, and then cycles the pacing rate a
+   little above and below the bandwidth to keep probing for more. Loss only matters through the model (and a
+   timeout). */
+class BBR : public CongestionControl
+{
+public:
+  explicit BBR( uint64_t mss );
+
+  uint64_t window() const override;
+  std::optional<uint64_t> pacing_rate() const override;
+  void on_ack( const AckSample& sample ) override;
+  void on_timeout( uint64_t now_ms, uint64_t bytes_in_flight ) override;
+  void on_fast_retransmit( uint64_t /* now_ms */, uint64_t /* bytes_in_flight */ ) override {}
+
+private:
+  enum class Mode : uint8_t
+  {
+    Startup,
+    Drain,
+    ProbeBandwidth,
+  };
+
+  static constexpr double STARTUP_GAIN = 2.885; // 2/ln(2): doubles the rate every round trip
+  static constexpr uint64_t BANDWIDTH_WINDOW_ROUNDS = 10;
+  static constexpr uint64_t MIN_RTT_WINDOW_MS = 10000;
+
+  uint64_t mss_;
+  Mode mode_ { Mode::Startup };
+  double pacing_gain_ { STARTUP_GAIN };
+  double cwnd_gain_ { STARTUP_GAIN };
+  unsigned cycle_index_ {};
+  uint64_t cycle_start_ {};
+
+  std::deque<std::pair<uint64_t, uint64_t>> bandwidth_ {}; // (round, delivery rate): a sliding-window maximum
+  uint64_t round_ {};
+  uint64_t round_start_ {};
+  std::optional<uint64_t> min_rtt_ {};
+  uint64_t min_rtt_stamp_ {};
+
+  uint64_t full_bandwidth_ {};       // in Startup, the bandwidth the last time it grew by a quarter
+  unsigned full_bandwidth_count_ {}; // rounds since then
+
+  bool restarting_ {}; // after a timeout, send one segment until an ACK arrives
+
+  uint64_t bandwidth() const { return bandwidth_.empty() ? 0 : bandwidth_.front().second; }
+  uint64_t bdp() const;
+};
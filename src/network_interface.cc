@@ -221,11 +221,26 @@ void NetworkInterface::recv_frame( const EthernetFrame& frame )
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void NetworkInterface::tick( const size_t ms_since_last_tick )
 {
-  erase_if( ARP_cache_, [&]( auto&& item ) noexcept -> bool {
-    return item.second.second.tick( ms_since_last_tick ).expired( ARP_ENTRY_TTL_ms );
-  } );
+  for ( auto it = ARP_cache_.begin(); it != ARP_cache_.end(); ) {
+    it = it->second.second.tick( ms_since_last_tick ).expired( ARP_ENTRY_TTL_ms ) ? ARP_cache_.erase( it )
+                                                                                   : next( it );
+  }
+
+  for ( auto it = waitting_timer_.begin(); it != waitting_timer_.end(); ) {
+    it = it->second.tick( ms_since_last_tick ).expired( ARP_RESPONSE_TTL_ms ) ? waitting_timer_.erase( it )
+                                                                               : next( it );
+  }
+}
 
-  erase_if( waitting_timer_, [&]( auto&& item ) noexcept -> bool {
-    return item.second.tick( ms_since_last_tick ).expired( ARP_RESPONSE_TTL_ms );
-  } );
+optional<size_t> NetworkInterface::ms_until_deadline() const
+{
+  optional<size_t> deadline;
+  auto consider = [&]( const size_t ms ) { deadline = min( deadline.value_or( ms ), ms ); };
+  for ( const auto& [ip, entry] : ARP_cache_ ) {
+    consider( entry.second.remaining( ARP_ENTRY_TTL_ms ) );
+  }
+  for ( const auto& [ip, timer] : waitting_timer_ ) {
+    consider( timer.remaining( ARP_RESPONSE_TTL_ms ) );
+  }
+  return deadline;
 }
\ No newline at end of file
@@ -105,6 +105,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <optional>
 #include <queue>
 #include <unordered_map>
 #include <utility>
@@ -163,6 +164,9 @@ public:
   // Called periodically when time elapses
   void tick( size_t ms_since_last_tick );
 
+  // How long until tick() next expires an ARP entry or pending request (none if there are neither)
+  std::optional<size_t> ms_until_deadline() const;
+
   // Accessors
   const std::string& name() const { return name_; }
   const OutputPort& output() const { return *port_; }
@@ -196,6 +200,10 @@ private:
     size_t _ms {};
     constexpr Timer& tick( const size_t& ms_since_last_tick ) noexcept { return _ms += ms_since_last_tick, *this; }
     [[nodiscard]] constexpr bool expired( const size_t& TTL_ms ) const noexcept { return _ms >= TTL_ms; }
+    [[nodiscard]] constexpr size_t remaining( const size_t& TTL_ms ) const noexcept
+    {
+      return expired( TTL_ms ) ? 0 : TTL_ms - _ms;
+    }
   };
 
   using AddressNumeric = decltype( ip_address_.ipv4_numeric() );
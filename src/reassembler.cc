@@ -1,52 +1,236 @@
 #include "reassembler.hh"
+#include "buffer_pool.hh"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <iterator>
 
 using namespace std;
 
+Reassembler::Reassembler( ByteStream&& output, Engine engine ) : output_( move( output ) ), engine_( engine )
+{
+  if ( engine_ == Engine::Bitmap ) {
+    // the window never spans more than the stream's capacity, so each index in it has its own ring slot
+    const uint64_t capacity = output_.writer().available_capacity() + output_.reader().bytes_buffered();
+    ring_.resize( capacity );
+    present_.resize( ( capacity + 63 ) / 64 );
+  }
+}
+
 void Reassembler::insert( uint64_t first_index, string data, bool is_last_substring )
 {
   if ( is_last_substring ) {
-    lastpos = first_index + data.size();
+    end_index_ = first_index + data.size();
   }
-  // exceed window size
-  if ( first_index >= need + output_.writer().available_capacity() || first_index + data.size() < need ) {
-    return;
+
+  // limit to the window: drop what was already written, and what lies beyond the available capacity
+  const uint64_t next_index = output_.writer().bytes_pushed();
+  const uint64_t window_end = next_index + output_.writer().available_capacity();
+  const uint64_t last_index = min( first_index + data.size(), window_end );
+  if ( first_index < next_index ) {
+    data.erase( 0, min( next_index - first_index, static_cast<uint64_t>( data.size() ) ) );
+    first_index = next_index;
   }
-  // limit left
-  if ( first_index < need ) {
-    data = data.substr( need - first_index );
-    first_index = need;
+  if ( first_index < last_index ) {
+    data.resize( last_index - first_index );
+    if ( first_index == next_index and bytes_pending_ == 0 ) {
+      output_.writer().push( move( data ) );
+    } else if ( engine_ == Engine::Map ) {
+      store( first_index, move( data ) );
+    } else {
+      fill( first_index, data );
+    }
   }
-  // limit right
-  data = data.substr( 0, min( need + output_.writer().available_capacity() - first_index, (uint64_t)data.size() ) );
-  //  put unique byte into vector
-  // while ( s.size() < first_index + data.size() ) {
-  //   s.emplace_back( val );
-  // }
-  for ( int i = s.size(), j = data.size() + first_index; i < j; i++ ) {
-    s.emplace_back( val );
+
+  if ( engine_ == Engine::Map ) {
+    flush_segments();
+  } else {
+    flush_ring();
   }
-  for ( auto& ch : data ) {
-    if ( s[first_index] == val ) {
-      s[first_index] = ch;
-      ++store;
+
+  if ( end_index_.has_value() and output_.writer().bytes_pushed() >= end_index_.value() ) {
+    output_.writer().close();
+  }
+
+  // unless it was passed on, the data has been copied or was not needed
+  BufferPool::recycle( move( data ) );
+}
+
+// Add a segment to `pending_`, keeping the stored segments non-overlapping.
+void Reassembler::store( uint64_t first_index, string data )
+{
+  const uint64_t last_index = first_index + data.size();
+  auto it = pending_.upper_bound( first_index );
+
+  // segment starting at or before this one: either it already covers this one, or trim its overlapping tail
+  if ( it != pending_.begin() ) {
+    auto& [prev_index, prev_data] = *prev( it );
+    const uint64_t prev_last = prev_index + prev_data.size();
+    if ( prev_last >= last_index ) {
+      return;
+    }
+    if ( prev_index == first_index ) {
+      bytes_pending_ -= prev_data.size();
+      pending_.erase( prev( it ) );
+    } else if ( prev_last > first_index ) {
+      bytes_pending_ -= prev_last - first_index;
+      prev_data.resize( first_index - prev_index );
     }
-    ++first_index;
   }
-  string buffer;
-  while ( need < s.size() && s[need] != val ) {
-    buffer += (char)s[need++];
-    --store;
+
+  // segments starting inside this one: drop those it covers, and trim this one where the next begins
+  while ( it != pending_.end() and it->first < last_index ) {
+    const uint64_t it_last = it->first + it->second.size();
+    if ( it_last > last_index ) {
+      data.resize( it->first - first_index );
+      break;
+    }
+    bytes_pending_ -= it->second.size();
+    it = pending_.erase( it );
   }
-  if ( !buffer.empty() ) {
-    output_.writer().push( buffer );
+
+  if ( not data.empty() ) {
+    bytes_pending_ += data.size();
+    pending_.emplace_hint( it, first_index, move( data ) );
   }
+}
 
-  if ( need >= lastpos ) {
-    output_.writer().close();
+// Write out every stored segment that is now contiguous with the stream.
+void Reassembler::flush_segments()
+{
+  while ( not pending_.empty() and pending_.begin()->first == output_.writer().bytes_pushed() ) {
+    auto segment = pending_.extract( pending_.begin() );
+    bytes_pending_ -= segment.mapped().size();
+    output_.writer().push( move( segment.mapped() ) );
   }
 }
 
+// Copy `data` into its ring slots and mark them present; bytes already there are identical, so overwriting is fine.
+void Reassembler::fill( uint64_t first_index, string_view data )
+{
+  const uint64_t pos = first_index % ring_.size();
+  const uint64_t head = min( static_cast<uint64_t>( data.size() ), ring_.size() - pos );
+  memcpy( ring_.data() + pos, data.data(), head );
+  memcpy( ring_.data(), data.data() + head, data.size() - head );
+  bytes_pending_ += mark_present( pos, data.size() );
+}
+
+// Write out the run of present bytes starting at the next needed index.
+void Reassembler::flush_ring()
+{
+  if ( bytes_pending_ == 0 ) {
+    return;
+  }
+  const uint64_t pos = output_.writer().bytes_pushed() % ring_.size();
+  const uint64_t len = present_run( pos, bytes_pending_ );
+  if ( len == 0 ) {
+    return;
+  }
+  const uint64_t head = min( len, ring_.size() - pos );
+  string data( len, 0 );
+  memcpy( data.data(), ring_.data() + pos, head );
+  memcpy( data.data() + head, ring_.data(), len - head );
+  clear_present( pos, len );
+  bytes_pending_ -= len;
+  output_.writer().push( move( data ) );
+}
+
+namespace {
+
+// Bits [first, last) of a word, for 0 <= first < last <= 64.
+uint64_t bit_range( uint64_t first, uint64_t last )
+{
+  const uint64_t upper = last == 64 ? ~uint64_t {} : ( uint64_t { 1 } << last ) - 1;
+  return upper & ~( ( uint64_t { 1 } << first ) - 1 );
+}
+
+// Apply `op( word, mask )` to every word of `bits` covering ring slots [pos, pos + len), wrapping at `size`.
+template<typename Op>
+void for_each_word( uint64_t pos, uint64_t len, uint64_t size, Op&& op )
+{
+  while ( len > 0 ) {
+    const uint64_t stop = min( pos + len, size );
+    for ( uint64_t i = pos; i < stop; ) {
+      const uint64_t word_end = min( ( i / 64 + 1 ) * 64, stop );
+      op( i / 64, bit_range( i % 64, word_end - ( i / 64 ) * 64 ) );
+      i = word_end;
+    }
+    len -= stop - pos;
+    pos = 0;
+  }
+}
+
+} // namespace
+
+// Mark ring slots [pos, pos + len) present, returning how many were not already.
+uint64_t Reassembler::mark_present( uint64_t pos, uint64_t len )
+{
+  uint64_t added = 0;
+  for_each_word( pos, len, ring_.size(), [&]( uint64_t word, uint64_t mask ) {
+    added += popcount( mask & ~present_[word] );
+    present_[word] |= mask;
+  } );
+  return added;
+}
+
+void Reassembler::clear_present( uint64_t pos, uint64_t len )
+{
+  for_each_word( pos, len, ring_.size(), [&]( uint64_t word, uint64_t mask ) { present_[word] &= ~mask; } );
+}
+
+// Length of the run of present (or, with `present` false, absent) slots starting at `pos` (wrapping), scanning at
+// most `max_len` slots.
+uint64_t Reassembler::present_run( uint64_t pos, uint64_t max_len, bool present ) const
+{
+  uint64_t len = 0;
+  while ( len < max_len ) {
+    const uint64_t in_word = min( 64 - pos % 64, ring_.size() - pos );
+    const uint64_t word = present ? present_[pos / 64] : ~present_[pos / 64];
+    const uint64_t ones = min( static_cast<uint64_t>( countr_one( word >> ( pos % 64 ) ) ), in_word );
+    len += ones;
+    if ( ones < in_word ) {
+      break;
+    }
+    pos = ( pos + ones ) % ring_.size();
+  }
+  return min( len, max_len );
+}
+
 uint64_t Reassembler::bytes_pending() const
 {
-  return store;
+  return bytes_pending_;
+}
+
+vector<pair<uint64_t, uint64_t>> Reassembler::pending_ranges() const
+{
+  vector<pair<uint64_t, uint64_t>> ranges;
+  const auto add = [&ranges]( uint64_t first, uint64_t last ) {
+    if ( not ranges.empty() and ranges.back().second == first ) {
+      ranges.back().second = last;
+    } else {
+      ranges.emplace_back( first, last );
+    }
+  };
+
+  if ( engine_ == Engine::Map ) {
+    for ( const auto& [first_index, data] : pending_ ) {
+      add( first_index, first_index + data.size() );
+    }
+    return ranges;
+  }
+
+  // Engine::Bitmap: alternate runs of absent and present slots until every pending byte is accounted for
+  uint64_t index = output_.writer().bytes_pushed();
+  const uint64_t window_end = index + output_.writer().available_capacity();
+  for ( uint64_t found = 0; found < bytes_pending_ and index < window_end; ) {
+    index += present_run( index % ring_.size(), window_end - index, false );
+    const uint64_t len = present_run( index % ring_.size(), window_end - index );
+    if ( len > 0 ) {
+      add( index, index + len );
+    }
+    index += len;
+    found += len;
+  }
+  return ranges;
 }
@@ -2,14 +2,23 @@
 
 #include "byte_stream.hh"
 #include <map>
+#include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
 class Reassembler
 {
 public:
+  // How bytes that arrive ahead of the next needed index are held until the gaps before them are filled
+  enum class Engine
+  {
+    Map,   // ordered map of non-overlapping segments; memory follows the bytes actually pending
+    Bitmap // circular buffer the size of the stream's capacity, plus a bitmap of which bytes are present
+  };
+
   // Construct Reassembler to write into given ByteStream.
-  explicit Reassembler( ByteStream&& output ) : output_( std::move( output ) ) {}
+  explicit Reassembler( ByteStream&& output, Engine engine = Engine::Map );
 
   /*
    * Insert a new substring to be reassembled into a ByteStream.
@@ -36,6 +45,11 @@ public:
   // How many bytes are stored in the Reassembler itself?
   uint64_t bytes_pending() const;
 
+  // The ranges [first, last) of stream indexes stored in the Reassembler, in order (adjacent ones merged)
+  std::vector<std::pair<uint64_t, uint64_t>> pending_ranges() const;
+
+  Engine engine() const { return engine_; }
+
   // Access output stream reader
   Reader& reader() { return output_.reader(); }
   const Reader& reader() const { return output_.reader(); }
@@ -45,7 +59,22 @@ public:
 
 private:
   ByteStream output_; // the Reassembler writes to this ByteStream
-  const int val = 114514;
-  std::vector<int> s {};
-  uint64_t need = 0, lastpos = -1, store = 0;
+  Engine engine_;
+  uint64_t bytes_pending_ {};
+  std::optional<uint64_t> end_index_ {}; // index just past the last byte of the stream, once known
+
+  // Engine::Map: pending bytes as non-overlapping segments keyed by first index.
+  // Every segment lies inside the window [bytes_pushed, bytes_pushed + available_capacity).
+  std::map<uint64_t, std::string> pending_ {};
+  void store( uint64_t first_index, std::string data );
+  void flush_segments();
+
+  // Engine::Bitmap: stream index i lives at ring_[i % ring_.size()], and is present iff its bit is set.
+  std::string ring_ {};
+  std::vector<uint64_t> present_ {};
+  void fill( uint64_t first_index, std::string_view data );
+  void flush_ring();
+  uint64_t mark_present( uint64_t pos, uint64_t len );
+  void clear_present( uint64_t pos, uint64_t len );
+  uint64_t present_run( uint64_t pos, uint64_t max_len, bool present = true ) const;
 };
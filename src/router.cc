@@ -44,8 +44,7 @@ void Router::route()
       if ( dgram.header.ttl <=1 || max_len==-1 ) {
         continue;
       }
-      --dgram.header.ttl;
-      dgram.header.compute_checksum();
+      dgram.header.set_ttl( dgram.header.ttl - 1 );
       auto send_inter = interface( static_cast<size_t>( match_vec[pos].interface_num ) );
       // send_inter->send_datagram( dgram, Address::from_ipv4_numeric( dst_ip ) );
       send_inter->send_datagram( dgram, match_vec[pos].next_hop.value_or(Address::from_ipv4_numeric( dst_ip )) );
@@ -0,0 +1,144 @@
+#include "sharded_tcp_stack.hh"
+
+#include "exception.hh"
+
+#include <stdexcept>
+#include <utility>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+//! A sleeping worker checks for stop() at least this often
+constexpr int STOP_CHECK_MS = 100;
+
+const string EVENTFD_ONE { "\1\0\0\0\0\0\0\0", sizeof( uint64_t ) };
+
+FileDescriptor make_eventfd()
+{
+  return FileDescriptor { CheckSystemCall( "eventfd", ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) ) };
+}
+
+// A file descriptor of the worker's own for the device (FileDescriptor::duplicate would share one between threads)
+TCPOverIPv4OverTunFdAdapter own_adapter( TCPOverIPv4OverTunFdAdapter& adapter )
+{
+  const int fd = CheckSystemCall( "dup", ::dup( static_cast<TunFD&>( adapter ).fd_num() ) );
+  return TCPOverIPv4OverTunFdAdapter { TunFD { FileDescriptor { fd } } };
+}
+
+} // namespace
+
+ShardedTCPStack::Shard::Shard( TCPOverIPv4OverTunFdAdapter&& adapter,
+                               const Address& local_address,
+                               const TCPConfig& config,
+                               TCPStack::FlowOwner owner )
+  : stack( move( adapter ), local_address, config, move( owner ) ), wakeup( make_eventfd() )
+{}
+
+ShardedTCPStack::ShardedTCPStack( TunFD&& tun,
+                                  const Address& local_address,
+                                  size_t num_shards,
+                                  const TCPConfig& config )
+  : _reader( move( tun ) ), _reader_wakeup( make_eventfd() )
+{
+  if ( num_shards == 0 ) {
+    throw runtime_error( "ShardedTCPStack needs at least one shard" );
+  }
+
+  for ( size_t i = 0; i < _indirection.size(); ++i ) {
+    _indirection[i] = i % num_shards;
+  }
+
+  for ( size_t i = 0; i < num_shards; ++i ) {
+    _shards.push_back( make_unique<Shard>(
+      own_adapter( _reader ), local_address, config, [this, i]( const FourTuple& flow ) {
+        return shard_of( flow ) == i;
+      } ) );
+  }
+}
+
+void ShardedTCPStack::listen( uint16_t port )
+{
+  for ( const auto& shard : _shards ) {
+    shard->stack.listen( port );
+  }
+}
+
+void ShardedTCPStack::start( ServeFunction serve )
+{
+  if ( _reader_thread.joinable() ) {
+    throw runtime_error( "ShardedTCPStack already started" );
+  }
+
+  for ( const auto& shard : _shards ) {
+    Shard& s = *shard;
+    s.stack.eventloop().add_rule(
+      "shard wakeup", s.wakeup, Direction::In, [&s] { s.wakeup.read( s.wakeup_buffer ); } );
+    s.thread = thread( [this, &s, serve] { serve_loop( s, serve ); } );
+  }
+  _reader_thread = thread( [this] { read_loop(); } );
+}
+
+void ShardedTCPStack::stop()
+{
+  _stopping = true;
+  if ( _reader_thread.joinable() ) {
+    _reader_wakeup.write( EVENTFD_ONE );
+    _reader_thread.join();
+  }
+  for ( const auto& shard : _shards ) {
+    if ( shard->thread.joinable() ) {
+      shard->wakeup.write( EVENTFD_ONE );
+      shard->thread.join();
+    }
+  }
+}
+
+void ShardedTCPStack::read_loop()
+{
+  EventLoop loop;
+  loop.add_rule( "TUN read", static_cast<TunFD&>( _reader ), Direction::In, [this] {
+    FourTuple flow;
+    auto msg = _reader.read( flow );
+    if ( not msg.has_value() ) {
+      return;
+    }
+
+    Shard& shard = *_shards[shard_of( flow )];
+    if ( not shard.ring.push( { flow, move( msg.value() ) } ) ) {
+      _dropped.fetch_add( 1, memory_order_relaxed ); // like a network card whose receive ring is full
+      return;
+    }
+
+    // pairs with the fence in serve_loop: either the worker sees the new segment, or we see that it may sleep
+    atomic_thread_fence( memory_order_seq_cst );
+    if ( shard.sleeping.exchange( false ) ) {
+      shard.wakeup.write( EVENTFD_ONE );
+    }
+  } );
+  loop.add_rule( "stop", _reader_wakeup, Direction::In, [this] { _reader_wakeup.read( _reader_wakeup_buffer ); } );
+
+  while ( not _stopping ) {
+    loop.wait_next_event( -1 );
+  }
+}
+
+void ShardedTCPStack::serve_loop( Shard& shard, const ServeFunction& serve )
+{
+  Inbound inbound;
+  while ( not _stopping ) {
+    while ( shard.ring.pop( inbound ) ) {
+      shard.stack.receive( inbound.flow, move( inbound.msg ) );
+    }
+    serve( shard.stack );
+
+    // announce that we may sleep, then look at the ring once more in case the reader missed the announcement
+    shard.sleeping = true;
+    atomic_thread_fence( memory_order_seq_cst );
+    shard.stack.wait_next_event( shard.ring.empty() ? STOP_CHECK_MS : 0 );
+    shard.sleeping = false;
+  }
+}
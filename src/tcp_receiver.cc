@@ -1,5 +1,7 @@
 #include "tcp_receiver.hh"
 
+#include <algorithm>
+
 using namespace std;
 
 void TCPReceiver::receive( TCPSenderMessage message )
@@ -11,23 +13,64 @@ void TCPReceiver::receive( TCPSenderMessage message )
   if ( !have_SYN && message.SYN ) {
     zero_point = message.seqno;
     have_SYN = true;
+    peer_sack_permitted_ = message.SACK_permitted;
+    if ( window_scale_ && message.window_scale ) {
+      window_shift_ = window_scale_.value();
+    }
   }
   if ( !have_SYN )
     return;
   uint64_t check_point = reassembler_.writer().bytes_pushed();
   uint64_t first_index = message.seqno.unwrap( zero_point, check_point );
-  if ( message.SYN ) {
-    reassembler_.insert( first_index, message.payload, message.FIN );
-  } else {
-    reassembler_.insert( first_index - 1, message.payload, message.FIN );
+  if ( !message.SYN ) {
+    first_index -= 1;
+  }
+  const uint64_t last_index = first_index + message.payload.size();
+  if ( message.FIN ) {
+    fin_index_ = last_index;
   }
+  reassembler_.insert( first_index, move( message.payload ), message.FIN );
   next_connect = Wrap32::wrap( reassembler_.writer().bytes_pushed() + have_SYN + reassembler_.writer().is_closed(),
                                zero_point );
+  if ( sack_ && peer_sack_permitted_ ) {
+    update_sack_blocks( last_index );
+  }
+}
+
+// 未按序到达的数据：每段连续的数据一个SACK块，最多四个；包含最新到达报文的那块排在最前（RFC 2018），
+// 其余按序号排列。流的结尾若已收到，块的右端也算上FIN
+void TCPReceiver::update_sack_blocks( uint64_t last_index )
+{
+  sack_blocks_.clear();
+  if ( reassembler_.bytes_pending() == 0 ) {
+    return;
+  }
+
+  const auto ranges = reassembler_.pending_ranges();
+  const auto newest = find_if( ranges.begin(), ranges.end(), [&]( const auto& range ) {
+    return range.first < last_index && last_index <= range.second;
+  } );
+  const auto add = [&]( const pair<uint64_t, uint64_t>& range ) {
+    if ( sack_blocks_.size() < TCPReceiverMessage::MAX_SACK_BLOCKS ) {
+      const bool fin = range.second == fin_index_;
+      sack_blocks_.push_back(
+        { Wrap32::wrap( range.first + 1, zero_point ), Wrap32::wrap( range.second + 1 + fin, zero_point ) } );
+    }
+  };
+  if ( newest != ranges.end() ) {
+    add( *newest );
+  }
+  for ( auto it = ranges.begin(); it != ranges.end(); ++it ) {
+    if ( it != newest ) {
+      add( *it );
+    }
+  }
 }
 
-TCPReceiverMessage TCPReceiver::send() const
+// 双方的SYN都带了窗口扩大选项时，SYN之后通告的窗口右移window_shift_位（向下取整，不会多通告）
+TCPReceiverMessage TCPReceiver::send( bool SYN ) const
 {
-  uint64_t actually_capacity = reassembler_.writer().available_capacity();
+  uint64_t actually_capacity = reassembler_.writer().available_capacity() >> ( SYN ? 0 : window_shift_ );
   uint16_t window_size = actually_capacity <= UINT16_MAX ? actually_capacity : UINT16_MAX;
-  return { next_connect, window_size, reassembler_.reader().has_error() };
+  return { next_connect, window_size, reassembler_.reader().has_error(), sack_blocks_ };
 }
@@ -7,8 +7,13 @@
 class TCPReceiver
 {
 public:
-  // Construct with given Reassembler
-  explicit TCPReceiver( Reassembler&& reassembler ) : reassembler_( std::move( reassembler ) ) {}
+  // Construct with given Reassembler, whether to send SACK blocks (once the peer's SYN permits them), and the
+  // window-scale shift our SYN offers (applied to the windows advertised once the peer's SYN offers one too)
+  explicit TCPReceiver( Reassembler&& reassembler,
+                        bool sack = false,
+                        std::optional<uint8_t> window_scale = {} )
+    : reassembler_( std::move( reassembler ) ), sack_( sack ), window_scale_( window_scale )
+  {}
 
   /*
    * The TCPReceiver receives TCPSenderMessages, inserting their payload into the Reassembler
@@ -16,8 +21,11 @@ public:
    */
   void receive( TCPSenderMessage message );
 
-  // The TCPReceiver sends TCPReceiverMessages to the peer's TCPSender.
-  TCPReceiverMessage send() const;
+  // The TCPReceiver sends TCPReceiverMessages to the peer's TCPSender (in a SYN, with the window unscaled).
+  TCPReceiverMessage send( bool SYN = false ) const;
+
+  // How many bits the windows advertised (after the SYNs) are shifted right by
+  uint8_t window_shift() const { return window_shift_; }
 
   // Access the output (only Reader is accessible non-const)
   const Reassembler& reassembler() const { return reassembler_; }
@@ -30,4 +38,15 @@ private:
   bool have_SYN {};
   Wrap32 zero_point { 0 };
   std::optional<Wrap32> next_connect {};
+
+  // SACK blocks for the data held beyond the ackno (when both sides permit them), kept up to date by receive()
+  bool sack_;
+  bool peer_sack_permitted_ {};
+  std::optional<uint64_t> fin_index_ {}; // stream index of the FIN, once it has arrived
+  std::vector<SACKBlock> sack_blocks_ {};
+  void update_sack_blocks( uint64_t last_index );
+
+  // window scaling (RFC 7323)
+  std::optional<uint8_t> window_scale_;
+  uint8_t window_shift_ {};
 };
@@ -1,8 +1,16 @@
 #include "tcp_sender.hh"
 #include "tcp_config.hh"
 
+#include <algorithm>
+#include <cmath>
+
 using namespace std;
 
+namespace {
+// how much sending the pacing rate lets build up while there is nothing to send
+constexpr double PACING_BURST = 4 * TCPConfig::MAX_PAYLOAD_SIZE;
+} // namespace
+
 uint64_t TCPSender::sequence_numbers_in_flight() const
 {
   return sequence_numbers_in_flight_;
@@ -13,78 +21,176 @@ uint64_t TCPSender::consecutive_retransmissions() const
   return my_timer.peek_count();
 }
 
+optional<uint64_t> TCPSender::ms_until_deadline() const
+{
+  // tick() only retransmits while something is outstanding
+  optional<uint64_t> deadline;
+  if ( not my_sender_queue.empty() and my_timer.is_running() ) {
+    deadline = my_timer.time_left();
+  }
+
+  // ... and sends more when the pacing rate allows it
+  const auto rate = pacing_rate();
+  if ( rate.has_value() and pacing_credit_ < 0 and reader().bytes_buffered() ) {
+    const auto wait = static_cast<uint64_t>( ceil( -pacing_credit_ * 1000 / static_cast<double>( rate.value() ) ) );
+    deadline = min( deadline.value_or( UINT64_MAX ), max<uint64_t>( wait, 1 ) );
+  }
+  return deadline;
+}
+
+uint64_t TCPSender::congestion_window() const
+{
+  if ( not congestion_control_ ) {
+    return UINT64_MAX;
+  }
+  // in whole segments, so that the window never has room for just a sliver of one
+  const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+  return max( congestion_control_->window() / mss, uint64_t { 1 } ) * mss
+         + ( in_recovery_ ? recovery_inflation_ : 0 );
+}
+
+optional<double> TCPSender::smoothed_rtt() const
+{
+  return rtt_.smoothed_rtt();
+}
+
+uint64_t TCPSender::retransmission_timeout() const
+{
+  return my_timer.get_current_RTO() ? my_timer.get_current_RTO() : RTO_after_ack();
+}
+
+optional<uint64_t> TCPSender::pacing_rate() const
+{
+  if ( not congestion_control_ ) {
+    return {};
+  }
+  const auto rate = congestion_control_->pacing_rate();
+  return rate.value_or( 0 ) > 0 ? rate : nullopt;
+}
+
 void TCPSender::push( const TransmitFunction& transmit )
 {
+  // 快速重传（三个重复ACK，或恢复期间的部分确认）：先重传最早未确认的报文，不受窗口限制；
+  // 有SACK时再重传SACK块之间的空洞，每个空洞在一次恢复中只重传一次
+  if ( retransmit_pending_ ) {
+    retransmit_pending_ = false;
+    bool retransmitted = false;
+    for ( auto& segment : my_sender_queue ) {
+      const uint64_t start = segment.message.seqno.unwrap( isn_, abs_acked_num );
+      const uint64_t end = start + segment.message.sequence_length();
+      if ( &segment != &my_sender_queue.front() && end > high_sacked_ ) {
+        break;
+      }
+      if ( segment.sacked || start < high_rxt_ ) {
+        continue;
+      }
+      transmit( segment.message );
+      segment.retransmitted = true;
+      high_rxt_ = end;
+      retransmitted = true;
+    }
+    if ( retransmitted ) {
+      my_timer.state_reset( retransmission_timeout() );
+    }
+  }
+
   // 1.达到最大传输字节数（窗口大小）
   // 2.仅传输中的序列号没了且window_size=0才需要发送假消息，如果还有序列号才传输中，可以利用这些得到ack更新size（传输失败就重传）
-  if ( ( report_window_size && sequence_numbers_in_flight_ >= report_window_size )
-       || ( report_window_size == 0 && sequence_numbers_in_flight_ >= 1 ) ) {
+  // 发送窗口取接收方窗口和拥塞窗口中较小者
+  const uint64_t window = report_window_size == 0 ? 0 : min<uint64_t>( report_window_size, congestion_window() );
+  if ( ( window && sequence_numbers_in_flight_ >= window )
+       || ( window == 0 && sequence_numbers_in_flight_ >= 1 ) ) {
     return;
   }
+  const bool paced = pacing_rate().has_value();
 
   auto seqno = Wrap32::wrap( abs_sender_num, isn_ );
 
   // 限制从buffer中取出来的字节数
-  auto win = report_window_size == 0
-               ? 1
-               : report_window_size - sequence_numbers_in_flight_ - static_cast<uint16_t>( seqno == isn_ );
+  auto win = window == 0 ? 1 : window - sequence_numbers_in_flight_ - static_cast<uint16_t>( seqno == isn_ );
 
-  string out;
-  while ( reader().bytes_buffered() and static_cast<uint16_t>( out.size() ) < win ) {
-    auto view = reader().peek();
+  // 按报文逐段从buffer中取出payload（Chunked模式下整块move，不拷贝）
+  auto sendable = [&] { return min( reader().bytes_buffered(), win ); };
 
-    if ( view.empty() ) {
-      throw std::runtime_error( "Reader::peek() returned empty string_view" );
+  while ( sendable() || seqno == isn_ || ( !FIN_ && writer().is_closed() ) ) {
+    // 按发送速率限制时，额度用完就等tick()补充
+    if ( paced && pacing_credit_ < 0 ) {
+      break;
     }
 
-    view = view.substr( 0, win - out.size() ); // Don't return more bytes than desired.
-    out += view;
-    input_.reader().pop( view.size() );
-  }
-
-  size_t len;
-  string_view view( out );
-
-  while ( !view.empty() || seqno == isn_ || ( !FIN_ && writer().is_closed() ) ) {
-    len = min( view.size(), TCPConfig::MAX_PAYLOAD_SIZE );
-
-    string payload( view.substr( 0, len ) );
+    string payload;
+    read( input_.reader(), min( sendable(), TCPConfig::MAX_PAYLOAD_SIZE ), payload );
+    win -= payload.size();
+    const bool last = sendable() == 0;
 
     TCPSenderMessage message { seqno, seqno == isn_, move( payload ), false, writer().has_error() };
+    message.SACK_permitted = sack_ && message.SYN;
+    message.window_scale = message.SYN ? window_scale_ : nullopt;
 
     // 1.当前窗口大小限制携带不了FIN，留着以后发，没有新的消息了直接退出，否则携带
     // 2.zero窗口仅当message为0时才能携带（因为视为窗口大小为1）
-    if ( !FIN_ && writer().is_closed() && len == view.size()
-         && ( sequence_numbers_in_flight_ + message.sequence_length() < report_window_size
-              || ( report_window_size == 0 && message.sequence_length() == 0 ) ) ) {
+    if ( !FIN_ && writer().is_closed() && last
+         && ( sequence_numbers_in_flight_ + message.sequence_length() < window
+              || ( window == 0 && message.sequence_length() == 0 ) ) ) {
       FIN_ = message.FIN = true;
     }
 
     transmit( message );
     if ( !my_timer.is_running() && message.sequence_length() ) {
-      auto RTO = my_timer.get_current_RTO() ? my_timer.get_current_RTO() : initial_RTO_ms_;
-      my_timer.state_reset( RTO );
+      my_timer.state_reset( retransmission_timeout() );
     }
     abs_sender_num += message.sequence_length();
     sequence_numbers_in_flight_ += message.sequence_length();
-    my_sender_queue.emplace( move( message ) );
+    if ( paced ) {
+      pacing_credit_ -= static_cast<double>( message.sequence_length() );
+    }
+    my_sender_queue.push_back(
+      { move( message ), now_ms_, delivered_, delivered_at_, first_sent_at_, false, false } );
 
     // 当前窗口大小限制携带不了FIN，留着以后发，没有新的消息了直接退出
-    if ( !FIN_ && writer().is_closed() && len == view.size() ) {
+    if ( !FIN_ && writer().is_closed() && last ) {
       break;
     }
 
     seqno = Wrap32::wrap( abs_sender_num, isn_ );
-    view.remove_prefix( len );
   }
 }
 
+// 记下SACK块确认收到的报文（只认整段落在块内的），和SACK过的最高序号
+void TCPSender::record_sack_blocks( const TCPReceiverMessage& msg )
+{
+  for ( const auto& block : msg.sack ) {
+    const uint64_t left = block.left.unwrap( isn_, abs_acked_num );
+    const uint64_t right = block.right.unwrap( isn_, abs_acked_num );
+    if ( left >= right || left < abs_acked_num || right > abs_sender_num ) {
+      continue;
+    }
+    high_sacked_ = max( high_sacked_, right );
+    for ( auto& segment : my_sender_queue ) {
+      const uint64_t start = segment.message.seqno.unwrap( isn_, abs_acked_num );
+      if ( start >= right ) {
+        break;
+      }
+      segment.sacked |= start >= left && start + segment.message.sequence_length() <= right;
+    }
+  }
+}
+
+// 对方的SYN到了：双方都提出窗口扩大时才生效（最多14位）；对方没提出，SYN-ACK上也就不再提
+void TCPSender::set_peer_window_scale( optional<uint8_t> shift )
+{
+  if ( !shift ) {
+    window_scale_.reset();
+  }
+  peer_window_shift_ = window_scale_ ? min( shift.value(), TCPConfig::MAX_WINDOW_SCALE ) : 0;
+}
+
 TCPSenderMessage TCPSender::make_empty_message() const
 {
   return { Wrap32::wrap( abs_sender_num, isn_ ), false, "", false, writer().has_error() };
 }
 
-void TCPSender::receive( const TCPReceiverMessage& msg )
+void TCPSender::receive( const TCPReceiverMessage& msg, bool with_data )
 {
   if ( msg.RST ) {
     writer().set_error();
@@ -92,40 +198,135 @@ void TCPSender::receive( const TCPReceiverMessage& msg )
   }
 
   // treat a '0' window size as equal to '1' but don't back off RTO
-  report_window_size = msg.window_size;
+  const uint64_t window_size = uint64_t { msg.window_size } << peer_window_shift_;
+  const bool same_window = window_size == report_window_size;
+  report_window_size = window_size;
   uint64_t abs_seq_k = msg.ackno ? msg.ackno.value().unwrap( isn_, abs_acked_num ) : 0;
+  if ( sack_ && !msg.sack.empty() ) {
+    record_sack_blocks( msg );
+  }
+
+  // 重复ACK：没有确认新数据、窗口也没变，而还有数据在途；携带数据（或SYN、FIN）的报文不算（RFC 5681），
+  // 也不打断计数
+  if ( fast_retransmit_ && msg.ackno && abs_seq_k == abs_acked_num && same_window
+       && sequence_numbers_in_flight_ > 0 ) {
+    if ( with_data ) {
+      return;
+    }
+    ++duplicate_acks_;
+    if ( in_recovery_ ) {
+      // 每个重复ACK说明又有一个报文离开了网络，可以再发一个；它的SACK块也可能揭示了新的空洞
+      recovery_inflation_ += TCPConfig::MAX_PAYLOAD_SIZE;
+      retransmit_pending_ |= sack_;
+    } else if ( duplicate_acks_ == DUPLICATE_ACK_THRESHOLD && abs_acked_num > recover_ ) {
+      in_recovery_ = true;
+      recover_ = abs_sender_num;
+      high_rxt_ = abs_acked_num;
+      recovery_inflation_ = DUPLICATE_ACK_THRESHOLD * TCPConfig::MAX_PAYLOAD_SIZE;
+      retransmit_pending_ = true;
+      if ( congestion_control_ ) {
+        congestion_control_->on_fast_retransmit( now_ms_, sequence_numbers_in_flight_ );
+      }
+    }
+    return;
+  }
+  duplicate_acks_ = 0;
 
   if ( abs_seq_k > abs_acked_num && abs_seq_k <= abs_sender_num ) {
+    AckSample sample { .now_ms = now_ms_, .bytes_acked = abs_seq_k - abs_acked_num, .in_recovery = in_recovery_ };
     abs_acked_num = abs_seq_k;
+    delivered_ += sample.bytes_acked;
 
-    my_timer.state_reset( initial_RTO_ms_ );
     my_timer.clear_count();
 
-    uint64_t abs_seq = 0;
-    while ( !my_sender_queue.empty() && abs_seq <= abs_seq_k ) {
-      abs_seq
-        = my_sender_queue.front().seqno.unwrap( isn_, abs_acked_num ) + my_sender_queue.front().sequence_length();
-      if ( abs_seq <= abs_seq_k ) {
-        sequence_numbers_in_flight_ -= my_sender_queue.front().sequence_length();
-        my_sender_queue.pop();
+    // 弹出已被完全确认的报文；最后一个（最新的）给出RTT和交付速率样本
+    // （Karn算法：这个ACK确认了任何重传过的报文，就没有RTT样本；
+    //  速率按发送和确认两段间隔中较长者计算，以免ACK扎堆到达时高估）
+    bool retransmitted = false;
+    while ( !my_sender_queue.empty() ) {
+      const auto& front = my_sender_queue.front();
+      if ( front.message.seqno.unwrap( isn_, abs_acked_num ) + front.message.sequence_length() > abs_seq_k ) {
+        break;
       }
+      retransmitted |= front.retransmitted;
+      sample.rtt_ms = retransmitted ? nullopt : optional { now_ms_ - front.sent_at };
+      const uint64_t interval = max( now_ms_ - front.delivered_at, front.sent_at - front.first_sent_at );
+      sample.delivery_rate
+        = interval > 0 ? optional { ( delivered_ - front.delivered ) * 1000 / interval } : nullopt;
+      first_sent_at_ = front.sent_at;
+      sequence_numbers_in_flight_ -= front.message.sequence_length();
+      my_sender_queue.pop_front();
+    }
+    delivered_at_ = now_ms_;
+
+    // 有RTT样本才更新估计，再以估计出的RTO重启计时器；没有样本（Karn算法丢弃了它）时保留退避后的RTO，
+    // 直到有新样本为止（RFC 6298 5.7），否则RTT真的变长时会一直用过短的RTO超时
+    if ( sample.rtt_ms.has_value() ) {
+      rtt_.add_sample( sample.rtt_ms.value() );
+    }
+    const bool keep_backoff = adaptive_RTO_ and not sample.rtt_ms.has_value();
+    my_timer.state_reset( keep_backoff ? my_timer.get_current_RTO() : RTO_after_ack() );
+
+    // 部分确认（快速重传或超时之后，还没确认到当时发出的全部数据）说明下一个报文也丢了，
+    // 立即重传它（NewReno），并按确认的数据量收回窗口的膨胀部分；全部确认则结束恢复
+    if ( abs_seq_k < recover_ ) {
+      retransmit_pending_ = true;
+      if ( in_recovery_ ) {
+        recovery_inflation_ -= min( recovery_inflation_, sample.bytes_acked );
+        recovery_inflation_ += TCPConfig::MAX_PAYLOAD_SIZE;
+      }
+    } else if ( in_recovery_ ) {
+      in_recovery_ = false;
+      recovery_inflation_ = 0;
+    }
+
+    if ( congestion_control_ ) {
+      sample.bytes_in_flight = sequence_numbers_in_flight_;
+      congestion_control_->on_ack( sample );
     }
   }
 }
 
 void TCPSender::tick( uint64_t ms_since_last_tick, const TransmitFunction& transmit )
 {
+  now_ms_ += ms_since_last_tick;
+
   // timer stopped when queue is empty
   if ( !my_sender_queue.empty() ) {
     // 如果在重传之前收到ack并且队列为空，则不需要重传了，此时timer相关信息已经清0
     if ( my_timer.check_out_of_date( ms_since_last_tick ) ) {
-      transmit( my_sender_queue.front() );
+      transmit( my_sender_queue.front().message );
+      my_sender_queue.front().retransmitted = true;
       if ( report_window_size > 0 ) {
         my_timer.add_count();
-        my_timer.state_reset( 2 * my_timer.get_current_RTO() );
-        return;
+        const uint64_t RTO = my_timer.get_current_RTO();
+        my_timer.state_reset( adaptive_RTO_ ? rtt_.backoff( RTO ) : 2 * RTO );
+        if ( congestion_control_ ) {
+          congestion_control_->on_timeout( now_ms_, sequence_numbers_in_flight_ );
+        }
+        // 接收方可能丢掉了SACK过的数据（RFC 2018 第8节）：超时后不再相信SACK块，之后的重传要包括这些报文
+        for ( auto& segment : my_sender_queue ) {
+          segment.sacked = false;
+        }
+        high_sacked_ = abs_acked_num;
+        // 超时后此前发出的数据都可能丢了：逐个部分确认重传，不再等三个重复ACK
+        if ( fast_retransmit_ ) {
+          in_recovery_ = false;
+          recovery_inflation_ = 0;
+          recover_ = abs_sender_num;
+          duplicate_acks_ = 0;
+          high_rxt_ = abs_acked_num + my_sender_queue.front().message.sequence_length();
+        }
+      } else {
+        my_timer.state_reset( my_timer.get_current_RTO() );
       }
-      my_timer.state_reset( my_timer.get_current_RTO() );
     }
   }
+
+  // 按速率发送：补充额度（空闲时最多攒下一小段突发），再发出额度允许的数据
+  if ( const auto rate = pacing_rate() ) {
+    const double earned = static_cast<double>( rate.value() * ms_since_last_tick ) / 1000;
+    pacing_credit_ = min( pacing_credit_ + earned, max( earned, PACING_BURST ) );
+    push( transmit );
+  }
 }
\ No newline at end of file
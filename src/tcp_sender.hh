@@ -1,30 +1,63 @@
 #pragma once
 
 #include "byte_stream.hh"
+#include "congestion_control.hh"
 #include "tcp_receiver_message.hh"
 #include "tcp_sender_message.hh"
 #include "timer.hh"
 
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <list>
 #include <memory>
 #include <optional>
-#include <queue>
 
 class TCPSender
 {
 public:
-  /* Construct TCP sender with given default Retransmission Timeout and possible ISN */
-  TCPSender( ByteStream&& input, Wrap32 isn, uint64_t initial_RTO_ms )
-    : input_( std::move( input ) ), isn_( isn ), initial_RTO_ms_( initial_RTO_ms )
+  /* Bounds for a Retransmission Timeout estimated from measured round-trip times */
+  struct RTOBounds
+  {
+    uint64_t min_ms;
+    uint64_t max_ms;
+  };
+
+  /* Construct TCP sender with given default Retransmission Timeout and possible ISN, and optionally a congestion
+     controller (without one, the sender sends whatever the receiver's window allows) and bounds for adapting the
+     RTO to the measured RTT (without them, every new ACK resets the RTO to its initial value), whether to
+     retransmit after three duplicate ACKs (and recover from that as NewReno does), whether to permit SACK on the
+     SYN (and, recovering, retransmit only the holes the receiver's SACK blocks reveal), and the window-scale
+     shift to offer on the SYN (for the windows our own receiver advertises) */
+  TCPSender( ByteStream&& input,
+             Wrap32 isn,
+             uint64_t initial_RTO_ms,
+             std::unique_ptr<CongestionControl> congestion_control = {},
+             std::optional<RTOBounds> adaptive_RTO = {},
+             bool fast_retransmit = false,
+             bool sack = false,
+             std::optional<uint8_t> window_scale = {} )
+    : input_( std::move( input ) )
+    , isn_( isn )
+    , initial_RTO_ms_( initial_RTO_ms )
+    , congestion_control_( std::move( congestion_control ) )
+    , adaptive_RTO_( adaptive_RTO.has_value() )
+    , rtt_( adaptive_RTO.value_or( RTOBounds { 0, UINT64_MAX } ).min_ms,
+            adaptive_RTO.value_or( RTOBounds { 0, UINT64_MAX } ).max_ms )
+    , fast_retransmit_( fast_retransmit )
+    , sack_( sack )
+    , window_scale_( window_scale )
   {}
 
   /* Generate an empty TCPSenderMessage */
   TCPSenderMessage make_empty_message() const;
 
-  /* Receive and process a TCPReceiverMessage from the peer's receiver */
-  void receive( const TCPReceiverMessage& msg );
+  /* Receive and process a TCPReceiverMessage from the peer's receiver (`with_data`: the segment carrying it also
+     occupied sequence numbers, so it cannot be a duplicate ACK) */
+  void receive( const TCPReceiverMessage& msg, bool with_data = false );
+
+  /* The peer's SYN arrived, offering to shift the windows it advertises after it by `shift` bits (if at all) */
+  void set_peer_window_scale( std::optional<uint8_t> shift );
 
   /* Type of the `transmit` function that the push and tick methods can use to send messages */
   using TransmitFunction = std::function<void( const TCPSenderMessage& )>;
@@ -36,8 +69,12 @@ public:
   void tick( uint64_t ms_since_last_tick, const TransmitFunction& transmit );
 
   // Accessors
-  uint64_t sequence_numbers_in_flight() const;  // How many sequence numbers are outstanding?
-  uint64_t consecutive_retransmissions() const; // How many consecutive *re*transmissions have happened?
+  uint64_t sequence_numbers_in_flight() const;       // How many sequence numbers are outstanding?
+  uint64_t consecutive_retransmissions() const;      // How many consecutive *re*transmissions have happened?
+  std::optional<uint64_t> ms_until_deadline() const; // How long until tick() retransmits or paces out more data
+  uint64_t congestion_window() const;                // How many sequence numbers congestion control allows out
+  std::optional<double> smoothed_rtt() const;        // The RTT estimate, in ms (none before the first sample)
+  uint64_t retransmission_timeout() const;           // The RTO the timer runs with now (including any backoff)
   Writer& writer() { return input_.writer(); }
   const Writer& writer() const { return input_.writer(); }
 
@@ -49,11 +86,58 @@ private:
   ByteStream input_;
   Wrap32 isn_;
   uint64_t initial_RTO_ms_;
-  uint16_t report_window_size { 1 };
+  uint64_t report_window_size { 1 };
   uint64_t abs_acked_num {};
   uint64_t abs_sender_num {};
   uint64_t sequence_numbers_in_flight_ {};
   timer_state my_timer {};
-  std::queue<TCPSenderMessage> my_sender_queue {};
+
+  // an outstanding segment, with what congestion control needs to know when it is acknowledged
+  struct OutstandingSegment
+  {
+    TCPSenderMessage message;
+    uint64_t sent_at;       // when it was (first) sent
+    uint64_t delivered;     // sequence numbers acknowledged by then
+    uint64_t delivered_at;  // when those had been acknowledged
+    uint64_t first_sent_at; // when the newest segment acknowledged by then had been sent
+    bool retransmitted;
+    bool sacked; // the receiver holds it (says a SACK block), though not everything before it
+  };
+  std::deque<OutstandingSegment> my_sender_queue {};
   bool FIN_ {};
+
+  std::unique_ptr<CongestionControl> congestion_control_;
+  uint64_t now_ms_ {};        // time passed to tick() so far
+  uint64_t delivered_ {};     // sequence numbers acknowledged so far
+  uint64_t delivered_at_ {};  // when delivered_ last grew
+  uint64_t first_sent_at_ {}; // when the newest segment acknowledged so far was sent
+  double pacing_credit_ {};   // bytes the pacing rate allows to be sent now (may go negative)
+
+  std::optional<uint64_t> pacing_rate() const; // bytes per second, if congestion control paces
+
+  bool adaptive_RTO_;
+  rtt_estimator rtt_;
+  uint64_t RTO_after_ack() const
+  {
+    return adaptive_RTO_ and rtt_.has_estimate() ? rtt_.get_RTO() : initial_RTO_ms_;
+  }
+
+  // fast retransmit and NewReno recovery (RFC 5681, RFC 6582)
+  static constexpr uint64_t DUPLICATE_ACK_THRESHOLD = 3;
+  bool fast_retransmit_;
+  uint64_t duplicate_acks_ {};
+  bool in_recovery_ {};
+  uint64_t recover_ {};            // recovery ends once everything sent before it began is acknowledged
+  uint64_t recovery_inflation_ {}; // how far recovery lets the congestion window stretch
+  bool retransmit_pending_ {};     // push() should retransmit the oldest outstanding segment (and any holes)
+
+  // the SACK scoreboard: which outstanding segments the receiver holds (RFC 2018, RFC 6675)
+  bool sack_;
+  uint64_t high_sacked_ {}; // the end of the highest SACK block received
+  uint64_t high_rxt_ {};    // the end of the last segment retransmitted in this recovery
+  void record_sack_blocks( const TCPReceiverMessage& msg );
+
+  // window scaling (RFC 7323)
+  std::optional<uint8_t> window_scale_; // the shift our SYN offers (withdrawn if the peer's SYN offered none)
+  uint8_t peer_window_shift_ {};        // what the windows the peer advertises are shifted right by
 };
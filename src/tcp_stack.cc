@@ -0,0 +1,240 @@
+#include "tcp_stack.hh"
+
+#include <chrono>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+namespace {
+
+constexpr uint16_t FIRST_EPHEMERAL_PORT = 49152;
+
+uint64_t timestamp_ms()
+{
+  return chrono::duration_cast<chrono::milliseconds>( chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+} // namespace
+
+size_t TCPStack::FourTupleHash::operator()( const FourTuple& flow ) const
+{
+  // mix the two words with multiplicative hashing, so that flows differing only in their ports spread out
+  const uint64_t addresses = static_cast<uint64_t>( flow.local_address ) << 32 | flow.remote_address;
+  const uint64_t ports = static_cast<uint64_t>( flow.local_port ) << 16 | flow.remote_port;
+  uint64_t h = ( addresses ^ ( ports * 0x9E3779B97F4A7C15 ) ) * 0xC2B2AE3D27D4EB4F;
+  return h ^ ( h >> 31 );
+}
+
+TCPStack::TCPStack( TCPOverIPv4OverTunFdAdapter&& adapter,
+                    const Address& local_address,
+                    const TCPConfig& config,
+                    FlowOwner owner )
+  : _adapter( move( adapter ) )
+  , _local_address( local_address.ipv4_numeric() )
+  , _config( config )
+  , _owner( move( owner ) )
+  , _timer_category( _eventloop.add_category( "TCP timers" ) )
+  , _next_port( FIRST_EPHEMERAL_PORT )
+{
+  if ( not _owner ) {
+    _eventloop.add_rule( "TUN read", static_cast<TunFD&>( _adapter ), Direction::In, [this] { read_adapter(); } );
+  }
+}
+
+void TCPStack::listen( uint16_t port )
+{
+  _listeners.try_emplace( port );
+}
+
+optional<TCPStack::ConnectionId> TCPStack::accept( uint16_t port )
+{
+  const auto listener = _listeners.find( port );
+  if ( listener == _listeners.end() ) {
+    throw runtime_error( "TCPStack: accept() on a port that is not listening" );
+  }
+
+  auto& queue = listener->second;
+  while ( not queue.empty() ) {
+    const ConnectionId id = queue.front();
+    queue.pop_front();
+    if ( Connection* c = _connections.find( id ) ) {
+      c->visible = true;
+      notify( id, *c );
+      return id;
+    }
+  }
+  return {};
+}
+
+TCPStack::ConnectionId TCPStack::connect( const Address& destination )
+{
+  FourTuple flow { _local_address, destination.ipv4_numeric(), 0, destination.port() };
+  for ( uint32_t attempts = 0;; ++attempts ) {
+    if ( attempts > UINT16_MAX - FIRST_EPHEMERAL_PORT ) {
+      throw runtime_error( "TCPStack: no free local port to connect from" );
+    }
+    flow.local_port = _next_port;
+    _next_port = _next_port == UINT16_MAX ? FIRST_EPHEMERAL_PORT : _next_port + 1;
+    if ( not _flows.contains( flow ) and not _listeners.contains( flow.local_port )
+         and ( not _owner or _owner( flow ) ) ) {
+      break;
+    }
+  }
+
+  const ConnectionId id = open( flow, timestamp_ms() );
+  connection( id ).visible = true;
+  push( id ); // sends the SYN
+  return id;
+}
+
+void TCPStack::push( ConnectionId id )
+{
+  Connection& c = connection( id );
+  const uint64_t now = timestamp_ms();
+  tick( c, now );
+  c.peer.push( [&]( const TCPMessage& msg ) { _adapter.write( msg, c.flow ); } );
+  update( id, c, now );
+}
+
+void TCPStack::close( ConnectionId id )
+{
+  Connection& c = connection( id );
+  c.closed = true;
+  if ( not c.peer.outbound_writer().is_closed() ) {
+    c.peer.outbound_writer().close();
+    push( id ); // sends the FIN, and frees the connection if TCP is already done with it
+  } else {
+    update( id, c, timestamp_ms() );
+  }
+}
+
+void TCPStack::take_active( vector<ConnectionId>& ids )
+{
+  ids.clear();
+  for ( const ConnectionId id : _active ) {
+    if ( Connection* c = _connections.find( id ) ) { // skip connections freed since they were listed
+      c->listed = false;
+      ids.push_back( id );
+    }
+  }
+  _active.clear();
+}
+
+TCPStack::Connection& TCPStack::connection( ConnectionId id )
+{
+  Connection* c = _connections.find( id );
+  if ( not c ) {
+    throw runtime_error( "TCPStack: stale connection id" );
+  }
+  return *c;
+}
+
+TCPStack::ConnectionId TCPStack::open( const FourTuple& flow, uint64_t now )
+{
+  const ConnectionId id = _connections.emplace( flow, _config, now );
+  _flows.emplace( flow, id );
+  return id;
+}
+
+void TCPStack::read_adapter()
+{
+  FourTuple flow;
+  if ( auto msg = _adapter.read( flow ) ) {
+    receive( flow, move( msg.value() ) );
+  }
+}
+
+void TCPStack::receive( const FourTuple& flow, TCPMessage msg )
+{
+  if ( flow.local_address != _local_address ) {
+    return;
+  }
+
+  const uint64_t now = timestamp_ms();
+  ConnectionId id {};
+  if ( const auto it = _flows.find( flow ); it != _flows.end() ) {
+    id = it->second;
+  } else if ( _listeners.contains( flow.local_port ) and msg.sender.SYN and not msg.sender.RST ) {
+    id = open( flow, now );
+  } else {
+    return; // no such connection (a full stack would answer with a RST)
+  }
+
+  Connection& c = connection( id );
+  tick( c, now );
+  c.peer.receive( move( msg ), [&]( const TCPMessage& reply ) { _adapter.write( reply, c.flow ); } );
+  notify( id, c );
+  update( id, c, now );
+}
+
+void TCPStack::tick( Connection& c, uint64_t now )
+{
+  if ( now > c.last_tick ) {
+    c.peer.tick( now - c.last_tick, [&]( const TCPMessage& msg ) { _adapter.write( msg, c.flow ); } );
+    c.last_tick = now;
+  }
+}
+
+void TCPStack::notify( ConnectionId id, Connection& c )
+{
+  if ( c.visible and not c.closed and not c.listed ) {
+    _active.push_back( id );
+    c.listed = true;
+  }
+}
+
+// Bring the stack's bookkeeping up to date with whatever just happened to the connection
+void TCPStack::update( ConnectionId id, Connection& c, uint64_t now )
+{
+  if ( not c.established and c.peer.has_ackno() and c.peer.sender().sequence_numbers_in_flight() == 0 ) {
+    c.established = true;
+    if ( not c.visible ) {
+      if ( const auto listener = _listeners.find( c.flow.local_port ); listener != _listeners.end() ) {
+        listener->second.push_back( id );
+      }
+    }
+  }
+
+  if ( not c.peer.active() ) {
+    if ( c.timer.has_value() ) {
+      c.timer->cancel();
+      c.timer.reset();
+      c.timer_deadline.reset();
+    }
+    if ( const auto it = _flows.find( c.flow ); it != _flows.end() and it->second == id ) {
+      _flows.erase( it );
+      notify( id, c );
+    }
+    // free it once nobody can ask about it: the application has closed it, or never heard of it
+    if ( c.closed or not( c.visible or c.established ) ) {
+      _connections.erase( id );
+    }
+    return;
+  }
+
+  optional<uint64_t> deadline;
+  if ( const auto wait = c.peer.ms_until_deadline() ) {
+    deadline = c.last_tick + wait.value();
+  }
+  if ( deadline != c.timer_deadline ) {
+    if ( c.timer.has_value() ) {
+      c.timer->cancel();
+      c.timer.reset();
+    }
+    if ( deadline.has_value() ) {
+      const uint64_t delay = deadline.value() > now ? deadline.value() - now : 0;
+      c.timer = _eventloop.add_timer( _timer_category, delay, [this, id] {
+        Connection* expired = _connections.find( id );
+        if ( expired ) {
+          const uint64_t when = timestamp_ms();
+          expired->timer.reset();
+          expired->timer_deadline.reset();
+          tick( *expired, when );
+          update( id, *expired, when );
+        }
+      } );
+    }
+    c.timer_deadline = deadline;
+  }
+}
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <optional>
 
 class timer_state
 {
@@ -30,5 +33,44 @@ public:
   void add_count() { ++re_trans_count; }
   void clear_count() { re_trans_count = 0; };
   uint64_t get_current_RTO() const { return RTO_ms; };
+  uint64_t time_left() const { return timer_ms >= RTO_ms ? 0 : RTO_ms - timer_ms; }
   uint64_t peek_count() const { return re_trans_count; }
 };
+
+// RFC 6298 round-trip time estimation: a smoothed RTT and its variation, from which the retransmission timeout
+// follows (kept between the given bounds)
+class rtt_estimator
+{
+private:
+  static constexpr double ALPHA = 1.0 / 8;
+  static constexpr double BETA = 1.0 / 4;
+  static constexpr double CLOCK_GRANULARITY_MS = 1;
+
+  std::optional<double> srtt_ms {};
+  double rttvar_ms {};
+  uint64_t min_RTO_ms {};
+  uint64_t max_RTO_ms {};
+
+public:
+  rtt_estimator( uint64_t min_RTO, uint64_t max_RTO ) : min_RTO_ms( min_RTO ), max_RTO_ms( max_RTO ) {}
+  void add_sample( uint64_t rtt_ms )
+  {
+    const auto r = static_cast<double>( rtt_ms );
+    if ( not srtt_ms.has_value() ) {
+      srtt_ms = r;
+      rttvar_ms = r / 2;
+      return;
+    }
+    rttvar_ms = ( 1 - BETA ) * rttvar_ms + BETA * std::abs( srtt_ms.value() - r );
+    srtt_ms = ( 1 - ALPHA ) * srtt_ms.value() + ALPHA * r;
+  }
+  bool has_estimate() const { return srtt_ms.has_value(); }
+  std::optional<double> smoothed_rtt() const { return srtt_ms; }
+  double rtt_variation() const { return rttvar_ms; }
+  uint64_t get_RTO() const
+  {
+    const double rto = srtt_ms.value_or( 0 ) + std::max( CLOCK_GRANULARITY_MS, 4 * rttvar_ms );
+    return std::clamp( static_cast<uint64_t>( std::ceil( rto ) ), min_RTO_ms, max_RTO_ms );
+  }
+  uint64_t backoff( uint64_t RTO ) const { return std::min( 2 * RTO, max_RTO_ms ); }
+};
@@ -0,0 +1,65 @@
+#include "simulated_link.hh"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+// Send `bytes` across a simulated short, lossy link (1 ms each way), with the default 1 s retransmission timeout
+// either fixed or adapted to the measured RTT.
+void adaptive_rto_speed_test( const bool adaptive, const double loss, const uint64_t bytes )
+{
+  TCPConfig sender_config;
+  sender_config.adaptive_rto = adaptive;
+  sender_config.rto_min = 5;
+  TCPConfig receiver_config;
+
+  SimulatedTransfer transfer { sender_config, receiver_config, { .delay_ms = 1, .loss = loss }, 12345 };
+  const auto result = transfer.run( bytes, 100000000 );
+  if ( result.bytes != bytes ) {
+    throw runtime_error( "simulated transfer did not deliver exactly the bytes that were sent" );
+  }
+
+  const auto megabytes = static_cast<double>( bytes ) / 1e6;
+  const auto goodput = megabytes / ( static_cast<double>( result.elapsed_ms ) / 1000 );
+  const string name = string( adaptive ? "adaptive RTO" : "fixed RTO" ) + ", "
+                      + to_string( static_cast<int>( loss * 100 ) ) + "% loss";
+  const auto& sender = transfer.sender().sender();
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "TCP transfer (" << name << "): " << fixed << setprecision( 2 ) << goodput << " MB/s simulated, "
+       << "smoothed RTT " << setprecision( 1 ) << sender.smoothed_rtt().value_or( 0 ) << " ms, RTO "
+       << sender.retransmission_timeout() << " ms.\n";
+  debug_output << "             TCP transfer (" << name << "): " << fixed << setprecision( 2 ) << goodput
+               << " MB/s\n";
+}
+
+void program_body()
+{
+  for ( const double loss : { 0.0, 0.01, 0.05 } ) {
+    for ( const bool adaptive : { false, true } ) {
+      adaptive_rto_speed_test( adaptive, loss, 2000000 );
+    }
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -97,6 +97,56 @@ int main()
       test.execute( BytesBuffered { 1 } );
     }
 
+    {
+      ByteStreamTestHarness test { "wrap-around", 4 };
+      test.execute( Push { "abc" } );
+      test.execute( Pop { 2 } );
+      test.execute( Push { "defg" } );
+      test.execute( BytesPushed { 6 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( PeekOnce { "cd" } );
+      test.execute( PeekWrapped { "ef" } );
+      test.execute( Peek { "cdef" } );
+      test.execute( Pop { 3 } );
+      test.execute( PeekOnce { "f" } );
+      test.execute( PeekWrapped { "" } );
+      test.execute( Push { "hij" } );
+      test.execute( PeekOnce { "fhi" } );
+      test.execute( PeekWrapped { "j" } );
+      test.execute( Pop { 2 } );
+      test.execute( Push { "klm" } );
+      test.execute( BytesBuffered { 4 } );
+      test.execute( PeekOnce { "i" } );
+      test.execute( PeekWrapped { "jkl" } );
+      test.execute( PeekIov { { "i", "jkl" } } );
+      test.execute( PeekIov { { "i" }, 1 } );
+      test.execute( Peek { "ijkl" } );
+      test.execute( Pop { 4 } );
+      test.execute( PeekIov { {} } );
+      test.execute( Push { "no" } );
+      test.execute( PeekOnce { "no" } );
+      test.execute( PeekIov { { "no" } } );
+    }
+
+    {
+      ByteStreamTestHarness test { "chunks", 8, ByteStream::Mode::Chunked };
+      test.execute( Push { "abc" } );
+      test.execute( Push { "" } );
+      test.execute( Push { "defg" } );
+      test.execute( Push { "hijk" } );
+      test.execute( BytesPushed { 8 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( PeekOnce { "abc" } );
+      test.execute( PeekWrapped { "defg" } );
+      test.execute( PeekIov { { "abc", "defg", "h" } } );
+      test.execute( Pop { 4 } );
+      test.execute( PeekOnce { "efg" } );
+      test.execute( PeekIov { { "efg", "h" } } );
+      test.execute( PeekIov { { "efg" }, 1 } );
+      test.execute( ReadAll { "efgh" } );
+      test.execute( PeekIov { {} } );
+    }
+
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << endl;
     return EXIT_FAILURE;
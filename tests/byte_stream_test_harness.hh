@@ -16,8 +16,11 @@ static_assert( sizeof( Writer ) == sizeof( ByteStream ),
 class ByteStreamTestHarness : public TestHarness<ByteStream>
 {
 public:
-  ByteStreamTestHarness( std::string test_name, uint64_t capacity )
-    : TestHarness( move( test_name ), "capacity=" + std::to_string( capacity ), ByteStream { capacity } )
+  ByteStreamTestHarness( std::string test_name, uint64_t capacity, ByteStream::Mode mode = ByteStream::Mode::Ring )
+    : TestHarness( move( test_name ),
+                   "capacity=" + std::to_string( capacity )
+                     + ( mode == ByteStream::Mode::Chunked ? ", mode=chunked" : "" ),
+                   ByteStream { capacity, mode } )
   {}
 
   size_t peek_size() { return object().reader().peek().size(); }
@@ -107,6 +110,60 @@ struct PeekOnce : public Peek
   }
 };
 
+struct PeekWrapped : public Peek
+{
+  using Peek::Peek;
+
+  std::string description() const override
+  {
+    return "peek_wrapped() gives exactly \"" + Printer::prettify( output_ ) + "\"";
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    auto peeked = bs.reader().peek_wrapped();
+    if ( peeked != output_ ) {
+      throw ExpectationViolation { "Expected exactly \"" + Printer::prettify( output_ ) + "\" after wrap-around, "
+                                   + "but found \"" + Printer::prettify( peeked ) + "\"" };
+    }
+  }
+};
+
+struct PeekIov : public Expectation<ByteStream>
+{
+  std::vector<std::string> output_;
+  size_t max_segments_;
+
+  explicit PeekIov( std::vector<std::string> output, size_t max_segments = 64 )
+    : output_( move( output ) ), max_segments_( max_segments )
+  {}
+
+  std::string description() const override
+  {
+    std::string desc = "peek_iov( " + std::to_string( max_segments_ ) + " ) gives [";
+    for ( const auto& x : output_ ) {
+      desc += " \"" + Printer::prettify( x ) + "\"";
+    }
+    return desc + " ]";
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    const auto segments = bs.reader().peek_iov( max_segments_ );
+    if ( segments.size() != output_.size() ) {
+      throw ExpectationViolation { "Expected " + std::to_string( output_.size() ) + " segments from peek_iov(), "
+                                   + "but found " + std::to_string( segments.size() ) };
+    }
+    for ( size_t i = 0; i < segments.size(); ++i ) {
+      if ( segments[i] != output_[i] ) {
+        throw ExpectationViolation { "Expected segment " + std::to_string( i ) + " to be \""
+                                     + Printer::prettify( output_[i] ) + "\", but found \""
+                                     + Printer::prettify( segments[i] ) + "\"" };
+      }
+    }
+  }
+};
+
 struct IsClosed : public ConstExpectBool<ByteStream>
 {
   using ConstExpectBool::ConstExpectBool;
@@ -0,0 +1,95 @@
+#include "checksum.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+string_view kernel_name( InternetChecksum::Kernel kernel )
+{
+  switch ( kernel ) {
+    case InternetChecksum::Kernel::Scalar:
+      return "scalar";
+    case InternetChecksum::Kernel::SSE2:
+      return "sse2";
+    case InternetChecksum::Kernel::AVX2:
+      return "avx2";
+  }
+  return {};
+}
+
+// Checksum `total_len` bytes, as buffers of `buffer_len` bytes split in two pieces at an odd offset (like a
+// TCP header followed by its payload).
+void speed_test( const InternetChecksum::Kernel kernel,
+                 const size_t total_len,  // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t buffer_len, // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t random_seed )
+{
+  default_random_engine rd { random_seed };
+  string data( buffer_len, 0 );
+  generate( data.begin(), data.end(), [&] { return static_cast<char>( rd() ); } );
+  const vector<string_view> pieces { string_view { data }.substr( 0, 21 ), string_view { data }.substr( 21 ) };
+
+  const size_t iterations = total_len / buffer_len;
+  uint32_t sink = 0;
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < iterations; ++i ) {
+    InternetChecksum check { static_cast<uint32_t>( i ), kernel };
+    check.add( pieces );
+    sink += check.value();
+  }
+  const auto stop_time = steady_clock::now();
+
+  InternetChecksum scalar { 0, InternetChecksum::Kernel::Scalar };
+  InternetChecksum tested { 0, kernel };
+  scalar.add( pieces );
+  tested.add( pieces );
+  if ( scalar.value() != tested.value() ) {
+    throw runtime_error( "Checksum kernels disagree" );
+  }
+
+  auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  auto gigabytes_per_second = static_cast<double>( iterations * buffer_len ) / test_duration.count() / 1e9;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "InternetChecksum (" << kernel_name( kernel ) << ") over " << buffer_len << "-byte buffers reached "
+       << fixed << setprecision( 2 ) << gigabytes_per_second << " GB/s (" << sink % 10 << ").\n";
+
+  debug_output << "             InternetChecksum throughput (" << kernel_name( kernel ) << ", " << buffer_len
+               << " bytes): " << fixed << setprecision( 2 ) << gigabytes_per_second << " GB/s\n";
+}
+
+void program_body()
+{
+  for ( const auto kernel :
+        { InternetChecksum::Kernel::Scalar, InternetChecksum::Kernel::SSE2, InternetChecksum::Kernel::AVX2 } ) {
+    if ( not InternetChecksum::supported( kernel ) ) {
+      continue;
+    }
+    for ( const size_t buffer_len : { 64, 1500, 9000, 65536 } ) {
+      speed_test( kernel, size_t { 1 } << 28, buffer_len, 1370 );
+    }
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,73 @@
+#include "simulated_link.hh"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+// Send `bytes` across a simulated link with a bottleneck (10 Mbit/s, 20 ms round trip, a queue of about one
+// bandwidth-delay product) that also loses datagrams at random, and see how each congestion controller copes.
+void congestion_control_speed_test( const CongestionControl::Algorithm algorithm,
+                                    const double loss,
+                                    const uint64_t bytes )
+{
+  TCPConfig sender_config;
+  sender_config.rt_timeout = 100;
+  sender_config.congestion_control = algorithm;
+  TCPConfig receiver_config;
+  receiver_config.rt_timeout = 100;
+
+  const LinkConfig link { .delay_ms = 10, .loss = loss, .rate = 1250, .queue_limit = 30000 };
+  SimulatedTransfer transfer { sender_config, receiver_config, link, 12345 };
+  const auto result = transfer.run( bytes, 10000000 );
+  if ( result.bytes != bytes ) {
+    throw runtime_error( "simulated transfer did not deliver exactly the bytes that were sent" );
+  }
+
+  const auto megabytes = static_cast<double>( bytes ) / 1e6;
+  const auto goodput = megabytes / ( static_cast<double>( result.elapsed_ms ) / 1000 );
+  const string name = string( CongestionControl::name( algorithm ) ) + ", "
+                      + to_string( static_cast<int>( loss * 100 ) ) + "% loss";
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "Congestion control (" << name << "): " << fixed << setprecision( 2 ) << goodput
+       << " MB/s simulated (link: 1.25), " << setprecision( 0 )
+       << static_cast<double>( result.datagrams_sent ) / megabytes << " data datagrams/MB, "
+       << static_cast<double>( result.queue_drops ) / megabytes << " queue drops/MB, " << setprecision( 2 )
+       << megabytes / result.wall_seconds << " MB/s of CPU time.\n";
+  debug_output << "             Congestion control (" << name << "): " << fixed << setprecision( 2 ) << goodput
+               << " MB/s\n";
+}
+
+void program_body()
+{
+  for ( const double loss : { 0.0, 0.01, 0.05 } ) {
+    for ( const auto algorithm : { CongestionControl::Algorithm::None,
+                                   CongestionControl::Algorithm::NewReno,
+                                   CongestionControl::Algorithm::Cubic,
+                                   CongestionControl::Algorithm::BBR } ) {
+      congestion_control_speed_test( algorithm, loss, 5000000 );
+    }
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,67 @@
+#include "simulated_link.hh"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+// Send `bytes` across a simulated lossy link, with the receiver acknowledging every segment or delaying its ACKs,
+// and count the datagrams each way per megabyte.
+void delayed_ack_speed_test( const uint16_t ack_delay, const double loss, const uint64_t bytes )
+{
+  TCPConfig sender_config;
+  sender_config.rt_timeout = 100;
+  TCPConfig receiver_config;
+  receiver_config.rt_timeout = 100;
+  receiver_config.ack_delay = ack_delay;
+
+  SimulatedTransfer transfer { sender_config, receiver_config, { .delay_ms = 5, .loss = loss }, 12345 };
+  const auto result = transfer.run( bytes, 10000000 );
+  if ( result.bytes != bytes ) {
+    throw runtime_error( "simulated transfer did not deliver exactly the bytes that were sent" );
+  }
+
+  const auto megabytes = static_cast<double>( bytes ) / 1e6;
+  const auto goodput = megabytes / ( static_cast<double>( result.elapsed_ms ) / 1000 );
+  const string delay_name = ack_delay ? "ACKs delayed " + to_string( ack_delay ) + " ms" : "ACK every segment";
+  const string name = delay_name + ", " + to_string( static_cast<int>( loss * 100 ) ) + "% loss";
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "TCP transfer (" << name << "): " << fixed << setprecision( 0 )
+       << static_cast<double>( result.datagrams_sent ) / megabytes << " data + "
+       << static_cast<double>( result.datagrams_acked ) / megabytes << " ACK datagrams/MB, " << setprecision( 2 )
+       << goodput << " MB/s simulated, " << megabytes / result.wall_seconds << " MB/s of CPU time.\n";
+  debug_output << "             TCP transfer (" << name << "): " << fixed << setprecision( 0 )
+               << static_cast<double>( result.datagrams_sent + result.datagrams_acked ) / megabytes
+               << " datagrams/MB\n";
+}
+
+void program_body()
+{
+  for ( const double loss : { 0.0, 0.01, 0.05 } ) {
+    for ( const uint16_t ack_delay : { 0, 40 } ) {
+      delayed_ack_speed_test( ack_delay, loss, 10000000 );
+    }
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
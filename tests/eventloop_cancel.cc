@@ -0,0 +1,64 @@
+#include "eventloop.hh"
+#include "exception.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#include <sys/eventfd.h>
+
+using namespace std;
+
+namespace {
+
+// Two rules on fds that are both ready, each cancelling the other when it runs. With Dispatch::All, one poll
+// serves both: the one served second must be skipped, since its caller may already have freed what it uses.
+void check_cancel_in_batch( const EventLoop::Backend backend )
+{
+  EventLoop loop { backend, EventLoop::Dispatch::All };
+  FileDescriptor first_fd { CheckSystemCall( "eventfd", ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) ) };
+  FileDescriptor second_fd { CheckSystemCall( "eventfd", ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) ) };
+  const string one { "\1\0\0\0\0\0\0\0", sizeof( uint64_t ) };
+  first_fd.write( one );
+  second_fd.write( one );
+
+  unsigned int ran = 0;
+  string buffer;
+  optional<EventLoop::RuleHandle> first, second;
+  const size_t category = loop.add_category( "eventfd" );
+  first = loop.add_rule( category, first_fd, Direction::In, [&] {
+    buffer.resize( sizeof( uint64_t ) );
+    first_fd.read( buffer );
+    ++ran;
+    second->cancel();
+  } );
+  second = loop.add_rule( category, second_fd, Direction::In, [&] {
+    buffer.resize( sizeof( uint64_t ) );
+    second_fd.read( buffer );
+    ++ran;
+    first->cancel();
+  } );
+
+  if ( loop.wait_next_event( 100 ) != EventLoop::Result::Success or ran != 1 ) {
+    throw runtime_error( string( backend == EventLoop::Backend::Epoll ? "epoll" : "poll" )
+                         + ": a rule ran after another rule served in the same batch cancelled it" );
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    check_cancel_in_batch( EventLoop::Backend::Poll );
+    check_cancel_in_batch( EventLoop::Backend::Epoll );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,271 @@
+#include "eventloop.hh"
+#include "exception.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+
+using namespace std;
+using namespace std::chrono;
+
+// count heap allocations, to check that dispatching events does not allocate
+namespace {
+atomic<uint64_t> allocations {};
+} // namespace
+
+void* operator new( size_t size )
+{
+  ++allocations;
+  if ( void* ptr = malloc( size ) ) { // NOLINT(*-no-malloc, *-owning-memory)
+    return ptr;
+  }
+  throw bad_alloc {};
+}
+
+void operator delete( void* ptr ) noexcept
+{
+  free( ptr ); // NOLINT(*-no-malloc, *-owning-memory)
+}
+
+void operator delete( void* ptr, size_t /* size */ ) noexcept
+{
+  free( ptr ); // NOLINT(*-no-malloc, *-owning-memory)
+}
+
+namespace {
+
+double cpu_seconds()
+{
+  rusage usage {};
+  CheckSystemCall( "getrusage", ::getrusage( RUSAGE_SELF, &usage ) );
+  const auto seconds = []( const timeval& tv ) { return static_cast<double>( tv.tv_sec ) + tv.tv_usec / 1e6; };
+  return seconds( usage.ru_utime ) + seconds( usage.ru_stime );
+}
+
+// Register `num_rules` readers, one per eventfd, then repeatedly signal one of them and wait for its callback.
+void wakeup_speed_test( const EventLoop::Backend backend, const size_t num_rules, const size_t iterations )
+{
+  EventLoop loop { backend };
+  vector<FileDescriptor> fds;
+  fds.reserve( num_rules );
+  size_t last_woken = num_rules;
+  string buffer;
+
+  const size_t category = loop.add_category( "eventfd" );
+  for ( size_t i = 0; i < num_rules; ++i ) {
+    fds.emplace_back( CheckSystemCall( "eventfd", ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) ) );
+    loop.add_rule( category, fds.back(), Direction::In, [&, i] {
+      buffer.resize( sizeof( uint64_t ) );
+      fds[i].read( buffer );
+      last_woken = i;
+    } );
+  }
+
+  const string one { "\1\0\0\0\0\0\0\0", sizeof( uint64_t ) };
+  const auto start_cpu = cpu_seconds();
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < iterations; ++i ) {
+    const size_t target = ( i * 7919 ) % num_rules;
+    fds[target].write( one );
+    if ( loop.wait_next_event( -1 ) != EventLoop::Result::Success or last_woken != target ) {
+      throw runtime_error( "EventLoop did not wake the signalled rule" );
+    }
+  }
+  const auto stop_time = steady_clock::now();
+  const auto cpu_per_wakeup = ( cpu_seconds() - start_cpu ) / static_cast<double>( iterations ) * 1e6;
+
+  const auto test_duration = duration_cast<duration<double, micro>>( stop_time - start_time );
+  const auto latency = test_duration.count() / static_cast<double>( iterations );
+  const string name = backend == EventLoop::Backend::Epoll ? "epoll" : "poll";
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "EventLoop (" << name << ") with " << num_rules << " rules: " << fixed << setprecision( 2 ) << latency
+       << " us/wakeup, " << cpu_per_wakeup << " us CPU/wakeup.\n";
+  debug_output << "             EventLoop wakeup (" << name << ", " << num_rules << " rules): " << fixed
+               << setprecision( 2 ) << latency << " us\n";
+}
+
+// Signal `burst` of `num_rules` readers at once, and wait until every one of them has been served.
+void burst_speed_test( const EventLoop::Backend backend,
+                       const EventLoop::Dispatch dispatch,
+                       const size_t num_rules,
+                       const size_t burst,
+                       const size_t rounds )
+{
+  EventLoop loop { backend, dispatch };
+  vector<FileDescriptor> fds;
+  fds.reserve( num_rules );
+  size_t served = 0;
+  string buffer;
+
+  const size_t category = loop.add_category( "eventfd" );
+  for ( size_t i = 0; i < num_rules; ++i ) {
+    fds.emplace_back( CheckSystemCall( "eventfd", ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) ) );
+    loop.add_rule( category, fds.back(), Direction::In, [&, i] {
+      buffer.resize( sizeof( uint64_t ) );
+      fds[i].read( buffer );
+      ++served;
+    } );
+  }
+
+  // let the loop register its rules (epoll does so lazily) before counting
+  if ( loop.wait_next_event( 0 ) != EventLoop::Result::Timeout ) {
+    throw runtime_error( "EventLoop served a rule that was not signalled" );
+  }
+
+  const string one { "\1\0\0\0\0\0\0\0", sizeof( uint64_t ) };
+  const auto start_allocations = allocations.load();
+  const auto start_waits = loop.stats().waits;
+  const auto start_time = steady_clock::now();
+  for ( size_t round = 0; round < rounds; ++round ) {
+    for ( size_t i = 0; i < burst; ++i ) {
+      fds[( round * burst + i ) % num_rules].write( one );
+    }
+    served = 0;
+    while ( served < burst ) {
+      if ( loop.wait_next_event( 1000 ) != EventLoop::Result::Success ) {
+        throw runtime_error( "EventLoop did not serve every signalled rule" );
+      }
+    }
+    if ( served != burst ) {
+      throw runtime_error( "EventLoop served a rule that was not signalled" );
+    }
+  }
+  const auto stop_time = steady_clock::now();
+
+  const auto events = static_cast<double>( burst * rounds );
+  const auto test_duration = duration_cast<duration<double, micro>>( stop_time - start_time );
+  const auto allocations_per_event = static_cast<double>( allocations.load() - start_allocations ) / events;
+  const string name = string( backend == EventLoop::Backend::Epoll ? "epoll" : "poll" ) + ", "
+                      + ( dispatch == EventLoop::Dispatch::All ? "all" : "one" );
+
+  const auto waits = static_cast<double>( loop.stats().waits - start_waits );
+
+  cout << "EventLoop (" << name << ") serving " << burst << " of " << num_rules << " rules: " << fixed
+       << setprecision( 2 ) << test_duration.count() / events << " us/event, "
+       << waits / static_cast<double>( rounds ) << " waits/burst, " << setprecision( 3 ) << allocations_per_event
+       << " allocations/event.\n";
+}
+
+// Mark `burst` of `num_rules` non-fd rules interested, and time how long EventLoop takes to run their callbacks.
+// No system calls are involved, so this measures the cost of finding and calling the rules.
+void dispatch_speed_test( const size_t num_rules, const size_t burst, const size_t rounds )
+{
+  EventLoop loop { EventLoop::Backend::Poll, EventLoop::Dispatch::All };
+  vector<uint8_t> pending( num_rules );
+  size_t served = 0;
+
+  const size_t category = loop.add_category( "flag" );
+  for ( size_t i = 0; i < num_rules; ++i ) {
+    loop.add_rule(
+      category,
+      [&, i] {
+        pending[i] = 0;
+        ++served;
+      },
+      [&, i] { return pending[i] != 0; } );
+  }
+
+  const auto start_allocations = allocations.load();
+  const auto start_time = steady_clock::now();
+  for ( size_t round = 0; round < rounds; ++round ) {
+    for ( size_t i = 0; i < burst; ++i ) {
+      pending[( round * burst + i ) % num_rules] = 1;
+    }
+    served = 0;
+    while ( served < burst ) {
+      if ( loop.wait_next_event( 0 ) != EventLoop::Result::Success ) {
+        throw runtime_error( "EventLoop did not serve every interested rule" );
+      }
+    }
+  }
+  const auto stop_time = steady_clock::now();
+
+  const auto events = static_cast<double>( burst * rounds );
+  const auto test_duration = duration_cast<duration<double, nano>>( stop_time - start_time );
+  const auto allocations_per_event = static_cast<double>( allocations.load() - start_allocations ) / events;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "EventLoop dispatching " << burst << " of " << num_rules << " rules: " << fixed << setprecision( 1 )
+       << test_duration.count() / events << " ns/event, " << setprecision( 3 ) << allocations_per_event
+       << " allocations/event.\n";
+  debug_output << "             EventLoop dispatch (" << burst << " of " << num_rules << " rules): " << fixed
+               << setprecision( 1 ) << test_duration.count() / events << " ns/event\n";
+}
+
+// Re-arm a one-shot timer over and over, as TCPMinnowSocket does whenever its next deadline moves.
+void rearm_speed_test( const size_t iterations )
+{
+  EventLoop loop;
+  const size_t category = loop.add_category( "timer" );
+  size_t fired = 0;
+  auto timer = loop.add_timer( category, 1000, [&] { ++fired; } );
+
+  const auto start_allocations = allocations.load();
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < iterations; ++i ) {
+    timer.cancel();
+    timer = loop.add_timer( category, 1000 + i % 100, [&] { ++fired; } );
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( fired != 0 ) {
+    throw runtime_error( "a cancelled timer fired" );
+  }
+
+  const auto test_duration = duration_cast<duration<double, nano>>( stop_time - start_time );
+  const auto allocations_per_rearm
+    = static_cast<double>( allocations.load() - start_allocations ) / static_cast<double>( iterations );
+
+  cout << "EventLoop timer re-arm: " << fixed << setprecision( 1 )
+       << test_duration.count() / static_cast<double>( iterations ) << " ns, " << setprecision( 3 )
+       << allocations_per_rearm << " allocations.\n";
+}
+
+void program_body()
+{
+  for ( const size_t num_rules : { 10, 1000, 10000 } ) {
+    const size_t iterations = max( size_t { 500 }, 1000000 / num_rules );
+    for ( const auto backend : { EventLoop::Backend::Poll, EventLoop::Backend::Epoll } ) {
+      wakeup_speed_test( backend, num_rules, iterations );
+    }
+  }
+
+  for ( const auto backend : { EventLoop::Backend::Poll, EventLoop::Backend::Epoll } ) {
+    for ( const auto dispatch : { EventLoop::Dispatch::One, EventLoop::Dispatch::All } ) {
+      burst_speed_test( backend, dispatch, 1000, 50, 20 );
+    }
+  }
+
+  dispatch_speed_test( 16, 16, 100000 );
+  dispatch_speed_test( 1000, 16, 20000 );
+  dispatch_speed_test( 1000, 1000, 2000 );
+  rearm_speed_test( 1000000 );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
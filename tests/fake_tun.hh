@@ -0,0 +1,96 @@
+#pragma once
+
+#include "eventloop.hh"
+#include "exception.hh"
+#include "file_descriptor.hh"
+#include "tun.hh"
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <sys/socket.h>
+
+//! Two fake TUN devices joined by a wire: each datagram written to one can be read from the other.
+//! \details Each device is one end of a SOCK_SEQPACKET socketpair, and a thread carries datagrams between the other
+//! ends. The wire never blocks and queues without limit, so a stack blocked writing to one device is never
+//! waiting, in turn, on the stack at the other end.
+class FakeTunWire
+{
+public:
+  FakeTunWire()
+  {
+    auto [a_wire, a_end] = datagram_pair();
+    auto [b_wire, b_end] = datagram_pair();
+    a_.emplace( std::move( a_end ) );
+    b_.emplace( std::move( b_end ) );
+    relay_ = std::thread { [this, a = std::move( a_wire ), b = std::move( b_wire )]() mutable { relay( a, b ); } };
+  }
+
+  ~FakeTunWire() { stop(); }
+
+  FakeTunWire( const FakeTunWire& other ) = delete;
+  FakeTunWire& operator=( const FakeTunWire& other ) = delete;
+
+  //! Stop carrying datagrams. Call this before closing the devices, or the wire complains about them.
+  void stop()
+  {
+    stop_ = true;
+    if ( relay_.joinable() ) {
+      relay_.join();
+    }
+  }
+
+  //! The two devices (each can be taken once)
+  TunFD take_a() { return std::move( a_.value() ); }
+  TunFD take_b() { return std::move( b_.value() ); }
+
+private:
+  std::optional<TunFD> a_ {};
+  std::optional<TunFD> b_ {};
+  std::atomic<bool> stop_ {};
+  std::thread relay_ {};
+
+  static std::pair<FileDescriptor, FileDescriptor> datagram_pair()
+  {
+    std::array<int, 2> fds {};
+    CheckSystemCall( "socketpair", ::socketpair( AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds.data() ) );
+    return { FileDescriptor { fds[0] }, FileDescriptor { fds[1] } };
+  }
+
+  void relay( FileDescriptor& a, FileDescriptor& b )
+  {
+    EventLoop loop { EventLoop::Backend::Poll, EventLoop::Dispatch::All };
+    std::deque<std::string> a_to_b;
+    std::deque<std::string> b_to_a;
+
+    auto forward = [&]( FileDescriptor& from, FileDescriptor& to, std::deque<std::string>& queue ) {
+      loop.add_rule( "wire read", from, Direction::In, [&] {
+        std::string datagram;
+        from.read( datagram );
+        if ( not datagram.empty() ) {
+          queue.push_back( std::move( datagram ) );
+        }
+      } );
+      loop.add_rule(
+        "wire write",
+        to,
+        Direction::Out,
+        [&] {
+          to.write( queue.front() );
+          queue.pop_front();
+        },
+        [&] { return not queue.empty(); } );
+    };
+    forward( a, b, a_to_b );
+    forward( b, a, b_to_a );
+
+    while ( not stop_ ) {
+      loop.wait_next_event( 10 );
+    }
+  }
+};
@@ -0,0 +1,73 @@
+#include "simulated_link.hh"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+// Send `bytes` across a simulated link (10 ms each way) that loses datagrams on the way to the receiver but not on
+// the way back, with loss recovered by the retransmission timer alone or by fast retransmit as well.
+void fast_retransmit_speed_test( const CongestionControl::Algorithm algorithm,
+                                 const bool fast_retransmit,
+                                 const double loss,
+                                 const uint64_t bytes )
+{
+  TCPConfig sender_config;
+  sender_config.rt_timeout = 100;
+  sender_config.congestion_control = algorithm;
+  sender_config.fast_retransmit = fast_retransmit;
+  TCPConfig receiver_config;
+  receiver_config.rt_timeout = 100;
+
+  SimulatedTransfer transfer {
+    sender_config, receiver_config, { .delay_ms = 10, .loss = loss }, { .delay_ms = 10 }, 12345 };
+  const auto result = transfer.run( bytes, 100000000 );
+  if ( result.bytes != bytes ) {
+    throw runtime_error( "simulated transfer did not deliver exactly the bytes that were sent" );
+  }
+
+  const auto megabytes = static_cast<double>( bytes ) / 1e6;
+  const auto goodput = megabytes / ( static_cast<double>( result.elapsed_ms ) / 1000 );
+  const string name = string( fast_retransmit ? "fast retransmit" : "timeout only" ) + ", "
+                      + CongestionControl::name( algorithm ) + ", " + to_string( static_cast<int>( loss * 100 ) )
+                      + "% uplink loss";
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "TCP transfer (" << name << "): " << fixed << setprecision( 2 ) << goodput << " MB/s simulated, "
+       << setprecision( 0 ) << static_cast<double>( result.datagrams_sent ) / megabytes << " datagrams/MB sent.\n";
+  debug_output << "             TCP transfer (" << name << "): " << fixed << setprecision( 2 ) << goodput
+               << " MB/s\n";
+}
+
+void program_body()
+{
+  using enum CongestionControl::Algorithm;
+  for ( const auto algorithm : { None, NewReno } ) {
+    for ( const double loss : { 0.01, 0.05, 0.1 } ) {
+      for ( const bool fast_retransmit : { false, true } ) {
+        fast_retransmit_speed_test( algorithm, fast_retransmit, loss, 2000000 );
+      }
+    }
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,144 @@
+#include "checksum.hh"
+#include "ipv4_header.hh"
+#include "random.hh"
+#include "tcp_segment.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// The original byte-at-a-time algorithm
+uint16_t reference_checksum( uint64_t sum, const vector<string_view>& pieces )
+{
+  bool parity = false;
+  for ( const auto& piece : pieces ) {
+    for ( const uint8_t byte : piece ) {
+      sum += parity ? byte : byte << 8;
+      parity = !parity;
+    }
+  }
+  while ( sum > 0xffff ) {
+    sum = ( sum >> 16 ) + static_cast<uint16_t>( sum );
+  }
+  return ~static_cast<uint16_t>( sum );
+}
+
+void check( uint32_t initial, const string& data, const vector<size_t>& cuts )
+{
+  vector<string_view> pieces;
+  size_t start = 0;
+  for ( const auto cut : cuts ) {
+    pieces.push_back( string_view { data }.substr( start, cut - start ) );
+    start = cut;
+  }
+  pieces.push_back( string_view { data }.substr( start ) );
+
+  const uint16_t expected = reference_checksum( initial, pieces );
+  for ( const auto kernel : { InternetChecksum::Kernel::Scalar,
+                              InternetChecksum::Kernel::SSE2,
+                              InternetChecksum::Kernel::AVX2 } ) {
+    if ( not InternetChecksum::supported( kernel ) ) {
+      continue;
+    }
+    InternetChecksum check { initial, kernel };
+    check.add( pieces );
+    if ( check.value() != expected ) {
+      ostringstream ss;
+      ss << "Checksum mismatch with kernel " << static_cast<int>( kernel ) << ": expected " << expected
+         << " but got " << check.value() << "\n  (length " << data.size() << " in " << pieces.size()
+         << " pieces, initial sum " << initial << ")\n";
+      throw runtime_error( ss.str() );
+    }
+  }
+}
+
+// Incremental updates (RFC 1624) must agree with recomputing the checksum from scratch.
+void check_adjust( default_random_engine& rd )
+{
+  IPv4Header header;
+  header.len = 40 + rd() % 1400;
+  header.id = rd();
+  header.ttl = 1 + rd() % 255;
+  header.src = rd();
+  header.dst = rd();
+  header.compute_checksum();
+
+  TCPSegment segment;
+  segment.udinfo = { static_cast<uint16_t>( rd() ), static_cast<uint16_t>( rd() ), 0 };
+  segment.message.sender.seqno = Wrap32 { static_cast<uint32_t>( rd() ) };
+  segment.message.sender.payload = string( header.payload_length() - 20, 'x' );
+  segment.compute_checksum( header.pseudo_checksum() );
+
+  const uint32_t old_src = header.src;
+  header.set_ttl( header.ttl - 1 );
+  header.set_src( rd() );
+  header.set_dst( header.dst ^ 0xff );
+  segment.set_src_port( rd() );
+  segment.set_dst_port( rd() );
+  segment.adjust_checksum_for_address( old_src, header.src );
+  segment.adjust_checksum_for_address( header.dst ^ 0xff, header.dst );
+
+  IPv4Header recomputed_header = header;
+  recomputed_header.compute_checksum();
+  TCPSegment recomputed_segment = segment;
+  recomputed_segment.compute_checksum( header.pseudo_checksum() );
+  if ( header.cksum != recomputed_header.cksum or segment.udinfo.cksum != recomputed_segment.udinfo.cksum ) {
+    throw runtime_error( "Incremental checksum update disagrees with recomputing it" );
+  }
+}
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    uniform_int_distribution<uint32_t> initial_dist { 0, 0x3fffc };
+
+    for ( unsigned int i = 0; i < 20000; i++ ) {
+      // mostly packet-sized buffers, sometimes up to 64 KiB
+      const size_t len = i % 100 == 0 ? rd() % 65536 : rd() % 2048;
+      // every third buffer is all ones, whose sum folds to 0xffff rather than zero
+      string data( len, static_cast<char>( 0xff ) );
+      if ( i % 3 ) {
+        generate( data.begin(), data.end(), [&] { return static_cast<char>( rd() ); } );
+      }
+
+      vector<size_t> cuts( rd() % 6 );
+      generate( cuts.begin(), cuts.end(), [&] { return len ? rd() % ( len + 1 ) : 0; } );
+      sort( cuts.begin(), cuts.end() );
+
+      check( i % 2 ? initial_dist( rd ) : 0, data, cuts );
+    }
+
+    // buffers of 1 to 3 MiB cross the vector kernels' drain interval (every 512 KiB with SSE2, 1 MiB with AVX2),
+    // some of them more than once, cut at odd offsets so that the pieces start misaligned
+    for ( unsigned int i = 0; i < 8; i++ ) {
+      const size_t len = ( 1 << 20 ) + rd() % ( 2 << 20 );
+      string data( len, static_cast<char>( 0xff ) );
+      if ( i % 2 ) {
+        generate( data.begin(), data.end(), [&] { return static_cast<char>( rd() ); } );
+      }
+
+      vector<size_t> cuts( rd() % 4 );
+      generate( cuts.begin(), cuts.end(), [&] { return ( rd() % len ) | 1; } );
+      sort( cuts.begin(), cuts.end() );
+
+      check( initial_dist( rd ), data, cuts );
+    }
+
+    for ( unsigned int i = 0; i < 20000; i++ ) {
+      check_adjust( rd );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
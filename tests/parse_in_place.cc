@@ -0,0 +1,125 @@
+#include "random.hh"
+#include "tcp_config.hh"
+#include "tcp_over_ip.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Parsing a datagram in place, however its bytes are split across buffers, must give the same segment as parsing
+// a copy of it (with the options that were sent), and a payload that sits alone in a buffer must be handed over in
+// that buffer.
+void check_in_place( TCPOverIPv4Adapter& sender, const TCPMessage& msg, default_random_engine& rd )
+{
+  string datagram;
+  for ( const auto& buffer : serialize( sender.wrap_tcp_in_ip( msg ) ) ) {
+    datagram += buffer;
+  }
+
+  InternetDatagram copy;
+  if ( not parse( copy, { datagram } ) ) {
+    throw runtime_error( "failed to parse a datagram" );
+  }
+  FourTuple expected_flow;
+  const auto expected = TCPOverIPv4Adapter::unwrap_tcp_in_ip( copy, expected_flow );
+
+  // (the options only go on a SYN, and leave room for three SACK blocks when both do)
+  const bool both_syn_options = msg.sender.SYN and msg.sender.SACK_permitted and msg.sender.window_scale;
+  const auto window_scale = msg.sender.SYN ? msg.sender.window_scale : nullopt;
+  const size_t sack_blocks = min( msg.receiver.sack.size(), both_syn_options ? size_t { 3 } : size_t { 4 } );
+
+  // split at the end of the headers, and then at random places
+  for ( size_t attempt = 0; attempt < 4; ++attempt ) {
+    vector<string> buffers;
+    const size_t headers = datagram.size() - msg.sender.payload.size();
+    size_t split = attempt == 0 ? headers : rd() % ( datagram.size() + 1 );
+    buffers.push_back( datagram.substr( 0, split ) );
+    if ( attempt > 1 and split < datagram.size() ) {
+      const size_t second = split + rd() % ( datagram.size() - split );
+      buffers.push_back( datagram.substr( split, second - split ) );
+      split = second;
+    }
+    buffers.push_back( datagram.substr( split ) );
+    const char* payload_buffer = buffers.back().data();
+
+    Parser parser { span { buffers } };
+    FourTuple flow;
+    const auto actual = TCPOverIPv4Adapter::unwrap_tcp_in_ip( parser, flow );
+
+    if ( not actual.has_value() or not expected.has_value() or actual->sender.payload != expected->sender.payload
+         or actual->sender.seqno != expected->sender.seqno or actual->sender.SYN != expected->sender.SYN
+         or actual->sender.FIN != expected->sender.FIN or actual->receiver.ackno != expected->receiver.ackno
+         or actual->receiver.window_size != expected->receiver.window_size
+         or actual->sender.SACK_permitted != msg.sender.SACK_permitted
+         or actual->sender.window_scale != window_scale or actual->receiver.sack.size() != sack_blocks
+         or not equal( actual->receiver.sack.begin(),
+                       actual->receiver.sack.end(),
+                       msg.receiver.sack.begin(),
+                       msg.receiver.sack.begin() + static_cast<ptrdiff_t>( sack_blocks ),
+                       []( const SACKBlock& a, const SACKBlock& b ) {
+                         return a.left == b.left and a.right == b.right;
+                       } )
+         or flow.local_port != expected_flow.local_port or flow.remote_port != expected_flow.remote_port
+         or flow.local_address != expected_flow.local_address
+         or flow.remote_address != expected_flow.remote_address ) {
+      ostringstream ss;
+      ss << "Parsing in place differs from parsing a copy, for a " << msg.sender.payload.size()
+         << "-byte payload split into " << buffers.size() << " buffers\n";
+      throw runtime_error( ss.str() );
+    }
+
+    // (short strings live inside the string object, so only longer payloads keep their buffer)
+    if ( attempt == 0 and msg.sender.payload.size() > 15 and actual->sender.payload.data() != payload_buffer ) {
+      throw runtime_error( "Expected the payload to be handed over in the buffer it was read into" );
+    }
+  }
+}
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    TCPOverIPv4Adapter sender;
+    sender.config_mut().source = Address { "169.254.144.1", 6001 };
+    sender.config_mut().destination = Address { "169.254.144.9", 9090 };
+
+    for ( unsigned int i = 0; i < 2000; i++ ) {
+      TCPMessage msg;
+      msg.sender.seqno = Wrap32 { static_cast<uint32_t>( rd() ) };
+      msg.sender.SYN = rd() % 2;
+      msg.sender.FIN = rd() % 2;
+      msg.sender.payload = string( i % 7 == 0 ? 0 : rd() % 1500, 0 );
+      for ( auto& c : msg.sender.payload ) {
+        c = static_cast<char>( rd() );
+      }
+      if ( rd() % 2 ) {
+        msg.receiver.ackno = Wrap32 { static_cast<uint32_t>( rd() ) };
+      }
+      msg.receiver.window_size = rd();
+      msg.sender.SACK_permitted = msg.sender.SYN and rd() % 2;
+      if ( rd() % 2 ) {
+        msg.sender.window_scale = rd() % ( TCPConfig::MAX_WINDOW_SCALE + 1 );
+      }
+      msg.receiver.sack.resize( rd() % ( TCPReceiverMessage::MAX_SACK_BLOCKS + 1 ) );
+      for ( auto& block : msg.receiver.sack ) {
+        block = { Wrap32 { static_cast<uint32_t>( rd() ) }, Wrap32 { static_cast<uint32_t>( rd() ) } };
+      }
+      check_in_place( sender, msg, rd );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
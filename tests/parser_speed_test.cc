@@ -0,0 +1,121 @@
+#include "arp_message.hh"
+#include "ethernet_header.hh"
+#include "ipv4_datagram.hh"
+#include "tcp_segment.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+// Join serialized buffers, then either keep them as one buffer or cut them into `piece_len`-byte pieces
+vector<string> layout( const vector<string>& buffers, size_t piece_len )
+{
+  string joined;
+  for ( const auto& b : buffers ) {
+    joined += b;
+  }
+  if ( piece_len == 0 ) {
+    return { joined };
+  }
+  vector<string> pieces;
+  for ( size_t i = 0; i < joined.size(); i += piece_len ) {
+    pieces.push_back( joined.substr( i, piece_len ) );
+  }
+  return pieces;
+}
+
+template<class T, typename... Targs>
+void speed_test( const string& name,
+                 const vector<string>& input,
+                 const size_t iterations,
+                 const bool fragmented,
+                 Targs&&... args )
+{
+  size_t parsed = 0;
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < iterations; ++i ) {
+    T obj;
+    parsed += parse( obj, input, args... );
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( parsed != iterations ) {
+    throw runtime_error( "Failed to parse " + name );
+  }
+
+  const auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  const auto headers_per_second = static_cast<double>( iterations ) / test_duration.count();
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  const string layout_name = fragmented ? "fragmented" : "contiguous";
+  cout << "Parsing " << name << " (" << layout_name << ") reached " << fixed << setprecision( 2 )
+       << headers_per_second / 1e6 << " M headers/s.\n";
+  debug_output << "             " << name << " parse rate (" << layout_name << "): " << fixed << setprecision( 2 )
+               << headers_per_second / 1e6 << " M headers/s\n";
+}
+
+void program_body()
+{
+  const size_t iterations = 1000000;
+
+  EthernetHeader eth { { 0x02, 0, 0, 0, 0, 1 }, { 0x02, 0, 0, 0, 0, 2 }, EthernetHeader::TYPE_IPv4 };
+
+  ARPMessage arp;
+  arp.opcode = ARPMessage::OPCODE_REPLY;
+  arp.sender_ethernet_address = eth.src;
+  arp.sender_ip_address = 0x0a000001;
+  arp.target_ethernet_address = eth.dst;
+  arp.target_ip_address = 0x0a000002;
+
+  TCPSegment seg;
+  seg.udinfo = { 40000, 80, 0 };
+  seg.message.sender.seqno = Wrap32 { 12345 };
+  seg.message.receiver.ackno = Wrap32 { 67890 };
+  seg.message.receiver.window_size = 65000;
+  seg.message.sender.payload = string( 16, 'x' );
+
+  IPv4Datagram dgram;
+  dgram.header.src = 0x0a000001;
+  dgram.header.dst = 0x0a000002;
+  dgram.header.len = IPv4Header::LENGTH + 20 + seg.message.sender.payload.size();
+  dgram.header.compute_checksum();
+  seg.compute_checksum( dgram.header.pseudo_checksum() );
+  dgram.payload = serialize( seg );
+
+  for ( const size_t piece_len : { 0, 3 } ) {
+    const bool fragmented = piece_len != 0;
+    speed_test<EthernetHeader>( "Ethernet header", layout( serialize( eth ), piece_len ), iterations, fragmented );
+    speed_test<ARPMessage>( "ARP message", layout( serialize( arp ), piece_len ), iterations, fragmented );
+    speed_test<IPv4Datagram>( "IPv4 datagram", layout( serialize( dgram ), piece_len ), iterations, fragmented );
+    speed_test<TCPSegment>( "TCP segment",
+                            layout( serialize( seg ), piece_len ),
+                            iterations,
+                            fragmented,
+                            dgram.header.pseudo_checksum() );
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
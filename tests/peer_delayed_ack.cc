@@ -0,0 +1,170 @@
+#include "random.hh"
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+constexpr uint16_t ACK_DELAY = 40;
+
+// A sends, B (delaying its ACKs) receives; their segments wait in `from_a` and `from_b` until delivered
+struct PeerPair
+{
+  TCPConfig a_config;
+  TCPConfig b_config;
+  TCPPeer a { a_config };
+  TCPPeer b { b_config };
+  vector<TCPMessage> from_a {};
+  vector<TCPMessage> from_b {};
+  TCPPeer::TransmitFunction a_out { [this]( TCPMessage msg ) { from_a.push_back( move( msg ) ); } };
+  TCPPeer::TransmitFunction b_out { [this]( TCPMessage msg ) { from_b.push_back( move( msg ) ); } };
+
+  PeerPair( const TCPConfig& a_cfg, const TCPConfig& b_cfg ) : a_config( a_cfg ), b_config( b_cfg )
+  {
+    a.push( a_out );
+    to_b( take_from_a() );
+    auto syn_ack = take_from_b();
+    if ( syn_ack.size() != 1 ) {
+      throw runtime_error( "B should have answered the SYN at once" );
+    }
+    to_a( move( syn_ack ) );
+    to_b( take_from_a() );
+    expect_acks( "the ACK of B's SYN", 0, 0 );
+  }
+
+  vector<TCPMessage> take_from_a() { return exchange( from_a, {} ); }
+  vector<TCPMessage> take_from_b() { return exchange( from_b, {} ); }
+
+  void to_a( vector<TCPMessage> segments )
+  {
+    for ( auto& msg : segments ) {
+      a.receive( move( msg ), a_out );
+    }
+  }
+
+  void to_b( vector<TCPMessage> segments )
+  {
+    for ( auto& msg : segments ) {
+      b.receive( move( msg ), b_out );
+    }
+  }
+
+  // A writes `segments` full segments and sends them (held back, to be delivered one at a time)
+  vector<TCPMessage> send_from_a( size_t segments )
+  {
+    a.outbound_writer().push( string( segments * TCPConfig::MAX_PAYLOAD_SIZE, 'x' ) );
+    a.push( a_out );
+    auto sent = take_from_a();
+    if ( sent.size() != segments ) {
+      throw runtime_error( "A should have sent " + to_string( segments ) + " segments" );
+    }
+    return sent;
+  }
+
+  // B should have sent `count` segments since the last check, the last acknowledging `bytes` of A's stream
+  void expect_acks( const string& after, size_t count, uint64_t bytes )
+  {
+    auto sent = take_from_b();
+    if ( sent.size() != count ) {
+      throw runtime_error( "after " + after + ", B should have sent " + to_string( count ) + " segments, not "
+                           + to_string( sent.size() ) );
+    }
+    if ( count > 0 and sent.back().receiver.ackno != a_config.isn + 1 + bytes ) {
+      throw runtime_error( "after " + after + ", B should have acknowledged " + to_string( bytes ) + " bytes" );
+    }
+  }
+};
+
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+    TCPConfig a_config;
+    a_config.isn = Wrap32 { static_cast<uint32_t>( rd() ) };
+    TCPConfig b_config;
+    b_config.isn = Wrap32 { static_cast<uint32_t>( rd() ) };
+    b_config.ack_delay = ACK_DELAY;
+
+    {
+      PeerPair peers { a_config, b_config };
+      auto data = peers.send_from_a( 6 );
+
+      // every second segment of in-order data is acknowledged at once
+      peers.to_b( { move( data[0] ) } );
+      peers.expect_acks( "one segment", 0, 0 );
+      peers.to_b( { move( data[1] ) } );
+      peers.expect_acks( "a second segment", 1, 2 * mss );
+
+      // ... and a lone one by the deadline
+      peers.to_b( { move( data[2] ) } );
+      peers.b.tick( ACK_DELAY - 1, peers.b_out );
+      peers.expect_acks( "a third segment, before the deadline", 0, 0 );
+      peers.b.tick( 1, peers.b_out );
+      peers.expect_acks( "a third segment, at the deadline", 1, 3 * mss );
+
+      // ... or by data B sends before then, which carries the ACK
+      peers.to_b( { move( data[3] ) } );
+      peers.b.outbound_writer().push( "reply" );
+      peers.b.push( peers.b_out );
+      peers.expect_acks( "data from B", 1, 4 * mss );
+      peers.b.tick( ACK_DELAY, peers.b_out );
+      peers.expect_acks( "the deadline, with the ACK already sent", 0, 0 );
+
+      // out-of-order data is acknowledged at once, and so is the data that fills the gap
+      peers.to_b( { move( data[5] ) } );
+      peers.expect_acks( "out-of-order data", 1, 4 * mss );
+      peers.to_b( { move( data[4] ) } );
+      peers.expect_acks( "data filling a gap", 1, 6 * mss );
+
+      // a FIN is acknowledged at once
+      peers.a.outbound_writer().close();
+      peers.a.push( peers.a_out );
+      peers.to_b( peers.take_from_a() );
+      peers.expect_acks( "a FIN", 1, 6 * mss + 1 );
+    }
+
+    {
+      // data that fills the window offered is acknowledged at once, so that the sender can go on
+      TCPConfig small_window = b_config;
+      small_window.recv_capacity = 3 * mss;
+      PeerPair peers { a_config, small_window };
+      auto data = peers.send_from_a( 3 );
+      peers.to_b( { move( data[0] ) } );
+      peers.expect_acks( "one segment", 0, 0 );
+      peers.to_b( { move( data[1] ) } );
+      peers.expect_acks( "a second segment", 1, 2 * mss );
+      peers.to_b( { move( data[2] ) } );
+      peers.expect_acks( "a segment reaching the end of the window", 1, 3 * mss );
+    }
+
+    {
+      // without ack_delay, every segment is acknowledged at once
+      TCPConfig no_delay = b_config;
+      no_delay.ack_delay = 0;
+      PeerPair peers { a_config, no_delay };
+      auto data = peers.send_from_a( 2 );
+      peers.to_b( { move( data[0] ) } );
+      peers.expect_acks( "one segment", 1, mss );
+      peers.to_b( { move( data[1] ) } );
+      peers.expect_acks( "a second segment", 1, 2 * mss );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,94 @@
+#include "random.hh"
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+void deliver( vector<TCPMessage>& segments, TCPPeer& peer, const TCPPeer::TransmitFunction& reply )
+{
+  vector<TCPMessage> arriving = move( segments );
+  segments.clear();
+  for ( auto& msg : arriving ) {
+    peer.receive( move( msg ), reply );
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    // Both peers send data: the ones from B repeat the ackno and window of B's last ACK, but they carry data, so
+    // they are not duplicate ACKs (RFC 5681) and must not make A retransmit. Three empty ones do.
+    TCPConfig a_config;
+    a_config.isn = Wrap32 { static_cast<uint32_t>( rd() ) };
+    a_config.fast_retransmit = true;
+    TCPConfig b_config = a_config;
+    b_config.isn = Wrap32 { static_cast<uint32_t>( rd() ) };
+
+    TCPPeer a { a_config };
+    TCPPeer b { b_config };
+    vector<TCPMessage> from_a;
+    vector<TCPMessage> from_b;
+    const TCPPeer::TransmitFunction a_out = [&]( TCPMessage msg ) { from_a.push_back( move( msg ) ); };
+    const TCPPeer::TransmitFunction b_out = [&]( TCPMessage msg ) { from_b.push_back( move( msg ) ); };
+
+    a.push( a_out );
+    deliver( from_a, b, b_out );
+    deliver( from_b, a, a_out );
+    deliver( from_a, b, b_out );
+    if ( not from_b.empty() or not a.has_ackno() or not b.has_ackno() ) {
+      throw runtime_error( "the handshake did not complete" );
+    }
+
+    a.outbound_writer().push( string( 4 * TCPConfig::MAX_PAYLOAD_SIZE, 'a' ) );
+    a.push( a_out );
+    vector<TCPMessage> a_data = move( from_a );
+    from_a.clear();
+    if ( a_data.size() != 4 ) {
+      throw runtime_error( "A should have sent four segments of data" );
+    }
+
+    b.outbound_writer().push( string( 4 * TCPConfig::MAX_PAYLOAD_SIZE, 'b' ) );
+    b.push( b_out );
+    if ( from_b.size() != 4 ) {
+      throw runtime_error( "B should have sent four segments of data" );
+    }
+    deliver( from_b, a, a_out );
+    for ( const auto& msg : from_a ) {
+      if ( not msg.sender.payload.empty() ) {
+        throw runtime_error( "A retransmitted after data segments that repeated an ackno" );
+      }
+    }
+    from_a.clear();
+
+    // the first segment from A is lost: B's three empty duplicate ACKs make A retransmit it
+    for ( size_t i = 1; i < a_data.size(); ++i ) {
+      b.receive( move( a_data[i] ), b_out );
+    }
+    if ( from_b.size() != 3 ) {
+      throw runtime_error( "B should have sent three duplicate ACKs" );
+    }
+    deliver( from_b, a, a_out );
+    if ( from_a.size() != 1 or from_a.front().sender.seqno != a_data.front().sender.seqno
+         or from_a.front().sender.payload.size() != TCPConfig::MAX_PAYLOAD_SIZE ) {
+      throw runtime_error( "A should have retransmitted its first segment after three duplicate ACKs" );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -145,6 +145,34 @@ int main()
       test.execute( ReadAll( "c" ) );
       test.execute( IsFinished { true } );
     }
+
+    {
+      ReassemblerTestHarness test { "bitmap engine wraps around its ring", 3, Reassembler::Engine::Bitmap };
+
+      test.execute( Insert { "a", 0 } );
+      test.execute( ReadAll( "a" ) );
+
+      test.execute( Insert { "cd", 2 } );
+      test.execute( BytesPushed( 1 ) );
+      test.execute( BytesPending( 2 ) );
+
+      test.execute( Insert { "bcd", 1 } );
+      test.execute( BytesPushed( 4 ) );
+      test.execute( BytesPending( 0 ) );
+      test.execute( ReadAll( "bcd" ) );
+
+      test.execute( Insert { "fgh", 5 }.is_last() );
+      test.execute( BytesPending( 2 ) );
+      test.execute( Insert { "e", 4 } );
+      test.execute( BytesPushed( 7 ) );
+      test.execute( BytesPending( 0 ) );
+      test.execute( ReadAll( "efg" ) );
+      test.execute( IsFinished { false } );
+
+      test.execute( Insert { "h", 7 }.is_last() );
+      test.execute( ReadAll( "h" ) );
+      test.execute( IsFinished { true } );
+    }
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << endl;
     return EXIT_FAILURE;
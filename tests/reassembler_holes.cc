@@ -129,6 +129,31 @@ int main()
       test.execute( ReadAll( "" ) );
       test.execute( IsFinished { true } );
     }
+
+    for ( const auto engine : { Reassembler::Engine::Map, Reassembler::Engine::Bitmap } ) {
+      ReassemblerTestHarness test { "holes as pending ranges", 20, engine };
+
+      test.execute( Insert { "cd", 2 } );
+      test.execute( PendingRanges { { { 2, 4 } } } );
+      test.execute( Insert { "hij", 7 } );
+      test.execute( PendingRanges { { { 2, 4 }, { 7, 10 } } } );
+      test.execute( Insert { "efg", 4 } );
+      test.execute( PendingRanges { { { 2, 10 } } } );
+      test.execute( Insert { "s", 18 } );
+      test.execute( PendingRanges { { { 2, 10 }, { 18, 19 } } } );
+
+      test.execute( Insert { "ab", 0 } );
+      test.execute( BytesPushed( 10 ) );
+      test.execute( PendingRanges { { { 18, 19 } } } );
+
+      // (the bitmap engine's ring wraps here)
+      test.execute( ReadAll( "abcdefghij" ) );
+      test.execute( Insert { "vw", 21 } );
+      test.execute( Insert { "yz", 24 } );
+      test.execute( PendingRanges { { { 18, 19 }, { 21, 23 }, { 24, 26 } } } );
+      test.execute( Insert { "klmnopqr", 10 } );
+      test.execute( PendingRanges { { { 21, 23 }, { 24, 26 } } } );
+    }
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << endl;
     return EXIT_FAILURE;
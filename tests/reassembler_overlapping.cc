@@ -286,6 +286,23 @@ int main()
       test.execute( BytesPushed( 27 ) );
       test.execute( ReadAll( "I am sentient, hello world!" ) );
     }
+
+    {
+      ReassemblerTestHarness test { "longer segment at same index replaces stored one", 30 };
+
+      test.execute( Insert { "cd", 2 } );
+      test.execute( Insert { "gh", 6 } );
+      test.execute( BytesPending( 4 ) );
+      test.execute( Insert { "cdefgh", 2 } );
+      test.execute( BytesPending( 6 ) );
+      test.execute( Insert { "bcdefghij", 1 } );
+      test.execute( BytesPending( 9 ) );
+      test.execute( Insert { "e", 4 } );
+      test.execute( BytesPending( 9 ) );
+      test.execute( Insert { "a", 0 } );
+      test.execute( BytesPending( 0 ) );
+      test.execute( ReadAll( "abcdefghij" ) );
+    }
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << endl;
     return EXIT_FAILURE;
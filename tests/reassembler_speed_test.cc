@@ -8,18 +8,42 @@
 #include <iostream>
 #include <queue>
 #include <random>
+#include <string_view>
 #include <tuple>
+#include <vector>
 
 using namespace std;
 using namespace std::chrono;
 
-void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-parameters)
+enum class Pattern
+{
+  InOrder,    // MSS-sized segments, in order
+  Reordered,  // MSS-sized segments, shuffled within groups of eight
+  Overlapping // segments twice the capacity long, starting one byte apart and out of order
+};
+
+string_view pattern_name( Pattern pattern )
+{
+  switch ( pattern ) {
+    case Pattern::InOrder:
+      return "in-order";
+    case Pattern::Reordered:
+      return "reordered";
+    case Pattern::Overlapping:
+      return "overlapping";
+  }
+  return {};
+}
+
+void speed_test( const Pattern pattern,
+                 const Reassembler::Engine engine,
+                 const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-parameters)
                  const size_t capacity,     // NOLINT(bugprone-easily-swappable-parameters)
                  const size_t random_seed ) // NOLINT(bugprone-easily-swappable-parameters)
 {
   // Generate the data to be written
+  default_random_engine rd { random_seed };
   const string data = [&] {
-    default_random_engine rd { random_seed };
     uniform_int_distribution<char> ud;
     string ret;
     for ( size_t i = 0; i < num_chunks * capacity; ++i ) {
@@ -30,13 +54,28 @@ void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-
 
   // Split the data into segments before writing
   queue<tuple<uint64_t, string, bool>> split_data;
-  for ( size_t i = 0; i < data.size(); i += capacity ) {
-    split_data.emplace( i + 2, data.substr( i + 2, capacity * 2 ), i + 2 + capacity * 2 >= data.size() );
-    split_data.emplace( i, data.substr( i, capacity * 2 ), i + capacity * 2 >= data.size() );
-    split_data.emplace( i + 1, data.substr( i + 1, capacity * 2 ), i + 1 + capacity * 2 >= data.size() );
+  if ( pattern == Pattern::Overlapping ) {
+    for ( size_t i = 0; i < data.size(); i += capacity ) {
+      split_data.emplace( i + 2, data.substr( i + 2, capacity * 2 ), i + 2 + capacity * 2 >= data.size() );
+      split_data.emplace( i, data.substr( i, capacity * 2 ), i + capacity * 2 >= data.size() );
+      split_data.emplace( i + 1, data.substr( i + 1, capacity * 2 ), i + 1 + capacity * 2 >= data.size() );
+    }
+  } else {
+    const size_t segment_size = 1460;
+    const size_t group_size = pattern == Pattern::Reordered ? 8 : 1;
+    for ( size_t group = 0; group < data.size(); group += segment_size * group_size ) {
+      vector<size_t> starts;
+      for ( size_t i = group; i < min( data.size(), group + segment_size * group_size ); i += segment_size ) {
+        starts.push_back( i );
+      }
+      shuffle( starts.begin(), starts.end(), rd );
+      for ( const auto i : starts ) {
+        split_data.emplace( i, data.substr( i, segment_size ), i + segment_size >= data.size() );
+      }
+    }
   }
 
-  Reassembler reassembler { ByteStream { capacity } };
+  Reassembler reassembler { ByteStream { capacity }, engine };
 
   string output_data;
   output_data.reserve( data.size() );
@@ -71,11 +110,14 @@ void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-
   fstream debug_output;
   debug_output.open( "/dev/tty" );
 
-  cout << "Reassembler to ByteStream with capacity=" << capacity << " reached " << fixed << setprecision( 2 )
+  const string_view engine_name = engine == Reassembler::Engine::Map ? "map" : "bitmap";
+
+  cout << "Reassembler (" << engine_name << ", " << pattern_name( pattern )
+       << ") to ByteStream with capacity=" << capacity << " reached " << fixed << setprecision( 2 )
        << gigabits_per_second << " Gbit/s.\n";
 
-  debug_output << "             Reassembler throughput: " << fixed << setprecision( 2 ) << gigabits_per_second
-               << " Gbit/s\n";
+  debug_output << "             Reassembler throughput (" << engine_name << ", " << pattern_name( pattern )
+               << "): " << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s\n";
 
   if ( gigabits_per_second < 0.1 ) {
     throw runtime_error( "Reassembler did not meet minimum speed of 0.1 Gbit/s." );
@@ -84,7 +126,11 @@ void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-
 
 void program_body()
 {
-  speed_test( 10000, 1500, 1370 );
+  for ( const auto engine : { Reassembler::Engine::Map, Reassembler::Engine::Bitmap } ) {
+    speed_test( Pattern::InOrder, engine, 64, 65536, 1370 );
+    speed_test( Pattern::Reordered, engine, 64, 65536, 1370 );
+    speed_test( Pattern::Overlapping, engine, 10000, 1500, 1370 );
+  }
 }
 
 int main()
@@ -0,0 +1,329 @@
+#include "exception.hh"
+#include "reassembler.hh"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace std::chrono;
+
+// Sweeps the Reassembler over capacity, segment size, reorder depth, duplicate ratio and loss.
+//
+// Usage: reassembler_sweep_speed_test [--full] [--csv FILE] [--seed N] [--bytes N] [--engine LIST]
+//          [--capacity LIST] [--segment LIST] [--reorder LIST] [--dup LIST] [--loss LIST]
+//
+// LIST is comma-separated, and every combination is run. With no arguments, a quick sweep suited to ctest runs.
+// Each run happens in a forked child, so the peak RSS reported is that run's alone (input segments included).
+
+namespace {
+
+// A Reassembler implementation under test
+struct Implementation
+{
+  string name;
+  function<Reassembler( ByteStream&& )> make;
+};
+
+const vector<Implementation>& implementations()
+{
+  static const vector<Implementation> all {
+    { "map", []( ByteStream&& output ) { return Reassembler { move( output ), Reassembler::Engine::Map }; } },
+    { "bitmap", []( ByteStream&& output ) { return Reassembler { move( output ), Reassembler::Engine::Bitmap }; } },
+  };
+  return all;
+}
+
+struct Scenario
+{
+  string engine;
+  uint64_t capacity;
+  uint64_t segment_size;  // clamped to the capacity, since a sender never sends past the receive window
+  uint64_t reorder_depth; // segments are shuffled within consecutive groups of this many
+  double dup_ratio;       // chance a segment is delivered again, up to `reorder_depth` segments later
+  double loss;            // chance a segment is lost, and retransmitted once the rest of its flight is sent
+  uint64_t bytes;
+  uint64_t seed;
+};
+
+struct Result
+{
+  double seconds;
+  uint64_t inserts;
+  long peak_rss_kib;
+};
+
+// The order the receiver sees segments in. The sender sends one window ("flight") at a time, so every
+// segment lies inside the window by the time it arrives.
+vector<tuple<uint64_t, string, bool>> make_segments( const Scenario& s,
+                                                     const string& data,
+                                                     default_random_engine& rd )
+{
+  const uint64_t segment_size = min( s.segment_size, s.capacity );
+  uniform_real_distribution<double> chance;
+  vector<tuple<uint64_t, string, bool>> segments;
+  auto deliver = [&]( uint64_t first ) {
+    const uint64_t last = min( first + segment_size, static_cast<uint64_t>( data.size() ) );
+    segments.emplace_back( first, data.substr( first, last - first ), last == data.size() );
+  };
+
+  for ( uint64_t flight = 0; flight < data.size(); flight += s.capacity ) {
+    const uint64_t flight_end = min( flight + s.capacity, static_cast<uint64_t>( data.size() ) );
+    vector<uint64_t> starts;
+    for ( uint64_t i = flight; i < flight_end; i += segment_size ) {
+      starts.push_back( i );
+    }
+    for ( size_t group = 0; group < starts.size(); group += s.reorder_depth ) {
+      const size_t group_end = min( group + s.reorder_depth, starts.size() );
+      shuffle( starts.begin() + group, starts.begin() + group_end, rd );
+    }
+
+    vector<uint64_t> lost;
+    vector<pair<uint64_t, uint64_t>> duplicates; // segments still to go before the copy, first index
+    for ( const auto first : starts ) {
+      if ( chance( rd ) < s.loss ) {
+        lost.push_back( first );
+      } else {
+        deliver( first );
+      }
+      for ( auto it = duplicates.begin(); it != duplicates.end(); ) {
+        if ( --it->first == 0 ) {
+          deliver( it->second );
+          it = duplicates.erase( it );
+        } else {
+          ++it;
+        }
+      }
+      if ( chance( rd ) < s.dup_ratio ) {
+        duplicates.emplace_back( 1 + rd() % s.reorder_depth, first );
+      }
+    }
+    for ( const auto& [countdown, first] : duplicates ) {
+      deliver( first );
+    }
+    for ( const auto first : lost ) {
+      deliver( first );
+    }
+  }
+  return segments;
+}
+
+Result run( const Scenario& s )
+{
+  default_random_engine rd { s.seed };
+  string data( s.bytes, 0 );
+  generate( data.begin(), data.end(), [&] { return static_cast<char>( rd() ); } );
+  auto segments = make_segments( s, data, rd );
+
+  const auto& impl = *find_if( implementations().begin(), implementations().end(), [&]( const auto& i ) {
+    return i.name == s.engine;
+  } );
+  Reassembler reassembler = impl.make( ByteStream { s.capacity } );
+
+  string output_data;
+  output_data.reserve( data.size() );
+
+  const auto start_time = steady_clock::now();
+  for ( auto& [first, payload, last] : segments ) {
+    reassembler.insert( first, move( payload ), last );
+    while ( reassembler.reader().bytes_buffered() ) {
+      output_data += reassembler.reader().peek();
+      reassembler.reader().pop( output_data.size() - reassembler.reader().bytes_popped() );
+    }
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( not reassembler.reader().is_finished() ) {
+    throw runtime_error( "Reassembler did not close ByteStream when finished" );
+  }
+  if ( data != output_data ) {
+    throw runtime_error( "Mismatch between data written and read" );
+  }
+
+  return { duration_cast<duration<double>>( stop_time - start_time ).count(), segments.size(), 0 };
+}
+
+// Run the scenario in a child process, so that its peak RSS can be read back separately.
+Result run_isolated( const Scenario& s )
+{
+  array<int, 2> fds {};
+  CheckSystemCall( "pipe", ::pipe( fds.data() ) );
+  const pid_t pid = CheckSystemCall( "fork", ::fork() );
+  if ( pid == 0 ) {
+    ::close( fds[0] );
+    try {
+      const Result result = run( s );
+      if ( ::write( fds[1], &result, sizeof( result ) ) != sizeof( result ) ) {
+        _exit( EXIT_FAILURE );
+      }
+      _exit( EXIT_SUCCESS );
+    } catch ( const exception& e ) {
+      cerr << "Exception: " << e.what() << "\n";
+      _exit( EXIT_FAILURE );
+    }
+  }
+
+  ::close( fds[1] );
+  Result result {};
+  const auto len = ::read( fds[0], &result, sizeof( result ) );
+  ::close( fds[0] );
+
+  int status {};
+  rusage usage {};
+  CheckSystemCall( "wait4", ::wait4( pid, &status, 0, &usage ) );
+  if ( len != sizeof( result ) or not WIFEXITED( status ) or WEXITSTATUS( status ) != EXIT_SUCCESS ) {
+    throw runtime_error( "run failed: engine=" + s.engine + " capacity=" + to_string( s.capacity ) );
+  }
+  result.peak_rss_kib = usage.ru_maxrss;
+  return result;
+}
+
+template<typename T>
+vector<T> parse_list( const string& arg )
+{
+  vector<T> values;
+  stringstream ss { arg };
+  for ( string item; getline( ss, item, ',' ); ) {
+    if constexpr ( is_same_v<T, string> ) {
+      values.push_back( item );
+    } else if constexpr ( is_floating_point_v<T> ) {
+      values.push_back( stod( item ) );
+    } else {
+      values.push_back( stoull( item ) );
+    }
+  }
+  return values;
+}
+
+void program_body( const vector<string>& args )
+{
+  vector<string> engines;
+  for ( const auto& impl : implementations() ) {
+    engines.push_back( impl.name );
+  }
+  vector<uint64_t> capacities { 1024, 65536, 1048576 };
+  vector<uint64_t> segment_sizes { 1460 };
+  vector<uint64_t> reorder_depths { 1, 16 };
+  vector<double> dup_ratios { 0, 0.25 };
+  vector<double> losses { 0, 0.02 };
+  uint64_t bytes = 4 << 20;
+  uint64_t seed = 1370;
+  optional<string> csv_path;
+
+  for ( size_t i = 0; i < args.size(); ++i ) {
+    const string& flag = args[i];
+    if ( flag == "--full" ) {
+      capacities = { 1 << 10, 1 << 12, 1 << 14, 1 << 16, 1 << 18, 1 << 20, 1 << 22, 1 << 24 };
+      segment_sizes = { 536, 1460, 8960 };
+      reorder_depths = { 1, 8, 64 };
+      dup_ratios = { 0, 0.25 };
+      losses = { 0, 0.02 };
+      bytes = 32 << 20;
+      continue;
+    }
+    if ( i + 1 == args.size() ) {
+      throw runtime_error( "missing value for " + flag );
+    }
+    const string& value = args[++i];
+    if ( flag == "--csv" ) {
+      csv_path = value;
+    } else if ( flag == "--seed" ) {
+      seed = stoull( value );
+    } else if ( flag == "--bytes" ) {
+      bytes = stoull( value );
+    } else if ( flag == "--engine" ) {
+      engines = parse_list<string>( value );
+    } else if ( flag == "--capacity" ) {
+      capacities = parse_list<uint64_t>( value );
+    } else if ( flag == "--segment" ) {
+      segment_sizes = parse_list<uint64_t>( value );
+    } else if ( flag == "--reorder" ) {
+      reorder_depths = parse_list<uint64_t>( value );
+    } else if ( flag == "--dup" ) {
+      dup_ratios = parse_list<double>( value );
+    } else if ( flag == "--loss" ) {
+      losses = parse_list<double>( value );
+    } else {
+      throw runtime_error( "unknown option " + flag );
+    }
+  }
+
+  for ( const auto& engine : engines ) {
+    if ( none_of( implementations().begin(), implementations().end(), [&]( const auto& impl ) {
+           return impl.name == engine;
+         } ) ) {
+      throw runtime_error( "unknown engine " + engine );
+    }
+  }
+  if ( find( reorder_depths.begin(), reorder_depths.end(), 0 ) != reorder_depths.end()
+       or find( capacities.begin(), capacities.end(), 0 ) != capacities.end()
+       or find( segment_sizes.begin(), segment_sizes.end(), 0 ) != segment_sizes.end() ) {
+    throw runtime_error( "capacity, segment size and reorder depth must be positive" );
+  }
+
+  ofstream csv;
+  if ( csv_path.has_value() ) {
+    csv.open( csv_path.value() );
+    csv << "engine,capacity,segment_size,reorder_depth,dup_ratio,loss,seed,bytes,inserts,seconds,gbit_per_s,"
+           "ns_per_insert,peak_rss_kib\n";
+  }
+
+  for ( const auto capacity : capacities ) {
+    for ( const auto segment_size : segment_sizes ) {
+      for ( const auto reorder_depth : reorder_depths ) {
+        for ( const auto dup_ratio : dup_ratios ) {
+          for ( const auto loss : losses ) {
+            for ( const auto& engine : engines ) {
+              const Scenario s { engine, capacity, segment_size, reorder_depth, dup_ratio, loss, bytes, seed };
+              const Result r = run_isolated( s );
+              const double gigabits_per_second = 8 * static_cast<double>( bytes ) / r.seconds / 1e9;
+              const double ns_per_insert = r.seconds * 1e9 / static_cast<double>( r.inserts );
+
+              cout << "Reassembler (" << engine << ") capacity=" << capacity << " segment=" << segment_size
+                   << " reorder=" << reorder_depth << " dup=" << dup_ratio << " loss=" << loss << ": " << fixed
+                   << setprecision( 2 ) << gigabits_per_second << " Gbit/s, " << setprecision( 0 ) << ns_per_insert
+                   << " ns/insert, peak RSS " << r.peak_rss_kib << " KiB\n"
+                   << defaultfloat << setprecision( 6 );
+
+              if ( csv.is_open() ) {
+                csv << engine << "," << capacity << "," << segment_size << "," << reorder_depth << "," << dup_ratio
+                    << "," << loss << "," << seed << "," << bytes << "," << r.inserts << "," << r.seconds << ","
+                    << gigabits_per_second << "," << ns_per_insert << "," << r.peak_rss_kib << "\n";
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+  try {
+    program_body( { argv + 1, argv + argc } );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -6,7 +6,9 @@
 
 #include <optional>
 #include <sstream>
+#include <string>
 #include <utility>
+#include <vector>
 
 template<std::derived_from<TestStep<ByteStream>> T>
 struct ReassemblerTestStep : public TestStep<Reassembler>
@@ -27,10 +29,13 @@ struct ReassemblerTestStep : public TestStep<Reassembler>
 class ReassemblerTestHarness : public TestHarness<Reassembler>
 {
 public:
-  ReassemblerTestHarness( std::string test_name, uint64_t capacity )
+  ReassemblerTestHarness( std::string test_name,
+                          uint64_t capacity,
+                          Reassembler::Engine engine = Reassembler::Engine::Map )
     : TestHarness( move( test_name ),
-                   "capacity=" + std::to_string( capacity ),
-                   { Reassembler { ByteStream { capacity } } } )
+                   "capacity=" + std::to_string( capacity )
+                     + ( engine == Reassembler::Engine::Bitmap ? ", engine=bitmap" : "" ),
+                   { Reassembler { ByteStream { capacity }, engine } } )
   {}
 
   template<std::derived_from<TestStep<ByteStream>> T>
@@ -49,6 +54,33 @@ struct BytesPending : public ConstExpectNumber<Reassembler, uint64_t>
   uint64_t value( const Reassembler& r ) const override { return r.bytes_pending(); }
 };
 
+struct PendingRanges : public Expectation<Reassembler>
+{
+  std::vector<std::pair<uint64_t, uint64_t>> ranges_;
+
+  explicit PendingRanges( std::vector<std::pair<uint64_t, uint64_t>> ranges ) : ranges_( std::move( ranges ) ) {}
+
+  static std::string describe( const std::vector<std::pair<uint64_t, uint64_t>>& ranges )
+  {
+    std::ostringstream ss;
+    for ( const auto& [first, last] : ranges ) {
+      ss << " [" << first << ", " << last << ")";
+    }
+    return ranges.empty() ? " (none)" : ss.str();
+  }
+
+  std::string description() const override { return "pending ranges" + describe( ranges_ ); }
+
+  void execute( Reassembler& r ) const override
+  {
+    const auto actual = r.pending_ranges();
+    if ( actual != ranges_ ) {
+      throw ExpectationViolation( "The Reassembler should have had pending ranges" + describe( ranges_ )
+                                  + ", but instead it had" + describe( actual ) );
+    }
+  }
+};
+
 struct Insert : public Action<Reassembler>
 {
   std::string data_;
@@ -19,28 +19,30 @@ int main()
   try {
     auto rd = get_random_engine();
 
-    // overlapping segments
-    for ( unsigned rep_no = 0; rep_no < NREPS; ++rep_no ) {
-      ReassemblerTestHarness sr { "win test " + to_string( rep_no ), NSEGS * MAX_SEG_LEN };
-
-      vector<tuple<size_t, size_t>> seq_size;
-      size_t offset = 0;
-      for ( unsigned i = 0; i < NSEGS; ++i ) {
-        const size_t size = 1 + ( rd() % ( MAX_SEG_LEN - 1 ) );
-        const size_t offs = min( offset, 1 + ( static_cast<size_t>( rd() ) % 1023 ) );
-        seq_size.emplace_back( offset - offs, size + offs );
-        offset += size;
+    for ( const auto engine : { Reassembler::Engine::Map, Reassembler::Engine::Bitmap } ) {
+      // overlapping segments
+      for ( unsigned rep_no = 0; rep_no < NREPS; ++rep_no ) {
+        ReassemblerTestHarness sr { "win test " + to_string( rep_no ), NSEGS * MAX_SEG_LEN, engine };
+
+        vector<tuple<size_t, size_t>> seq_size;
+        size_t offset = 0;
+        for ( unsigned i = 0; i < NSEGS; ++i ) {
+          const size_t size = 1 + ( rd() % ( MAX_SEG_LEN - 1 ) );
+          const size_t offs = min( offset, 1 + ( static_cast<size_t>( rd() ) % 1023 ) );
+          seq_size.emplace_back( offset - offs, size + offs );
+          offset += size;
+        }
+        shuffle( seq_size.begin(), seq_size.end(), rd );
+
+        string d( offset, 0 );
+        generate( d.begin(), d.end(), [&] { return rd(); } );
+
+        for ( auto [off, sz] : seq_size ) {
+          sr.execute( Insert { d.substr( off, sz ), off }.is_last( off + sz == offset ) );
+        }
+
+        sr.execute( ReadAll { d } );
       }
-      shuffle( seq_size.begin(), seq_size.end(), rd );
-
-      string d( offset, 0 );
-      generate( d.begin(), d.end(), [&] { return rd(); } );
-
-      for ( auto [off, sz] : seq_size ) {
-        sr.execute( Insert { d.substr( off, sz ), off }.is_last( off + sz == offset ) );
-      }
-
-      sr.execute( ReadAll { d } );
     }
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << endl;
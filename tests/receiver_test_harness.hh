@@ -7,7 +7,9 @@
 
 #include <optional>
 #include <sstream>
+#include <string>
 #include <utility>
+#include <vector>
 
 template<std::derived_from<TestStep<Reassembler>> T>
 struct DirectReassemblerTest : public TestStep<TCPReceiver>
@@ -40,10 +42,14 @@ struct DirectByteStreamTest : public TestStep<TCPReceiver>
 class TCPReceiverTestHarness : public TestHarness<TCPReceiver>
 {
 public:
-  TCPReceiverTestHarness( std::string test_name, uint64_t capacity )
+  TCPReceiverTestHarness( std::string test_name,
+                          uint64_t capacity,
+                          bool sack = false,
+                          std::optional<uint8_t> window_scale = {} )
     : TestHarness( move( test_name ),
-                   "capacity=" + std::to_string( capacity ),
-                   { TCPReceiver { Reassembler { ByteStream { capacity } } } } )
+                   "capacity=" + std::to_string( capacity ) + ( sack ? ", sack" : "" )
+                     + ( window_scale ? ", window_scale=" + std::to_string( window_scale.value() ) : "" ),
+                   { TCPReceiver { Reassembler { ByteStream { capacity } }, sack, window_scale } } )
   {}
 
   template<std::derived_from<TestStep<Reassembler>> T>
@@ -68,6 +74,13 @@ struct ExpectWindow : public ExpectNumber<TCPReceiver, uint16_t>
   uint16_t value( TCPReceiver& rs ) const override { return rs.send().window_size; }
 };
 
+struct ExpectSYNWindow : public ExpectNumber<TCPReceiver, uint16_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "window_size (in a SYN)"; }
+  uint16_t value( TCPReceiver& rs ) const override { return rs.send( true ).window_size; }
+};
+
 struct ExpectAckno : public ExpectNumber<TCPReceiver, std::optional<Wrap32>>
 {
   using ExpectNumber::ExpectNumber;
@@ -111,6 +124,36 @@ struct ExpectAcknoBetween : public Expectation<TCPReceiver>
   }
 };
 
+struct ExpectSACK : public Expectation<TCPReceiver>
+{
+  std::vector<std::pair<Wrap32, Wrap32>> blocks_;
+
+  explicit ExpectSACK( std::vector<std::pair<Wrap32, Wrap32>> blocks ) : blocks_( std::move( blocks ) ) {}
+
+  static std::string describe( const std::vector<std::pair<Wrap32, Wrap32>>& blocks )
+  {
+    std::ostringstream ss;
+    for ( const auto& [left, right] : blocks ) {
+      ss << " [" << left << ", " << right << ")";
+    }
+    return blocks.empty() ? " (none)" : ss.str();
+  }
+
+  std::string description() const override { return "SACK blocks" + describe( blocks_ ); }
+
+  void execute( TCPReceiver& rs ) const override
+  {
+    std::vector<std::pair<Wrap32, Wrap32>> actual;
+    for ( const auto& block : rs.send().sack ) {
+      actual.emplace_back( block.left, block.right );
+    }
+    if ( actual != blocks_ ) {
+      throw ExpectationViolation( "TCPReceiver should have sent SACK blocks" + describe( blocks_ ) + ", but sent"
+                                  + describe( actual ) );
+    }
+  }
+};
+
 struct HasAckno : public ExpectBool<TCPReceiver>
 {
   using ExpectBool::ExpectBool;
@@ -141,6 +184,18 @@ struct SegmentArrives : public Action<TCPReceiver>
     return *this;
   }
 
+  SegmentArrives& with_sack_permitted()
+  {
+    msg_.SACK_permitted = true;
+    return *this;
+  }
+
+  SegmentArrives& with_window_scale( uint8_t shift )
+  {
+    msg_.window_scale = shift;
+    return *this;
+  }
+
   SegmentArrives& with_seqno( Wrap32 seqno_ )
   {
     msg_.seqno = seqno_;
@@ -175,6 +230,12 @@ struct SegmentArrives : public Action<TCPReceiver>
     if ( msg_.SYN ) {
       ss << " +SYN";
     }
+    if ( msg_.SACK_permitted ) {
+      ss << " +SACK-permitted";
+    }
+    if ( msg_.window_scale ) {
+      ss << " window_scale=" << static_cast<int>( msg_.window_scale.value() );
+    }
     if ( not msg_.payload.empty() ) {
       ss << " payload=\"" << Printer::prettify( msg_.payload ) << "\"";
     }
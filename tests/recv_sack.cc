@@ -0,0 +1,78 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "no SACK blocks unless the sender's SYN permits them", 2358, true };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ExpectSACK { {} } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "no SACK blocks unless the receiver sends them", 2358 };
+      test.execute( SegmentArrives {}.with_syn().with_sack_permitted().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ExpectSACK { {} } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "SACK blocks follow the holes, newest first", 2358, true };
+      test.execute( SegmentArrives {}.with_syn().with_sack_permitted().with_seqno( isn ) );
+      test.execute( ExpectSACK { {} } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ExpectSACK { { { Wrap32 { isn + 5 }, Wrap32 { isn + 9 } } } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 13 ).with_data( "mnop" ) );
+      test.execute( ExpectSACK {
+        { { Wrap32 { isn + 13 }, Wrap32 { isn + 17 } }, { Wrap32 { isn + 5 }, Wrap32 { isn + 9 } } } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ijkl" ) );
+      test.execute( ExpectSACK { { { Wrap32 { isn + 5 }, Wrap32 { isn + 17 } } } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 17 } } );
+      test.execute( ExpectSACK { {} } );
+      test.execute( ReadAll { "abcdefghijklmnop" } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "at most four SACK blocks, the FIN included", 2358, true };
+      test.execute( SegmentArrives {}.with_syn().with_sack_permitted().with_seqno( isn ) );
+      for ( const uint32_t offset : { 3, 7, 11, 15 } ) {
+        test.execute( SegmentArrives {}.with_seqno( isn + offset ).with_data( "xy" ) );
+      }
+      test.execute( SegmentArrives {}.with_seqno( isn + 19 ).with_data( "z" ).with_fin() );
+      test.execute( ExpectSACK { { { Wrap32 { isn + 19 }, Wrap32 { isn + 21 } },
+                                   { Wrap32 { isn + 3 }, Wrap32 { isn + 5 } },
+                                   { Wrap32 { isn + 7 }, Wrap32 { isn + 9 } },
+                                   { Wrap32 { isn + 11 }, Wrap32 { isn + 13 } } } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ab" ) );
+      test.execute( ExpectSACK { { { Wrap32 { isn + 7 }, Wrap32 { isn + 13 } },
+                                   { Wrap32 { isn + 3 }, Wrap32 { isn + 5 } },
+                                   { Wrap32 { isn + 15 }, Wrap32 { isn + 17 } },
+                                   { Wrap32 { isn + 19 }, Wrap32 { isn + 21 } } } } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,99 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+#include "tcp_config.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      // the shift offered is the smallest that lets the window cover the capacity
+      TCPConfig cfg;
+      for ( const auto& [capacity, shift] : { pair<size_t, uint8_t> { 64000, 0 },
+                                              { 65535, 0 },
+                                              { 65536, 1 },
+                                              { 1 << 20, 5 },
+                                              { 1UL << 30, 14 },
+                                              { 1UL << 40, 14 } } ) {
+        cfg.recv_capacity = capacity;
+        cfg.window_scaling = false;
+        if ( cfg.window_scale().has_value() ) {
+          throw runtime_error( "window scale offered without window_scaling" );
+        }
+        cfg.window_scaling = true;
+        if ( cfg.window_scale() != shift ) {
+          throw runtime_error( "capacity " + to_string( capacity ) + " should offer window scale "
+                               + to_string( shift ) + ", not " + to_string( cfg.window_scale() ) );
+        }
+      }
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "no scaling unless the sender's SYN offers it", 200000, false, 2 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectWindow { 65535 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( ExpectWindow { 65535 } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "no scaling unless the receiver's side offers it", 200000 };
+      test.execute( SegmentArrives {}.with_syn().with_window_scale( 7 ).with_seqno( isn ) );
+      test.execute( ExpectWindow { 65535 } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "windows after the SYN are shifted by our own shift", 200000, false, 2 };
+      test.execute( ExpectWindow { 65535 } );
+      test.execute( SegmentArrives {}.with_syn().with_window_scale( 5 ).with_seqno( isn ) );
+      test.execute( ExpectWindow { 50000 } );
+      test.execute( ExpectSYNWindow { 65535 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 5 } } );
+      test.execute( ExpectWindow { 49999 } );
+      test.execute( ReadAll { "abcd" } );
+      test.execute( ExpectWindow { 50000 } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "scaled windows round down", 1000, false, 3 };
+      test.execute( SegmentArrives {}.with_syn().with_window_scale( 0 ).with_seqno( isn ) );
+      test.execute( ExpectWindow { 125 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "a" ) );
+      test.execute( ExpectWindow { 124 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 2 ).with_data( "bcdefgh" ) );
+      test.execute( ExpectWindow { 124 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "i" ) );
+      test.execute( ExpectWindow { 123 } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "a scaled window accepts data beyond 64 KiB", 3000000, false, 6 };
+      test.execute( SegmentArrives {}.with_syn().with_window_scale( 6 ).with_seqno( isn ) );
+      test.execute( ExpectWindow { 46875 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 2000001 ).with_data( "late" ) );
+      test.execute( BytesPending { 4 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 3000001 ).with_data( "beyond" ) );
+      test.execute( BytesPending { 4 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
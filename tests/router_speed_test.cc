@@ -0,0 +1,144 @@
+#include "router.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+class DiscardingPort : public NetworkInterface::OutputPort
+{
+public:
+  size_t frames {};
+  void transmit( const NetworkInterface& /* sender */, const EthernetFrame& /* frame */ ) override { ++frames; }
+};
+
+uint32_t ip( const string& str )
+{
+  return Address { str }.ipv4_numeric();
+}
+
+// Forward `num_packets` datagrams with `payload_len` bytes of payload from one interface to the other.
+void forwarding_speed_test( const size_t num_packets, const size_t payload_len )
+{
+  const EthernetAddress router_eth0 { 0x02, 0, 0, 0, 0, 1 };
+  const EthernetAddress router_eth1 { 0x02, 0, 0, 0, 0, 2 };
+  const EthernetAddress next_hop_eth { 0x02, 0, 0, 0, 0, 3 };
+  auto in_port = make_shared<DiscardingPort>();
+  auto out_port = make_shared<DiscardingPort>();
+
+  Router router;
+  router.add_interface( make_shared<NetworkInterface>( "eth0", in_port, router_eth0, Address { "10.0.0.1" } ) );
+  router.add_interface( make_shared<NetworkInterface>( "eth1", out_port, router_eth1, Address { "10.0.1.1" } ) );
+  router.add_route( ip( "10.0.0.0" ), 24, {}, 0 );
+  router.add_route( ip( "0.0.0.0" ), 0, Address { "10.0.1.2" }, 1 );
+
+  // teach eth1 the next hop's Ethernet address up front
+  ARPMessage arp;
+  arp.opcode = ARPMessage::OPCODE_REPLY;
+  arp.sender_ethernet_address = next_hop_eth;
+  arp.sender_ip_address = ip( "10.0.1.2" );
+  arp.target_ethernet_address = router_eth1;
+  arp.target_ip_address = ip( "10.0.1.1" );
+  const EthernetFrame arp_frame { { router_eth1, next_hop_eth, EthernetHeader::TYPE_ARP }, serialize( arp ) };
+  router.interface( 1 )->recv_frame( arp_frame );
+
+  InternetDatagram dgram;
+  dgram.header.src = ip( "10.0.0.2" );
+  dgram.header.dst = ip( "192.168.7.7" );
+  dgram.header.ttl = 64;
+  dgram.payload.emplace_back( payload_len, 'x' );
+  dgram.header.len = IPv4Header::LENGTH + payload_len;
+  dgram.header.compute_checksum();
+  const EthernetFrame frame { { router_eth0, next_hop_eth, EthernetHeader::TYPE_IPv4 }, serialize( dgram ) };
+
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < num_packets; ++i ) {
+    router.interface( 0 )->recv_frame( frame );
+    router.route();
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( out_port->frames != num_packets ) {
+    throw runtime_error( "Router did not forward every datagram" );
+  }
+
+  const auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  const auto packets_per_second = static_cast<double>( num_packets ) / test_duration.count();
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "Router forwarding " << payload_len << "-byte payloads reached " << fixed << setprecision( 2 )
+       << packets_per_second / 1e6 << " Mpkt/s.\n";
+
+  debug_output << "             Router throughput (" << payload_len << "-byte payloads): " << fixed
+               << setprecision( 2 ) << packets_per_second / 1e6 << " Mpkt/s\n";
+}
+
+// Time the TTL decrement on its own: recomputing the header checksum against adjusting it (RFC 1624).
+void ttl_speed_test( const size_t iterations )
+{
+  IPv4Header header;
+  header.src = ip( "10.0.0.2" );
+  header.dst = ip( "192.168.7.7" );
+  header.len = 1500;
+
+  auto time = [&]( auto&& decrement ) {
+    header.compute_checksum();
+    const auto start_time = steady_clock::now();
+    for ( size_t i = 0; i < iterations; ++i ) {
+      if ( header.ttl <= 1 ) {
+        header.ttl = IPv4Header::DEFAULT_TTL;
+        header.compute_checksum();
+      }
+      decrement();
+    }
+    const auto stop_time = steady_clock::now();
+    const auto elapsed = duration_cast<duration<double, nano>>( stop_time - start_time );
+    return elapsed.count() / static_cast<double>( iterations );
+  };
+
+  const double recompute_ns = time( [&] {
+    --header.ttl;
+    header.compute_checksum();
+  } );
+  const double adjust_ns = time( [&] { header.set_ttl( header.ttl - 1 ); } );
+
+  IPv4Header recomputed = header;
+  recomputed.compute_checksum();
+  if ( recomputed.cksum != header.cksum ) {
+    throw runtime_error( "Incremental checksum does not match recomputed checksum" );
+  }
+
+  cout << "TTL decrement with recomputed checksum: " << fixed << setprecision( 1 ) << recompute_ns
+       << " ns; with incremental checksum: " << adjust_ns << " ns.\n";
+}
+
+} // namespace
+
+void program_body()
+{
+  forwarding_speed_test( 200000, 64 );
+  forwarding_speed_test( 200000, 1400 );
+  ttl_speed_test( 5000000 );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
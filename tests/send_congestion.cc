@@ -0,0 +1,120 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "No congestion control: the receiver's window is the only limit", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 20000 ) );
+      test.execute( Push { string( 30000, 'a' ) } );
+      for ( unsigned i = 0; i < 20; ++i ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      }
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+
+      TCPSenderTestHarness test { "NewReno: initial window, slow start, and back to one segment on timeout", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 10 * mss } );
+      test.execute( Push { string( 20000, 'a' ) } );
+      for ( unsigned i = 0; i < 10; ++i ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      }
+      test.execute( ExpectNoSegment {} );
+
+      // two segments acknowledged: the window grows by one, so three more go out
+      test.execute( AckReceived { Wrap32 { isn + 1 + 2 * mss } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 11 * mss } );
+      test.execute( Push {} );
+      for ( unsigned i = 0; i < 3; ++i ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      }
+      test.execute( ExpectNoSegment {} );
+
+      test.execute( Tick { cfg.rt_timeout } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( isn + 1 + 2 * mss ) );
+      test.execute( ExpectCongestionWindow { mss } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 1 + 13 * mss } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 2 * mss } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = CongestionControl::Algorithm::Cubic;
+
+      TCPSenderTestHarness test { "CUBIC: the receiver's window still applies", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 3500 ) );
+      test.execute( ExpectCongestionWindow { 10 * mss } );
+      test.execute( Push { string( 20000, 'a' ) } );
+      for ( unsigned i = 0; i < 3; ++i ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      }
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( 500 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = CongestionControl::Algorithm::BBR;
+
+      // 1 byte delivered in 1 ms: a measured bandwidth of 1000 bytes/s, paced at startup's 2/ln(2) times that
+      TCPSenderTestHarness test { "BBR: sending is paced at the measured bandwidth", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 1 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push { string( 4 * mss, 'a' ) } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 300 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 100 } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,141 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.fast_retransmit = true;
+
+      TCPSenderTestHarness test { "Third duplicate ACK retransmits, and so does each partial ACK", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      for ( const string data : { "abc", "def", "ghi", "jkl", "mno" } ) {
+        test.execute( Push { data } );
+        test.execute( ExpectMessage {}.with_data( data ) );
+      }
+      test.execute( AckReceived { Wrap32 { isn + 4 } } );
+
+      // "def" was lost: the segments after it each bring back a duplicate ACK
+      test.execute( AckReceived { Wrap32 { isn + 4 } } );
+      test.execute( AckReceived { Wrap32 { isn + 4 } } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 4 } } );
+      test.execute( ExpectMessage {}.with_data( "def" ).with_seqno( isn + 4 ) );
+      test.execute( AckReceived { Wrap32 { isn + 4 } } );
+      test.execute( ExpectNoSegment {} );
+
+      // "ghi" was lost too: the ACK of "def" stops short of everything sent before recovery began
+      test.execute( AckReceived { Wrap32 { isn + 7 } } );
+      test.execute( ExpectMessage {}.with_data( "ghi" ).with_seqno( isn + 7 ) );
+      test.execute( AckReceived { Wrap32 { isn + 16 } } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+
+      // recovery is over; an ACK that changes the window is not a duplicate, and starts the count again
+      for ( const string data : { "pqr", "stu", "vwx" } ) {
+        test.execute( Push { data } );
+        test.execute( ExpectMessage {}.with_data( data ) );
+      }
+      test.execute( AckReceived { Wrap32 { isn + 19 } } );
+      test.execute( AckReceived { Wrap32 { isn + 19 } } );
+      test.execute( AckReceived { Wrap32 { isn + 19 } } );
+      test.execute( AckReceived { Wrap32 { isn + 19 } }.with_win( 999 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 19 } }.with_win( 999 ) );
+      test.execute( AckReceived { Wrap32 { isn + 19 } }.with_win( 999 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 19 } }.with_win( 999 ) );
+      test.execute( ExpectMessage {}.with_data( "stu" ).with_seqno( isn + 19 ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Without fast retransmit, duplicate ACKs wait for the timer", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Push { "def" } );
+      test.execute( ExpectMessage {}.with_data( "def" ) );
+      for ( unsigned i = 0; i < 4; ++i ) {
+        test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { cfg.rt_timeout - 1U } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.fast_retransmit = true;
+      cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+
+      TCPSenderTestHarness test { "NewReno: halve the window on fast retransmit, inflate it during recovery", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push { string( 20000, 'a' ) } );
+      for ( unsigned i = 0; i < 10; ++i ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      }
+      test.execute( ExpectNoSegment {} );
+
+      // ssthresh is half the flight, and the three segments that left the network stretch the window past it
+      for ( unsigned i = 0; i < 3; ++i ) {
+        test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      }
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectCongestionWindow { 8 * mss } );
+
+      // each further duplicate lets one more segment out once the inflation passes the flight
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 10 * mss } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 11 * mss } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( isn + 1 + 10 * mss ) );
+      test.execute( ExpectNoSegment {} );
+
+      // everything outstanding when recovery began is acknowledged: deflate to ssthresh
+      test.execute( AckReceived { Wrap32 { isn + 1 + 10 * mss } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 5 * mss } );
+      for ( unsigned i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 5 * mss } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,162 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.adaptive_rto = true;
+      cfg.rto_min = 10;
+
+      TCPSenderTestHarness test { "Adaptive RTO follows the measured RTT", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( ExpectRTO { cfg.rt_timeout } );
+      test.execute( Tick { 40 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      // first sample: SRTT = R, RTTVAR = R/2, RTO = SRTT + 4 * RTTVAR
+      test.execute( ExpectSmoothedRTT { 40 } );
+      test.execute( ExpectRTO { 120 } );
+
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Tick { 119 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( ExpectRTO { 240 } );
+
+      // the ACK of a retransmitted segment gives no sample (Karn), so the backoff stays until there is one
+      test.execute( Tick { 40 } );
+      test.execute( AckReceived { Wrap32 { isn + 4 } } );
+      test.execute( ExpectSmoothedRTT { 40 } );
+      test.execute( ExpectRTO { 240 } );
+
+      // the next sample: RTTVAR = 3/4 * 20 + 1/4 * |40 - 40|, SRTT = 7/8 * 40 + 1/8 * 40
+      test.execute( Push { "def" } );
+      test.execute( ExpectMessage {}.with_data( "def" ) );
+      test.execute( Tick { 40 } );
+      test.execute( AckReceived { Wrap32 { isn + 7 } } );
+      test.execute( ExpectSmoothedRTT { 40 } );
+      test.execute( ExpectRTO { 100 } );
+
+      // ... and one from a faster round trip: RTTVAR = 3/4 * 15 + 1/4 * 24 = 17.25, SRTT = 35 + 2 = 37
+      test.execute( Push { "ghi" } );
+      test.execute( ExpectMessage {}.with_data( "ghi" ) );
+      test.execute( Tick { 16 } );
+      test.execute( AckReceived { Wrap32 { isn + 10 } } );
+      test.execute( ExpectSmoothedRTT { 37 } );
+      test.execute( ExpectRTO { 106 } );
+      test.execute( Push { "jkl" } );
+      test.execute( ExpectMessage {}.with_data( "jkl" ) );
+      test.execute( Tick { 105 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "jkl" ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.adaptive_rto = true;
+      cfg.rto_min = 200;
+      cfg.rto_max = 1000;
+
+      TCPSenderTestHarness test { "Adaptive RTO stays within its bounds, backoff included", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( ExpectSmoothedRTT { 10 } );
+      test.execute( ExpectRTO { 200 } );
+
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      for ( const uint64_t rto : { 200, 400, 800, 1000, 1000 } ) {
+        test.execute( ExpectRTO { rto } );
+        test.execute( Tick { rto - 1 } );
+        test.execute( ExpectNoSegment {} );
+        test.execute( Tick { 1 } );
+        test.execute( ExpectMessage {}.with_data( "abc" ) );
+      }
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.adaptive_rto = true;
+      cfg.rto_min = 10;
+
+      TCPSenderTestHarness test { "Adaptive RTO keeps its backoff until a fresh RTT sample", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 40 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( ExpectRTO { 120 } );
+
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Push { "def" } );
+      test.execute( ExpectMessage {}.with_data( "def" ) );
+      test.execute( Tick { 120 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( ExpectRTO { 240 } );
+
+      // "abc" was retransmitted, so its ACK is no sample: "def" times out after the doubled RTO, not 120 ms
+      test.execute( Tick { 40 } );
+      test.execute( AckReceived { Wrap32 { isn + 4 } } );
+      test.execute( ExpectRTO { 240 } );
+      test.execute( Tick { 239 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "def" ) );
+      test.execute( ExpectRTO { 480 } );
+      test.execute( AckReceived { Wrap32 { isn + 7 } } );
+      test.execute( ExpectRTO { 480 } );
+
+      // a segment sent only once gives a sample again, and the RTO follows the estimate
+      test.execute( Push { "ghi" } );
+      test.execute( ExpectMessage {}.with_data( "ghi" ) );
+      test.execute( Tick { 40 } );
+      test.execute( AckReceived { Wrap32 { isn + 10 } } );
+      test.execute( ExpectSmoothedRTT { 40 } );
+      test.execute( ExpectRTO { 100 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Without adaptive RTO, the RTT is measured but the RTO stays put", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 30 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( ExpectSmoothedRTT { 30 } );
+      test.execute( ExpectRTO { cfg.rt_timeout } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
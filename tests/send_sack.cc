@@ -0,0 +1,122 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.fast_retransmit = true;
+      cfg.sack = true;
+
+      TCPSenderTestHarness test { "SACK: retransmit every hole, and only the holes", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_sack_permitted( true ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      for ( const string data : { "abc", "def", "ghi", "jkl", "mno", "pqr" } ) {
+        test.execute( Push { data } );
+        test.execute( ExpectMessage {}.with_data( data ).with_sack_permitted( false ) );
+      }
+      test.execute( AckReceived { Wrap32 { isn + 4 } } );
+
+      // "def" and "jkl" were lost
+      test.execute( AckReceived { Wrap32 { isn + 4 } }.with_sack( isn + 7, isn + 10 ) );
+      test.execute(
+        AckReceived { Wrap32 { isn + 4 } }.with_sack( isn + 13, isn + 16 ).with_sack( isn + 7, isn + 10 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute(
+        AckReceived { Wrap32 { isn + 4 } }.with_sack( isn + 13, isn + 19 ).with_sack( isn + 7, isn + 10 ) );
+      test.execute( ExpectMessage {}.with_data( "def" ).with_seqno( isn + 4 ) );
+      test.execute( ExpectMessage {}.with_data( "jkl" ).with_seqno( isn + 10 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // nothing new to learn: no more retransmissions, and none of "jkl" again when the ACK of "def" reaches it
+      test.execute(
+        AckReceived { Wrap32 { isn + 4 } }.with_sack( isn + 13, isn + 19 ).with_sack( isn + 7, isn + 10 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 10 } }.with_sack( isn + 13, isn + 19 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 19 } } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.fast_retransmit = true;
+      cfg.sack = true;
+
+      TCPSenderTestHarness test { "SACK: after a timeout, SACKed data is retransmitted too", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_sack_permitted( true ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      for ( const string data : { "abc", "def", "ghi" } ) {
+        test.execute( Push { data } );
+        test.execute( ExpectMessage {}.with_data( data ).with_sack_permitted( false ) );
+      }
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_sack( isn + 7, isn + 10 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // the receiver may have dropped "ghi" since it SACKed it (reneging): once the timer expires, only the
+      // cumulative ACK counts, and each partial ACK brings the next segment, "ghi" included
+      test.execute( Tick { cfg.rt_timeout - 1U } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 4 } } );
+      test.execute( ExpectMessage {}.with_data( "def" ).with_seqno( isn + 4 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 7 } } );
+      test.execute( ExpectMessage {}.with_data( "ghi" ).with_seqno( isn + 7 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 10 } } );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.fast_retransmit = true;
+
+      TCPSenderTestHarness test { "Without SACK, the second hole waits for a partial ACK", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_sack_permitted( false ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      for ( const string data : { "abc", "def", "ghi", "jkl", "mno", "pqr" } ) {
+        test.execute( Push { data } );
+        test.execute( ExpectMessage {}.with_data( data ) );
+      }
+      test.execute( AckReceived { Wrap32 { isn + 4 } } );
+      for ( unsigned i = 0; i < 3; ++i ) {
+        test.execute( AckReceived { Wrap32 { isn + 4 } }.with_sack( isn + 13, isn + 19 ) );
+      }
+      test.execute( ExpectMessage {}.with_data( "def" ).with_seqno( isn + 4 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 10 } } );
+      test.execute( ExpectMessage {}.with_data( "jkl" ).with_seqno( isn + 10 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,112 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.recv_capacity = 1000000;
+
+      TCPSenderTestHarness test { "no window-scale option unless configured", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_window_scale( nullopt ).with_seqno( isn ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.recv_capacity = 1000000;
+      cfg.window_scaling = true;
+
+      TCPSenderTestHarness test { "windows after the SYN are scaled by the peer's shift", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_window_scale( 4 ).with_seqno( isn ) );
+
+      // the window in the SYN-ACK is not scaled
+      test.execute( Receive { { isn + 1, 2000 } }.without_push() );
+      test.execute( PeerWindowScale { 2 } );
+      test.execute( Push { string( 6000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1001 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // ... the ones after it are
+      test.execute( AckReceived { isn + 2001 }.with_win( 1000 ) );
+      for ( uint32_t i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 2001 + 1000 * i ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 4000 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.window_scaling = true;
+
+      TCPSenderTestHarness test { "no scaling unless the peer's SYN offers it too", cfg };
+      test.execute( PeerWindowScale { nullopt } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_window_scale( nullopt ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 1000 ) );
+      test.execute( Push { string( 3000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "no scaling unless our own SYN offers it", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_window_scale( nullopt ).with_seqno( isn ) );
+      test.execute( PeerWindowScale { 3 } );
+      test.execute( AckReceived { isn + 1 }.with_win( 1000 ) );
+      test.execute( Push { string( 3000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.window_scaling = true;
+
+      TCPSenderTestHarness test { "a shift beyond 14 counts as 14", cfg };
+      test.execute( PeerWindowScale { 20 } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_window_scale( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 1 ) );
+      test.execute( Push { string( 20000, 'x' ) } );
+      for ( uint32_t i = 0; i < 16; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 + 1000 * i ) );
+      }
+      test.execute( ExpectMessage {}.with_payload_size( 384 ).with_seqno( isn + 16001 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
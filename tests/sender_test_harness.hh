@@ -73,6 +73,27 @@ struct ExpectSeqnosInFlight : public ExpectNumber<SenderAndOutput, uint64_t>
   uint64_t value( SenderAndOutput& ss ) const override { return ss.sender.sequence_numbers_in_flight(); }
 };
 
+struct ExpectCongestionWindow : public ExpectNumber<SenderAndOutput, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "congestion_window"; }
+  uint64_t value( SenderAndOutput& ss ) const override { return ss.sender.congestion_window(); }
+};
+
+struct ExpectRTO : public ExpectNumber<SenderAndOutput, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "retransmission_timeout"; }
+  uint64_t value( SenderAndOutput& ss ) const override { return ss.sender.retransmission_timeout(); }
+};
+
+struct ExpectSmoothedRTT : public ExpectNumber<SenderAndOutput, double>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "smoothed_rtt"; }
+  double value( SenderAndOutput& ss ) const override { return ss.sender.smoothed_rtt().value_or( -1 ); }
+};
+
 struct ExpectConsecutiveRetransmissions : public ExpectNumber<SenderAndOutput, uint64_t>
 {
   using ExpectNumber::ExpectNumber;
@@ -192,7 +213,11 @@ struct Receive : public Action<SenderAndOutput>
   std::string description() const override
   {
     std::ostringstream desc;
-    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size << ")";
+    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size;
+    for ( const auto& block : msg_.sack ) {
+      desc << ", sack=[" << block.left << ", " << block.right << ")";
+    }
+    desc << ")";
     if ( push_ ) {
       desc << ", then push stream to TCPSender";
     }
@@ -205,6 +230,12 @@ struct Receive : public Action<SenderAndOutput>
     return *this;
   }
 
+  Receive& with_sack( Wrap32 left, Wrap32 right )
+  {
+    msg_.sack.push_back( { left, right } );
+    return *this;
+  }
+
   void execute( SenderAndOutput& ss ) const override
   {
     ss.sender.receive( msg_ );
@@ -220,6 +251,19 @@ struct Receive : public Action<SenderAndOutput>
   }
 };
 
+struct PeerWindowScale : public Action<SenderAndOutput>
+{
+  std::optional<uint8_t> shift_;
+
+  explicit PeerWindowScale( std::optional<uint8_t> shift ) : shift_( shift ) {}
+  std::string description() const override
+  {
+    return shift_ ? "peer's SYN offers window_scale=" + std::to_string( shift_.value() )
+                  : "peer's SYN offers no window scaling";
+  }
+  void execute( SenderAndOutput& ss ) const override { ss.sender.set_peer_window_scale( shift_ ); }
+};
+
 struct AckReceived : public Receive
 {
   explicit AckReceived( Wrap32 ackno ) : Receive( { ackno, DEFAULT_TEST_WINDOW } ) {}
@@ -238,6 +282,8 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
   std::optional<Wrap32> seqno {};
   std::optional<std::string> data {};
   std::optional<size_t> payload_size {};
+  std::optional<bool> sack_permitted {};
+  std::optional<std::optional<uint8_t>> window_scale {};
 
   ExpectMessage& with_syn( bool syn_ )
   {
@@ -283,6 +329,18 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
     return *this;
   }
 
+  ExpectMessage& with_sack_permitted( bool sack_permitted_ )
+  {
+    sack_permitted = sack_permitted_;
+    return *this;
+  }
+
+  ExpectMessage& with_window_scale( std::optional<uint8_t> window_scale_ )
+  {
+    window_scale = window_scale_;
+    return *this;
+  }
+
   std::string message_description() const
   {
     std::ostringstream o;
@@ -308,6 +366,13 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
     if ( rst.has_value() ) {
       o << ( rst.value() ? " +RST" : " (no RST)" );
     }
+    if ( sack_permitted.has_value() ) {
+      o << ( sack_permitted.value() ? " +SACK-permitted" : " (no SACK-permitted)" );
+    }
+    if ( window_scale.has_value() ) {
+      o << ( window_scale.value() ? " window_scale=" + std::to_string( window_scale.value().value() )
+                                  : " (no window scale)" );
+    }
     return o.str();
   }
 
@@ -334,6 +399,12 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
     if ( rst.has_value() and seg.RST != rst.value() ) {
       throw ExpectationViolation( "RST flag", rst.value(), seg.RST );
     }
+    if ( sack_permitted.has_value() and seg.SACK_permitted != sack_permitted.value() ) {
+      throw ExpectationViolation( "SACK-permitted option", sack_permitted.value(), seg.SACK_permitted );
+    }
+    if ( window_scale.has_value() and seg.window_scale != window_scale.value() ) {
+      throw ExpectationViolation( "window-scale option", window_scale.value(), seg.window_scale );
+    }
     if ( seqno.has_value() and seg.seqno != seqno.value() ) {
       throw ExpectationViolation( "sequence number", seqno.value(), seg.seqno );
     }
@@ -359,6 +430,15 @@ public:
   TCPSenderTestHarness( std::string name, TCPConfig config )
     : TestHarness( move( name ),
                    "initial_RTO_ms=" + to_string( config.rt_timeout ),
-                   { TCPSender { ByteStream { config.send_capacity }, config.isn, config.rt_timeout } } )
+                   { TCPSender {
+                     ByteStream { config.send_capacity },
+                     config.isn,
+                     config.rt_timeout,
+                     CongestionControl::make( config.congestion_control, TCPConfig::MAX_PAYLOAD_SIZE ),
+                     config.adaptive_rto ? std::optional { TCPSender::RTOBounds { config.rto_min, config.rto_max } }
+                                         : std::nullopt,
+                     config.fast_retransmit,
+                     config.sack,
+                     config.window_scale() } } )
   {}
 };
@@ -0,0 +1,97 @@
+#include "random.hh"
+#include "tcp_over_ip.hh"
+
+#include <array>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// A datagram serialized in frame mode must match the ordinary serialize-then-checksum path byte for byte.
+void check_frame( TCPOverIPv4Adapter& adapter, const TCPMessage& msg )
+{
+  string expected;
+  for ( const auto& buffer : serialize( adapter.wrap_tcp_in_ip( msg ) ) ) {
+    expected += buffer;
+  }
+
+  array<char, 120> frame_buffer {};
+  Serializer frame { frame_buffer };
+  adapter.wrap_tcp_in_ip( msg, frame );
+  string actual;
+  for ( const auto view : frame.views() ) {
+    actual += view;
+  }
+  if ( frame.views().size() != ( msg.sender.payload.empty() ? 1 : 2 ) ) {
+    throw runtime_error( "Expected the headers and the payload as separate views" );
+  }
+
+  if ( actual != expected ) {
+    ostringstream ss;
+    ss << "Frame-mode serialization differs from serialize() for a " << msg.sender.payload.size()
+       << "-byte payload\n";
+    throw runtime_error( ss.str() );
+  }
+}
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    TCPOverIPv4Adapter adapter;
+    adapter.config_mut().source = Address { "169.254.144.9", 9090 };
+    adapter.config_mut().destination = Address { "169.254.144.1", 6001 };
+
+    for ( unsigned int i = 0; i < 2000; i++ ) {
+      TCPMessage msg;
+      msg.sender.seqno = Wrap32 { static_cast<uint32_t>( rd() ) };
+      msg.sender.SYN = rd() % 2;
+      msg.sender.FIN = rd() % 2;
+      msg.sender.payload = string( i % 7 == 0 ? 0 : rd() % 1500, 0 );
+      for ( auto& c : msg.sender.payload ) {
+        c = static_cast<char>( rd() );
+      }
+      if ( rd() % 2 ) {
+        msg.receiver.ackno = Wrap32 { static_cast<uint32_t>( rd() ) };
+      }
+      msg.receiver.window_size = rd();
+      check_frame( adapter, msg );
+    }
+
+    // the adapter keeps its addresses and ports in numeric form, but a change to its config still takes effect
+    adapter.config_mut().destination = Address { "169.254.144.2", 6002 };
+    array<char, 120> frame_buffer {};
+    Serializer frame { frame_buffer };
+    adapter.wrap_tcp_in_ip( TCPMessage {}, frame );
+    InternetDatagram dgram;
+    FourTuple flow;
+    if ( not parse( dgram, vector<string> { string { frame.views().front() } } )
+         or not TCPOverIPv4Adapter::unwrap_tcp_in_ip( dgram, flow ).has_value()
+         or flow.local_address != Address { "169.254.144.2" }.ipv4_numeric() or flow.local_port != 6002
+         or flow.remote_port != 9090 ) {
+      throw runtime_error( "Expected a segment to the newly configured destination" );
+    }
+
+    // headers that don't fit the caller's buffer are an error, not an overrun
+    array<char, 30> small_buffer {};
+    Serializer small { small_buffer };
+    bool threw = false;
+    try {
+      adapter.wrap_tcp_in_ip( TCPMessage {}, small );
+    } catch ( const runtime_error& ) {
+      threw = true;
+    }
+    if ( not threw ) {
+      throw runtime_error( "Expected an error when the frame buffer is too small" );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
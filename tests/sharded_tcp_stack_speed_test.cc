@@ -0,0 +1,154 @@
+#include "fake_tun.hh"
+#include "sharded_tcp_stack.hh"
+#include "tcp_stack.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+const Address client_address { "10.144.0.1" };
+const Address server_address { "10.144.0.2", 80 };
+
+// The server's application, run by every shard: echo whatever arrives, and close when the client does
+void echo( TCPStack& shard, vector<TCPStack::ConnectionId>& ready )
+{
+  while ( shard.accept( server_address.port() ).has_value() ) {}
+  shard.take_active( ready );
+  for ( const auto id : ready ) {
+    Reader& reader = shard.inbound_reader( id );
+    Writer& writer = shard.outbound_writer( id );
+    while ( reader.bytes_buffered() and writer.available_capacity() ) {
+      const auto data = reader.peek().substr( 0, writer.available_capacity() );
+      writer.push( string { data } );
+      reader.pop( data.size() );
+    }
+    shard.push( id );
+    if ( reader.is_finished() ) {
+      shard.close( id );
+    }
+  }
+}
+
+// Keep `num_connections` connections to a server of `num_shards` shards each doing `exchanges` request-response
+// exchanges, one at a time, and measure the aggregate rate and the latency of each exchange.
+void sharded_speed_test( const size_t num_shards,
+                         const size_t num_connections,
+                         const size_t exchanges,
+                         const size_t request_size )
+{
+  FakeTunWire wire;
+  ShardedTCPStack server { wire.take_b(), server_address, num_shards };
+  server.listen( server_address.port() );
+  server.start( [ready = vector<TCPStack::ConnectionId> {}]( TCPStack& shard ) mutable { echo( shard, ready ); } );
+
+  struct Exchange
+  {
+    steady_clock::time_point sent {};
+    size_t left {};
+    size_t awaited {};
+  };
+  auto key = []( TCPStack::ConnectionId id ) { return static_cast<uint64_t>( id.generation ) << 32 | id.index; };
+
+  TCPStack client { TCPOverIPv4OverTunFdAdapter { wire.take_a() }, client_address };
+  const string request( request_size, 'x' );
+  unordered_map<uint64_t, Exchange> exchanges_by_connection;
+  vector<TCPStack::ConnectionId> ready;
+  vector<double> latencies;
+  latencies.reserve( num_connections * exchanges );
+  size_t finished = 0;
+
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < num_connections; ++i ) {
+    const auto id = client.connect( server_address );
+    client.outbound_writer( id ).push( request );
+    exchanges_by_connection[key( id )] = { steady_clock::now(), exchanges, request_size };
+  }
+
+  while ( finished < num_connections ) {
+    if ( client.wait_next_event( 5000 ) != EventLoop::Result::Success ) {
+      throw runtime_error( "ShardedTCPStack connections stalled" );
+    }
+    client.take_active( ready );
+    for ( const auto id : ready ) {
+      Exchange& exchange = exchanges_by_connection.at( key( id ) );
+      Reader& reader = client.inbound_reader( id );
+      const size_t bytes = min( reader.bytes_buffered(), exchange.awaited );
+      reader.pop( bytes );
+      exchange.awaited -= bytes;
+      if ( exchange.awaited > 0 ) {
+        continue;
+      }
+
+      // the first exchange also waited for the handshake, so it is left out of the latencies
+      const auto now = steady_clock::now();
+      if ( exchange.left < exchanges ) {
+        latencies.push_back( duration_cast<duration<double, micro>>( now - exchange.sent ).count() );
+      }
+      if ( --exchange.left > 0 ) {
+        client.outbound_writer( id ).push( request );
+        client.push( id );
+        exchange.sent = now;
+        exchange.awaited = request_size;
+      } else {
+        ++finished;
+        client.close( id );
+      }
+    }
+  }
+  const auto stop_time = steady_clock::now();
+  server.stop();
+  wire.stop();
+
+  sort( latencies.begin(), latencies.end() );
+  const auto percentile = [&]( double p ) {
+    return latencies.at( static_cast<size_t>( p * static_cast<double>( latencies.size() - 1 ) ) );
+  };
+  const auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  const auto rate = static_cast<double>( num_connections * exchanges ) / test_duration.count();
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "ShardedTCPStack with " << num_shards << " shard" << ( num_shards == 1 ? "" : "s" ) << ", "
+       << num_connections << " connections: " << fixed << setprecision( 0 ) << rate << " exchanges/s, "
+       << setprecision( 3 ) << rate * static_cast<double>( request_size ) * 16 / 1e9 << " Gbit/s, latency p50 "
+       << setprecision( 0 ) << percentile( 0.5 ) << " us, p99 " << percentile( 0.99 ) << " us, "
+       << server.dropped() << " segments dropped.\n";
+  debug_output << "             ShardedTCPStack (" << num_shards << " shards): " << fixed << setprecision( 0 )
+               << rate << " exchanges/s, p99 " << percentile( 0.99 ) << " us\n";
+}
+
+void program_body()
+{
+  // from one shard to one per core (and at least two, so that steering is exercised)
+  const size_t cores = max( 2U, thread::hardware_concurrency() );
+  for ( size_t shards = 1; shards <= cores; shards = shards * 2 > cores and shards < cores ? cores : shards * 2 ) {
+    sharded_speed_test( shards, 256, 40, 100 );
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,193 @@
+#pragma once
+
+#include "parser.hh"
+#include "tcp_config.hh"
+#include "tcp_over_ip.hh"
+#include "tcp_peer.hh"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+//! One direction of a simulated link: how long it takes, how often it loses a datagram, and (optionally) how fast
+//! it carries them, with a drop-tail queue in front of it
+struct LinkConfig
+{
+  uint64_t delay_ms = 1;    //!< one-way delay
+  double loss = 0;          //!< chance of dropping each datagram
+  uint64_t rate = 0;        //!< bytes per ms (0: as fast as they come)
+  uint64_t queue_limit = 0; //!< bytes that may wait for the link (with a rate) before it drops (0: no limit)
+};
+
+//! What happened during a simulated transfer
+struct TransferResult
+{
+  uint64_t bytes {};            //!< bytes delivered to the receiving application
+  uint64_t elapsed_ms {};       //!< simulated time from the SYN until the receiver saw the stream end
+  uint64_t datagrams_sent {};   //!< datagrams the sending peer transmitted (including ones the link lost)
+  uint64_t datagrams_acked {};  //!< datagrams the receiving peer transmitted (ACKs, mostly)
+  uint64_t queue_drops {};      //!< datagrams dropped because the queue in front of the link was full
+  double wall_seconds {};       //!< real time the simulation took
+};
+
+//! Two TCPPeers joined by a simulated link, run in simulated time (a millisecond per step): the first sends
+//! `bytes` to the second and closes its stream. Each segment is serialized into an IPv4 datagram and parsed back
+//! at the other end, so the cost of every datagram is counted, as on a real link.
+class SimulatedTransfer
+{
+public:
+  SimulatedTransfer( const TCPConfig& sender_config,
+                     const TCPConfig& receiver_config,
+                     const LinkConfig& link,
+                     uint64_t seed )
+    : SimulatedTransfer( sender_config, receiver_config, link, link, seed )
+  {}
+
+  //! With a different link each way: `forward` carries the data, `back` the ACKs
+  SimulatedTransfer( const TCPConfig& sender_config,
+                     const TCPConfig& receiver_config,
+                     const LinkConfig& forward,
+                     const LinkConfig& back,
+                     uint64_t seed )
+    : sender_( sender_config ), receiver_( receiver_config ), forward_ { forward }, back_ { back }, rand_( seed )
+  {}
+
+  TransferResult run( const uint64_t bytes, const uint64_t time_limit_ms )
+  {
+    const auto start_time = std::chrono::steady_clock::now();
+    const std::string chunk( TCPConfig::MAX_PAYLOAD_SIZE, 'x' );
+    uint64_t remaining = bytes;
+    TransferResult result;
+
+    const auto send_forward = [&]( const TCPMessage& msg ) {
+      ++result.datagrams_sent;
+      result.queue_drops += not transmit( msg, forward_flow_, forward_ );
+    };
+    const auto send_back = [&]( const TCPMessage& msg ) {
+      ++result.datagrams_acked;
+      result.queue_drops += not transmit( msg, back_flow_, back_ );
+    };
+
+    sender_.push( send_forward ); // the SYN
+    while ( not receiver_.inbound_reader().is_finished() ) {
+      if ( now_ >= time_limit_ms ) {
+        throw std::runtime_error( "simulated transfer did not finish in time" );
+      }
+
+      deliver( back_, sender_, send_forward );
+      deliver( forward_, receiver_, send_back );
+
+      Writer& writer = sender_.outbound_writer();
+      while ( remaining > 0 and writer.available_capacity() > 0 and not writer.is_closed() ) {
+        const uint64_t len = std::min( { remaining, writer.available_capacity(), uint64_t { chunk.size() } } );
+        writer.push( chunk.substr( 0, len ) );
+        remaining -= len;
+      }
+      if ( remaining == 0 and not writer.is_closed() ) {
+        writer.close();
+      }
+      sender_.push( send_forward );
+
+      Reader& reader = receiver_.inbound_reader();
+      while ( reader.bytes_buffered() ) {
+        result.bytes += reader.peek().size();
+        reader.pop( reader.peek().size() );
+      }
+
+      ++now_;
+      sender_.tick( 1, send_forward );
+      receiver_.tick( 1, send_back );
+    }
+
+    result.elapsed_ms = now_;
+    result.wall_seconds
+      = std::chrono::duration<double>( std::chrono::steady_clock::now() - start_time ).count();
+    return result;
+  }
+
+  TCPPeer& sender() { return sender_; }
+  TCPPeer& receiver() { return receiver_; }
+
+private:
+  struct InFlight
+  {
+    uint64_t arrival;
+    std::string datagram;
+  };
+
+  struct Direction
+  {
+    LinkConfig link;
+    std::deque<InFlight> in_flight {};
+    double link_free_at {}; // when the link will have sent everything queued for it
+  };
+
+  TCPPeer sender_;
+  TCPPeer receiver_;
+  Direction forward_;
+  Direction back_;
+  std::default_random_engine rand_;
+  std::uniform_real_distribution<double> chance_ { 0, 1 };
+  uint64_t now_ {};
+
+  const FourTuple forward_flow_ { 0x0a000001, 0x0a000002, 40000, 80 };
+  const FourTuple back_flow_ { 0x0a000002, 0x0a000001, 80, 40000 };
+  std::array<char, 120> frame_buffer_ {};
+
+  // returns false if the queue in front of the link was full
+  bool transmit( const TCPMessage& msg, const FourTuple& flow, Direction& direction )
+  {
+    const LinkConfig& link = direction.link;
+    Serializer frame { frame_buffer_ };
+    TCPOverIPv4Adapter::wrap_tcp_in_ip( msg, flow, frame );
+    if ( link.loss > 0 and chance_( rand_ ) < link.loss ) {
+      return true;
+    }
+    std::string datagram;
+    for ( const auto view : frame.views() ) {
+      datagram += view;
+    }
+
+    uint64_t arrival = now_ + link.delay_ms;
+    if ( link.rate > 0 ) {
+      const auto now = static_cast<double>( now_ );
+      const auto rate = static_cast<double>( link.rate );
+      const double start = std::max( direction.link_free_at, now );
+      if ( link.queue_limit > 0
+           and ( start - now ) * rate + static_cast<double>( datagram.size() )
+                 > static_cast<double>( link.queue_limit ) ) {
+        return false;
+      }
+      direction.link_free_at = start + static_cast<double>( datagram.size() ) / rate;
+      arrival = static_cast<uint64_t>( std::ceil( direction.link_free_at ) ) + link.delay_ms;
+    }
+    direction.in_flight.push_back( { arrival, std::move( datagram ) } );
+    return true;
+  }
+
+  void deliver( Direction& direction, TCPPeer& peer, const TCPPeer::TransmitFunction& reply )
+  {
+    auto& in_flight = direction.in_flight;
+    while ( not in_flight.empty() and in_flight.front().arrival <= now_ ) {
+      std::string datagram = std::move( in_flight.front().datagram );
+      in_flight.pop_front();
+
+      Parser parser { std::span { &datagram, 1 } };
+      FourTuple flow;
+      if ( auto msg = TCPOverIPv4Adapter::unwrap_tcp_in_ip( parser, flow ) ) {
+        peer.receive( std::move( msg.value() ), reply );
+      } else {
+        throw std::runtime_error( "simulated link corrupted a datagram" );
+      }
+    }
+  }
+};
@@ -0,0 +1,106 @@
+#include "random.hh"
+#include "slot_map.hh"
+#include "small_function.hh"
+
+#include <array>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Check a SlotMap against a deque of (key, value) pairs in the same order: adding, erasing by key and by
+// position, and rotating must all agree, and erased keys must go stale.
+void check_against_reference( default_random_engine& rd )
+{
+  SlotMap<unique_ptr<int>, 8> map;
+  deque<pair<SlotKey, int>> reference;
+  vector<SlotKey> erased;
+  int serial = 0;
+
+  for ( unsigned int round = 0; round < 20000; ++round ) {
+    switch ( rd() % 5 ) {
+      case 0:
+      case 1: {
+        const SlotKey key = map.emplace( make_unique<int>( serial ) );
+        reference.emplace_back( key, serial++ );
+        break;
+      }
+      case 2:
+        if ( not reference.empty() ) {
+          const size_t position = rd() % reference.size();
+          map.erase_at( position );
+          erased.push_back( reference[position].first );
+          reference.erase( reference.begin() + static_cast<ptrdiff_t>( position ) );
+        }
+        break;
+      case 3:
+        if ( not reference.empty() ) {
+          const size_t position = rd() % reference.size();
+          map.erase( reference[position].first );
+          erased.push_back( reference[position].first );
+          reference.erase( reference.begin() + static_cast<ptrdiff_t>( position ) );
+        }
+        break;
+      default:
+        map.rotate();
+        if ( not reference.empty() ) {
+          reference.push_back( reference.front() );
+          reference.pop_front();
+        }
+    }
+
+    if ( map.size() != reference.size() ) {
+      throw runtime_error( "size() does not match the number of values" );
+    }
+    for ( size_t position = 0; position < reference.size(); ++position ) {
+      const auto& [key, value] = reference[position];
+      if ( *map[position] != value ) {
+        throw runtime_error( "values are out of order" );
+      }
+      if ( map.find( key ) != &map[position] ) {
+        throw runtime_error( "find() did not return the value for its key" );
+      }
+    }
+    if ( not erased.empty() and map.find( erased.at( rd() % erased.size() ) ) != nullptr ) {
+      throw runtime_error( "find() returned a value for an erased key" );
+    }
+  }
+}
+
+void check_small_function()
+{
+  int calls = 0;
+  SmallFunction<int( int )> small = [&calls]( int x ) { return x + ++calls; };
+
+  array<int, 64> big_capture {};
+  big_capture.back() = 100;
+  SmallFunction<int( int )> big = [&calls, big_capture]( int x ) { return x + big_capture.back() + ++calls; };
+
+  SmallFunction<int( int )> moved = move( small );
+  if ( small or not moved or moved( 1 ) != 2 ) {
+    throw runtime_error( "a SmallFunction kept inline did not survive a move" );
+  }
+
+  moved = move( big );
+  if ( big or moved( 1 ) != 103 ) {
+    throw runtime_error( "a SmallFunction kept on the heap did not survive a move" );
+  }
+}
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    check_against_reference( rd );
+    check_small_function();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
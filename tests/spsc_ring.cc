@@ -0,0 +1,73 @@
+#include "spsc_ring.hh"
+
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+int main()
+{
+  try {
+    // one thread: fills up, empties, and keeps order across the wrap-around
+    SPSCRing<unique_ptr<int>> ring { 5 };
+    if ( ring.capacity() != 8 or not ring.empty() ) {
+      throw runtime_error( "a new ring should be empty, with its capacity rounded up to a power of two" );
+    }
+    unique_ptr<int> value;
+    int next_in = 0;
+    int next_out = 0;
+    for ( int round = 0; round < 10; ++round ) {
+      while ( ring.push( make_unique<int>( next_in ) ) ) {
+        ++next_in;
+      }
+      if ( next_in - next_out != 8 ) {
+        throw runtime_error( "push() into a full ring should fail, and only then" );
+      }
+      for ( int i = 0; i < 3 + round % 5; ++i ) {
+        if ( not ring.pop( value ) or *value != next_out++ ) {
+          throw runtime_error( "pop() returned the wrong value" );
+        }
+      }
+    }
+    while ( ring.pop( value ) ) {
+      if ( *value != next_out++ ) {
+        throw runtime_error( "pop() returned the wrong value" );
+      }
+    }
+    if ( next_out != next_in or not ring.empty() ) {
+      throw runtime_error( "the ring lost values" );
+    }
+
+    // two threads: every value arrives, in order
+    constexpr uint64_t count = 1000000;
+    SPSCRing<uint64_t> shared { 64 };
+    thread producer { [&] {
+      for ( uint64_t i = 0; i < count; ++i ) {
+        while ( not shared.push( uint64_t { i } ) ) {
+          this_thread::yield();
+        }
+      }
+    } };
+    uint64_t expected = 0;
+    uint64_t received = 0;
+    bool in_order = true;
+    while ( expected < count ) {
+      if ( shared.pop( received ) ) {
+        in_order &= received == expected++;
+      } else {
+        this_thread::yield();
+      }
+    }
+    producer.join();
+    if ( not in_order or not shared.empty() ) {
+      throw runtime_error( "values passed between threads arrived out of order" );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,99 @@
+#include "address.hh"
+#include "tcp_over_ip.hh"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+void report( const string& name, const size_t iterations, const steady_clock::duration elapsed )
+{
+  const auto ns = duration_cast<duration<double, nano>>( elapsed ).count() / static_cast<double>( iterations );
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << name << ": " << fixed << setprecision( 1 ) << ns << " ns.\n";
+  debug_output << "             " << name << ": " << fixed << setprecision( 1 ) << ns << " ns\n";
+}
+
+// What a connection's adapter does for each outbound segment: serialize it, with the configured addresses and
+// ports, into a frame
+void wrap_speed_test( TCPOverIPv4Adapter& adapter, const size_t iterations )
+{
+  TCPMessage ack;
+  ack.receiver.ackno = Wrap32 { 12345 };
+  ack.receiver.window_size = 65000;
+
+  array<char, 120> frame_buffer {};
+  size_t bytes = 0;
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < iterations; ++i ) {
+    ack.sender.seqno = Wrap32 { static_cast<uint32_t>( i ) };
+    Serializer frame { frame_buffer };
+    adapter.wrap_tcp_in_ip( ack, frame );
+    bytes += frame.views().front().size();
+  }
+  const auto elapsed = steady_clock::now() - start_time;
+
+  if ( bytes != iterations * 40 ) {
+    throw runtime_error( "wrap_tcp_in_ip produced the wrong length" );
+  }
+  report( "TCPOverIPv4Adapter wrap per segment", iterations, elapsed );
+}
+
+// ... and for each inbound one: parse it, and check that it belongs to the configured connection
+void unwrap_speed_test( TCPOverIPv4Adapter& adapter, const size_t iterations )
+{
+  TCPOverIPv4Adapter peer;
+  peer.config_mut().source = adapter.config().destination;
+  peer.config_mut().destination = adapter.config().source;
+  TCPMessage ack;
+  ack.receiver.ackno = Wrap32 { 12345 };
+  ack.receiver.window_size = 65000;
+  const InternetDatagram datagram = peer.wrap_tcp_in_ip( ack );
+
+  size_t accepted = 0;
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < iterations; ++i ) {
+    accepted += adapter.unwrap_tcp_in_ip( datagram ).has_value();
+  }
+  const auto elapsed = steady_clock::now() - start_time;
+
+  if ( accepted != iterations ) {
+    throw runtime_error( "unwrap_tcp_in_ip rejected a segment for its connection" );
+  }
+  report( "TCPOverIPv4Adapter unwrap per segment", iterations, elapsed );
+}
+
+void program_body()
+{
+  TCPOverIPv4Adapter adapter;
+  adapter.config_mut().source = Address { "169.254.144.9", 9090 };
+  adapter.config_mut().destination = Address { "169.254.144.1", 6001 };
+
+  wrap_speed_test( adapter, 1000000 );
+  unwrap_speed_test( adapter, 1000000 );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
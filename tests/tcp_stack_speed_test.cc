@@ -0,0 +1,133 @@
+#include "fake_tun.hh"
+#include "tcp_stack.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+const Address client_address { "10.144.0.1" };
+const Address server_address { "10.144.0.2", 80 };
+
+// Read everything available on the connection; returns true once its inbound stream has finished
+bool drain( TCPStack& stack, TCPStack::ConnectionId id, uint64_t& bytes )
+{
+  Reader& reader = stack.inbound_reader( id );
+  while ( reader.bytes_buffered() ) {
+    bytes += reader.peek().size();
+    reader.pop( reader.peek().size() );
+  }
+  return reader.is_finished();
+}
+
+// The server accepts every connection, reads it to the end, and then closes it
+void run_server( TunFD tun, atomic<uint64_t>& bytes_received, const atomic<bool>& stop )
+{
+  TCPStack server { TCPOverIPv4OverTunFdAdapter { move( tun ) }, server_address };
+  server.listen( server_address.port() );
+  vector<TCPStack::ConnectionId> ready;
+  uint64_t bytes = 0;
+
+  while ( not stop ) {
+    server.wait_next_event( 10 );
+    while ( server.accept( server_address.port() ).has_value() ) {}
+    server.take_active( ready );
+    for ( const auto id : ready ) {
+      if ( drain( server, id, bytes ) ) {
+        server.close( id );
+      }
+    }
+    bytes_received = bytes;
+  }
+}
+
+// Open `num_connections` connections at once, each sending `bytes_per_connection` bytes and then closing, and time
+// how long it takes until the server has closed every one of them.
+void tcp_stack_speed_test( const size_t num_connections, const size_t bytes_per_connection )
+{
+  FakeTunWire wire;
+  atomic<bool> stop {};
+  atomic<uint64_t> bytes_received {};
+  thread server { run_server, wire.take_b(), ref( bytes_received ), cref( stop ) };
+
+  TCPStack client { TCPOverIPv4OverTunFdAdapter { wire.take_a() }, client_address };
+  const string payload( bytes_per_connection, 'x' );
+  vector<TCPStack::ConnectionId> ready;
+  size_t finished = 0;
+  uint64_t unexpected_bytes = 0;
+
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < num_connections; ++i ) {
+    const auto id = client.connect( server_address );
+    client.outbound_writer( id ).push( payload );
+    client.outbound_writer( id ).close();
+  }
+
+  while ( finished < num_connections ) {
+    if ( client.wait_next_event( 5000 ) != EventLoop::Result::Success ) {
+      throw runtime_error( "TCPStack connections stalled" );
+    }
+    client.take_active( ready );
+    for ( const auto id : ready ) {
+      if ( drain( client, id, unexpected_bytes ) ) {
+        ++finished;
+        client.close( id );
+      }
+    }
+  }
+  const auto stop_time = steady_clock::now();
+
+  wire.stop();
+  stop = true;
+  server.join();
+
+  if ( bytes_received != num_connections * bytes_per_connection or unexpected_bytes != 0 ) {
+    throw runtime_error( "TCPStack did not deliver exactly the bytes that were sent" );
+  }
+
+  const auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  const auto connections_per_second = static_cast<double>( num_connections ) / test_duration.count();
+  const auto gigabits_per_second
+    = static_cast<double>( num_connections * bytes_per_connection ) * 8.0 / test_duration.count() / 1e9;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "TCPStack with " << num_connections << " concurrent connections of " << bytes_per_connection
+       << " bytes: " << fixed << setprecision( 2 ) << test_duration.count() << " s, " << setprecision( 0 )
+       << connections_per_second << " connections/s, " << setprecision( 3 ) << gigabits_per_second << " Gbit/s.\n";
+  debug_output << "             TCPStack (" << num_connections << " connections): " << fixed << setprecision( 0 )
+               << connections_per_second << " connections/s\n";
+}
+
+void program_body()
+{
+  tcp_stack_speed_test( 100, 50000 );
+  tcp_stack_speed_test( 1000, 10000 );
+  tcp_stack_speed_test( 5000, 1000 );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+#include "eventloop.hh"
+#include "random.hh"
+#include "timer_wheel.hh"
+
+#include <iostream>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+// Check the wheel against a plain ordered map of pending timers: every timer must fire exactly at its
+// deadline, once, unless it was cancelled first.
+void check_against_reference( default_random_engine& rd, const uint64_t max_delay, const uint64_t max_step )
+{
+  TimerWheel<uint64_t> wheel { rd() % 1000000 };
+  map<uint64_t, uint64_t> reference; // serial number -> deadline
+  vector<pair<TimerWheel<uint64_t>::Id, uint64_t>> ids;
+  uint64_t serial = 0;
+
+  for ( unsigned int round = 0; round < 2000; ++round ) {
+    for ( unsigned int i = rd() % 4; i > 0; --i ) {
+      const uint64_t deadline = wheel.now() + 1 + rd() % max_delay;
+      ids.emplace_back( wheel.schedule( deadline, serial ), serial );
+      reference[serial++] = deadline;
+    }
+
+    if ( not ids.empty() and rd() % 3 == 0 ) {
+      const auto [id, which] = ids.at( rd() % ids.size() );
+      if ( wheel.cancel( id ) != reference.contains( which ) ) {
+        throw runtime_error( "cancel() disagreed about whether a timer was pending" );
+      }
+      reference.erase( which );
+    }
+
+    if ( wheel.size() != reference.size() ) {
+      throw runtime_error( "size() does not match the number of pending timers" );
+    }
+
+    uint64_t earliest = UINT64_MAX;
+    for ( const auto& [which, deadline] : reference ) {
+      earliest = min( earliest, deadline );
+    }
+    const auto next = wheel.next_deadline();
+    if ( next.has_value() != not reference.empty() or ( next.has_value() and next.value() != earliest ) ) {
+      throw runtime_error( "next_deadline() is not the earliest pending deadline" );
+    }
+
+    const uint64_t target = wheel.now() + rd() % max_step;
+    wheel.advance( target, [&]( uint64_t now, uint64_t which ) {
+      const auto it = reference.find( which );
+      if ( it == reference.end() ) {
+        throw runtime_error( "a cancelled or already-fired timer fired" );
+      }
+      if ( it->second != now ) {
+        ostringstream ss;
+        ss << "timer due at " << it->second << " fired at " << now;
+        throw runtime_error( ss.str() );
+      }
+      reference.erase( it );
+    } );
+
+    for ( const auto& [which, deadline] : reference ) {
+      if ( deadline <= target ) {
+        throw runtime_error( "a timer did not fire by its deadline" );
+      }
+    }
+  }
+}
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    check_against_reference( rd, 50, 10 );            // level 0 only
+    check_against_reference( rd, 5000, 700 );         // cascades through levels 1 and 2
+    check_against_reference( rd, 40000000, 3000000 ); // every level, and the overflow list
+    check_against_reference( rd, 40000000, 70 );      // far timers with short steps
+
+    // a timer scheduled in the past fires on the next tick, and cancelling it afterwards is harmless
+    TimerWheel<int> wheel { 100 };
+    const auto id = wheel.schedule( 50, 7 );
+    int fired = 0;
+    wheel.advance( 101, [&]( uint64_t, int value ) { fired = value; } );
+    if ( fired != 7 or wheel.cancel( id ) or not wheel.empty() ) {
+      throw runtime_error( "a past-due timer did not fire on the next tick" );
+    }
+
+    // two EventLoop timers due together, each cancelling the other: only the one that runs first runs
+    for ( unsigned int attempt = 0; attempt < 3; ++attempt ) {
+      EventLoop loop;
+      unsigned int ran = 0;
+      optional<EventLoop::RuleHandle> first, second;
+      first = loop.add_timer( "first", 1, [&] {
+        ++ran;
+        second->cancel();
+      } );
+      second = loop.add_timer( "second", 1, [&] {
+        ++ran;
+        first->cancel();
+      } );
+      for ( unsigned int i = 0; i < 10 and loop.wait_next_event( 100 ) != EventLoop::Result::Exit; ++i ) {}
+      if ( ran != 1 ) {
+        throw runtime_error( "a timer ran after another timer due on the same tick cancelled it" );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,48 @@
+#include "address.hh"
+#include "toeplitz.hh"
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+// The IPv4/TCP examples from Microsoft's "Verifying the RSS Hash Calculation", with the default key
+struct Example
+{
+  string destination;
+  uint16_t destination_port;
+  string source;
+  uint16_t source_port;
+  uint32_t hash;
+};
+
+int main()
+{
+  try {
+    const ToeplitzHash hash;
+    for ( const auto& example : { Example { "161.142.100.80", 1766, "66.9.149.187", 2794, 0x51ccc178 },
+                                  Example { "65.69.140.83", 4739, "199.92.111.2", 14230, 0xc626b0ea },
+                                  Example { "12.22.207.184", 38024, "24.19.198.95", 12898, 0x5c2b394a },
+                                  Example { "209.142.163.6", 2217, "38.27.205.30", 48228, 0xafc7327f },
+                                  Example { "202.188.127.2", 1303, "153.39.163.191", 44251, 0x10e828a2 } } ) {
+      // the receiver of the example packet is the local end
+      const FourTuple flow { Address { example.destination }.ipv4_numeric(),
+                             Address { example.source }.ipv4_numeric(),
+                             example.destination_port,
+                             example.source_port };
+      if ( hash( flow ) != example.hash ) {
+        ostringstream ss;
+        ss << "hash of " << example.source << ":" << example.source_port << " -> " << example.destination << ":"
+           << example.destination_port << " was 0x" << hex << hash( flow ) << ", expected 0x" << example.hash;
+        throw runtime_error( ss.str() );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
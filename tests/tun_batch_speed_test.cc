@@ -0,0 +1,138 @@
+#include "fake_tun.hh"
+#include "tcp_minnow_socket_impl.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+const Address local_address { "10.144.0.1", 40000 };
+const Address remote_address { "10.144.0.2", 80 };
+
+// The far end: a TCPPeer that accepts the connection, sends `bytes` as fast as its window allows, and then closes.
+// It counts the bare acknowledgments that come back.
+void run_remote( TunFD tun, const size_t bytes, atomic<uint64_t>& acks, const atomic<bool>& stop )
+{
+  TCPOverIPv4OverTunFdAdapter adapter { move( tun ) };
+  adapter.config_mut().source = remote_address;
+  adapter.config_mut().destination = local_address;
+
+  TCPPeer peer { TCPConfig {} };
+  const auto transmit = [&]( const TCPMessage& msg ) { adapter.write( msg ); };
+  const string chunk( 1000, 'x' );
+  size_t remaining = bytes;
+  uint64_t bare_acks = 0;
+
+  EventLoop loop { EventLoop::Backend::Poll, EventLoop::Dispatch::All };
+  loop.add_rule( "segment", adapter.fd(), Direction::In, [&] {
+    if ( auto msg = adapter.read() ) {
+      bare_acks += msg->sender.sequence_length() == 0;
+      peer.receive( move( msg.value() ), transmit );
+    }
+  } );
+
+  auto last_tick = steady_clock::now();
+  while ( not stop ) {
+    const auto now = steady_clock::now();
+    peer.tick( duration_cast<milliseconds>( now - last_tick ).count(), transmit );
+    last_tick += duration_cast<milliseconds>( now - last_tick );
+
+    if ( peer.has_ackno() ) {
+      Writer& writer = peer.outbound_writer();
+      while ( remaining > 0 and writer.available_capacity() > 0 ) {
+        const size_t len = min( { remaining, chunk.size(), static_cast<size_t>( writer.available_capacity() ) } );
+        writer.push( chunk.substr( 0, len ) );
+        remaining -= len;
+      }
+      if ( remaining == 0 and not writer.is_closed() ) {
+        writer.close();
+      }
+      peer.push( transmit );
+    }
+    acks = bare_acks;
+    loop.wait_next_event( 5 );
+  }
+}
+
+// Download `bytes` through TCPMinnowSocket from a peer that sends whole windows at a time, and count the polls the
+// socket's TCP thread made and the acknowledgments it sent.
+void tun_batch_speed_test( const size_t bytes )
+{
+  FakeTunWire wire;
+  atomic<uint64_t> acks {};
+  atomic<bool> stop {};
+  thread remote { run_remote, wire.take_b(), bytes, ref( acks ), cref( stop ) };
+
+  TCPOverIPv4MinnowSocket socket { TCPOverIPv4OverTunFdAdapter { wire.take_a() } };
+  FdAdapterConfig adapter_config;
+  adapter_config.source = local_address;
+  adapter_config.destination = remote_address;
+
+  // (the socket lingers for ten retransmission timeouts after the streams finish, which the default would make
+  // ten seconds; nothing is lost on this wire, so a short one changes nothing else)
+  TCPConfig tcp_config;
+  tcp_config.rt_timeout = 100;
+
+  const auto start_time = steady_clock::now();
+  socket.connect( tcp_config, adapter_config );
+  socket.set_blocking( true );
+  string buffer;
+  size_t received = 0;
+  while ( not socket.eof() ) {
+    buffer.clear();
+    socket.read( buffer );
+    received += buffer.size();
+  }
+  const auto stop_time = steady_clock::now();
+  socket.wait_until_closed();
+
+  wire.stop();
+  stop = true;
+  remote.join();
+
+  if ( received != bytes ) {
+    throw runtime_error( "TCPMinnowSocket did not receive exactly the bytes that were sent" );
+  }
+
+  const auto megabytes = static_cast<double>( bytes ) / 1e6;
+  const auto seconds = duration_cast<duration<double>>( stop_time - start_time ).count();
+  const auto polls = static_cast<double>( socket.eventloop_stats().waits );
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "TCPMinnowSocket receiving " << megabytes << " MB: " << fixed << setprecision( 1 ) << polls / megabytes
+       << " polls/MB, " << static_cast<double>( acks ) / megabytes << " ACKs/MB, " << megabytes / seconds
+       << " MB/s.\n";
+  debug_output << "             TCPMinnowSocket download: " << fixed << setprecision( 1 ) << polls / megabytes
+               << " polls/MB, " << static_cast<double>( acks ) / megabytes << " ACKs/MB\n";
+}
+
+void program_body()
+{
+  tun_batch_speed_test( 4000000 );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
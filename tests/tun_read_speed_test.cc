@@ -0,0 +1,156 @@
+#include "exception.hh"
+#include "tcp_receiver.hh"
+#include "tuntap_adapter.hh"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include <sys/socket.h>
+
+using namespace std;
+using namespace std::chrono;
+
+// count heap allocations, to check that receiving a segment does not allocate
+namespace {
+atomic<uint64_t> allocations {};
+} // namespace
+
+void* operator new( size_t size )
+{
+  ++allocations;
+  if ( void* ptr = malloc( size ) ) { // NOLINT(*-no-malloc, *-owning-memory)
+    return ptr;
+  }
+  throw bad_alloc {};
+}
+
+void operator delete( void* ptr ) noexcept
+{
+  free( ptr ); // NOLINT(*-no-malloc, *-owning-memory)
+}
+
+void operator delete( void* ptr, size_t /* size */ ) noexcept
+{
+  free( ptr ); // NOLINT(*-no-malloc, *-owning-memory)
+}
+
+namespace {
+
+const Address local_address { "169.254.144.9", 9090 };
+const Address remote_address { "169.254.144.1", 6001 };
+
+// Send a stream of in-order segments through a socketpair standing in for a TUN device, and time the receiving
+// side: reading each datagram with TCPOverIPv4OverTunFdAdapter, giving it to a TCPReceiver, and reading the bytes
+// out of the inbound stream (which is when a received payload's buffer is released).
+void tun_read_speed_test( const ByteStream::Mode mode, const size_t payload_size, const size_t num_segments )
+{
+  constexpr size_t batch = 16;
+
+  array<int, 2> fds {};
+  CheckSystemCall( "socketpair", ::socketpair( AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds.data() ) );
+  FileDescriptor wire { fds[0] };
+  TCPOverIPv4OverTunFdAdapter adapter { TunFD { FileDescriptor { fds[1] } } };
+  adapter.config_mut().source = local_address;
+  adapter.config_mut().destination = remote_address;
+
+  TCPOverIPv4Adapter sender;
+  sender.config_mut().source = remote_address;
+  sender.config_mut().destination = local_address;
+
+  TCPReceiver receiver { Reassembler { ByteStream { 64000, mode } } };
+  const string payload( payload_size, 'x' );
+  array<char, 120> frame_buffer {};
+  TCPMessage msg;
+  msg.sender.seqno = Wrap32 { 1000 };
+
+  const auto send = [&] {
+    Serializer frame { frame_buffer };
+    sender.wrap_tcp_in_ip( msg, frame );
+    wire.write( frame.views() );
+    msg.sender.seqno = msg.sender.seqno + msg.sender.sequence_length();
+  };
+  const auto receive = [&] {
+    auto segment = adapter.read();
+    if ( not segment.has_value() ) {
+      throw runtime_error( "TCPOverIPv4OverTunFdAdapter rejected a segment" );
+    }
+    receiver.receive( move( segment->sender ) );
+    Reader& reader = receiver.reader();
+    while ( reader.bytes_buffered() ) {
+      reader.pop( reader.peek().size() );
+    }
+  };
+
+  msg.sender.SYN = true;
+  send();
+  receive();
+  msg.sender.SYN = false;
+  msg.sender.payload = payload;
+
+  // the first few batches let the buffers start going round; the rest are measured
+  constexpr size_t warmup = 4;
+  uint64_t receive_allocations = 0;
+  steady_clock::duration elapsed {};
+  for ( size_t round = 0; round < warmup + num_segments / batch; ++round ) {
+    for ( size_t i = 0; i < batch; ++i ) {
+      send();
+    }
+    const uint64_t start_allocations = allocations;
+    const auto start_time = steady_clock::now();
+    for ( size_t i = 0; i < batch; ++i ) {
+      receive();
+    }
+    if ( round >= warmup ) {
+      elapsed += steady_clock::now() - start_time;
+      receive_allocations += allocations - start_allocations;
+    }
+  }
+
+  if ( receiver.writer().bytes_pushed() != ( warmup * batch + num_segments ) * payload_size ) {
+    throw runtime_error( "TCPReceiver did not receive every byte that was sent" );
+  }
+
+  const auto measured = static_cast<double>( num_segments / batch * batch );
+  const auto seconds = duration_cast<duration<double>>( elapsed ).count();
+  const string name = string( mode == ByteStream::Mode::Chunked ? "chunked" : "ring" ) + ", "
+                      + to_string( payload_size ) + "-byte payloads";
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "TUN read (" << name << "): " << fixed << setprecision( 0 ) << measured / seconds << " packets/s, "
+       << setprecision( 1 ) << seconds / measured * 1e9 << " ns/packet, " << setprecision( 3 )
+       << static_cast<double>( receive_allocations ) / measured << " allocations/packet.\n";
+  debug_output << "             TUN read (" << name << "): " << fixed << setprecision( 0 ) << measured / seconds
+               << " packets/s\n";
+}
+
+void program_body()
+{
+  for ( const auto mode : { ByteStream::Mode::Chunked, ByteStream::Mode::Ring } ) {
+    for ( const size_t payload_size : { 1000, 536 } ) {
+      tun_read_speed_test( mode, payload_size, 200000 );
+    }
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,75 @@
+#include "simulated_link.hh"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+constexpr uint64_t LINK_RATE = 12500; // bytes per ms: 100 Mbit/s
+constexpr uint64_t LINK_DELAY = 50;   // ms each way
+
+// Send `bytes` across a simulated long fat link (100 Mbit/s, 50 ms each way: a bandwidth-delay product of 1.25 MB)
+// to a receiver with `capacity` bytes of buffer, with or without window scaling, and compare the goodput with the
+// link's rate.
+void window_scale_speed_test( const size_t capacity, const bool window_scaling, const uint64_t bytes )
+{
+  TCPConfig sender_config;
+  sender_config.window_scaling = window_scaling;
+  TCPConfig receiver_config;
+  receiver_config.recv_capacity = capacity;
+  receiver_config.window_scaling = window_scaling;
+
+  SimulatedTransfer transfer { sender_config,
+                               receiver_config,
+                               { .delay_ms = LINK_DELAY, .rate = LINK_RATE },
+                               { .delay_ms = LINK_DELAY },
+                               12345 };
+  const auto result = transfer.run( bytes, 100000000 );
+  if ( result.bytes != bytes ) {
+    throw runtime_error( "simulated transfer did not deliver exactly the bytes that were sent" );
+  }
+
+  const auto megabytes = static_cast<double>( bytes ) / 1e6;
+  const auto goodput = megabytes / ( static_cast<double>( result.elapsed_ms ) / 1000 );
+  const auto link_rate = static_cast<double>( LINK_RATE ) / 1000;
+  const string name = to_string( capacity / 1000 ) + " kB receive buffer, "
+                      + ( window_scaling ? "window scale " + to_string( receiver_config.window_scale().value() )
+                                         : string( "no window scaling" ) );
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "TCP transfer (" << name << "): " << fixed << setprecision( 2 ) << goodput << " MB/s simulated ("
+       << setprecision( 0 ) << goodput / link_rate * 100 << "% of the link), " << setprecision( 2 )
+       << megabytes / result.wall_seconds << " MB/s of CPU time.\n";
+  debug_output << "             TCP transfer (" << name << "): " << fixed << setprecision( 2 ) << goodput
+               << " MB/s\n";
+}
+
+void program_body()
+{
+  window_scale_speed_test( TCPConfig::DEFAULT_CAPACITY, false, 20000000 );
+  window_scale_speed_test( 4000000, false, 20000000 );
+  for ( const size_t capacity : { 1000000, 4000000 } ) {
+    window_scale_speed_test( capacity, true, 20000000 );
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
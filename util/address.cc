@@ -136,6 +136,22 @@ string Address::to_string() const
   return "(non-Internet address)";
 }
 
+uint16_t Address::port() const
+{
+  // the same answer as ip_port(), without formatting the address for getnameinfo and parsing the port back
+  if ( _address.storage.ss_family == AF_INET and _size == sizeof( sockaddr_in ) ) {
+    sockaddr_in ipv4_addr {};
+    memcpy( &ipv4_addr, &_address.storage, _size );
+    return be16toh( ipv4_addr.sin_port );
+  }
+  if ( _address.storage.ss_family == AF_INET6 and _size == sizeof( sockaddr_in6 ) ) {
+    sockaddr_in6 ipv6_addr {};
+    memcpy( &ipv6_addr, &_address.storage, _size );
+    return be16toh( ipv6_addr.sin6_port );
+  }
+  return ip_port().second;
+}
+
 uint32_t Address::ipv4_numeric() const
 {
   if ( _address.storage.ss_family != AF_INET or _size != sizeof( sockaddr_in ) ) {
@@ -148,11 +164,12 @@ uint32_t Address::ipv4_numeric() const
   return be32toh( ipv4_addr.sin_addr.s_addr );
 }
 
-Address Address::from_ipv4_numeric( const uint32_t ip_address )
+Address Address::from_ipv4_numeric( const uint32_t ip_address, const uint16_t port )
 {
   sockaddr_in ipv4_addr {};
   ipv4_addr.sin_family = AF_INET;
   ipv4_addr.sin_addr.s_addr = htobe32( ip_address );
+  ipv4_addr.sin_port = htobe16( port );
 
   return { reinterpret_cast<sockaddr*>( &ipv4_addr ), sizeof( ipv4_addr ) }; // NOLINT(*-reinterpret-cast)
 }
@@ -1,6 +1,7 @@
 #include "arp_message.hh"
 
 #include <arpa/inet.h>
+#include <cstring>
 #include <iomanip>
 #include <sstream>
 
@@ -32,6 +33,24 @@ string ARPMessage::to_string() const
 
 void ARPMessage::parse( Parser& parser )
 {
+  // fast path: the whole message is in one buffer
+  if ( const string_view fixed = parser.contiguous( LENGTH ); not fixed.empty() ) {
+    hardware_type = load_big_endian<uint16_t>( &fixed[0] );
+    protocol_type = load_big_endian<uint16_t>( &fixed[2] );
+    hardware_address_size = fixed[4];
+    protocol_address_size = fixed[5];
+    opcode = load_big_endian<uint16_t>( &fixed[6] );
+    memcpy( sender_ethernet_address.data(), &fixed[8], sender_ethernet_address.size() );
+    sender_ip_address = load_big_endian<uint32_t>( &fixed[14] );
+    memcpy( target_ethernet_address.data(), &fixed[18], target_ethernet_address.size() );
+    target_ip_address = load_big_endian<uint32_t>( &fixed[24] );
+    parser.remove_prefix( LENGTH );
+    if ( not supported() ) {
+      parser.set_error();
+    }
+    return;
+  }
+
   parser.integer( hardware_type );
   parser.integer( protocol_type );
   parser.integer( hardware_address_size );
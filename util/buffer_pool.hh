@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+//! A free list of equal-sized receive buffers, so that reading a datagram does not have to allocate one.
+//! \details A buffer from the pool is an ordinary std::string, which may be moved around, kept or freed like any
+//! other. Code that is done with received bytes (the Reassembler and ByteStream) hands its strings to recycle(),
+//! which keeps those that are pool buffers (recognized by their capacity) for the next take(). Each thread has its
+//! own pool, so there is no locking; a buffer taken on one thread and recycled on another joins the other's pool.
+class BufferPool
+{
+public:
+  //! Room for a datagram as large as Ethernet's 1500-byte MTU, once its first 40 bytes (the IPv4 and TCP headers)
+  //! have gone elsewhere.
+  static constexpr size_t BUFFER_SIZE = 1536;
+
+  //! The most buffers a pool holds on to (more than a 64 KB window's worth of segments)
+  static constexpr size_t MAX_FREE = 256;
+
+  BufferPool() { free_.reserve( MAX_FREE ); }
+
+  //! The calling thread's pool
+  static BufferPool& local()
+  {
+    thread_local BufferPool pool;
+    return pool;
+  }
+
+  //! Is `buffer` one of the pool's (or at least shaped like one)?
+  static bool is_buffer( const std::string& buffer ) { return buffer.capacity() == BUFFER_SIZE; }
+
+  //! Give `buffer` to the calling thread's pool if it is a pool buffer and the pool has room; otherwise free it
+  static void recycle( std::string&& buffer ) { local().give( std::move( buffer ) ); }
+
+  //! A buffer of BUFFER_SIZE bytes, with unspecified contents
+  std::string take()
+  {
+    std::string buffer;
+    if ( free_.empty() ) {
+      buffer.reserve( BUFFER_SIZE );
+    } else {
+      buffer = std::move( free_.back() );
+      free_.pop_back();
+    }
+    buffer.resize( BUFFER_SIZE );
+    return buffer;
+  }
+
+  void give( std::string&& buffer )
+  {
+    if ( is_buffer( buffer ) and free_.size() < MAX_FREE ) {
+      free_.push_back( std::move( buffer ) );
+    }
+  }
+
+  //! The number of buffers waiting to be taken
+  size_t size() const { return free_.size(); }
+
+private:
+  std::vector<std::string> free_ {};
+};
@@ -0,0 +1,160 @@
+#include "checksum.hh"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+
+#if defined( __x86_64__ )
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// Every kernel sums the buffer as 64-bit words loaded in host byte order, with end-around carry. Since
+// 2^16 = 1 (mod 0xffff), this is the same ones' complement sum as adding up its 16-bit words, and (RFC 1071)
+// summing in host order only byte-swaps the folded result.
+
+namespace {
+
+uint64_t add_with_carry( uint64_t sum, uint64_t word )
+{
+  sum += word;
+  return sum + ( sum < word );
+}
+
+uint64_t sum_words( const uint8_t* data, size_t len, uint64_t sum )
+{
+  for ( ; len >= 32; data += 32, len -= 32 ) {
+    array<uint64_t, 4> words {};
+    memcpy( words.data(), data, 32 );
+    sum = add_with_carry( sum, words[0] );
+    sum = add_with_carry( sum, words[1] );
+    sum = add_with_carry( sum, words[2] );
+    sum = add_with_carry( sum, words[3] );
+  }
+  for ( ; len >= 8; data += 8, len -= 8 ) {
+    uint64_t word {};
+    memcpy( &word, data, 8 );
+    sum = add_with_carry( sum, word );
+  }
+  // the tail lands in the same byte positions of a zeroed word, which pads an odd last byte with zero
+  if ( len > 0 ) {
+    uint64_t word {};
+    memcpy( &word, data, len );
+    sum = add_with_carry( sum, word );
+  }
+  return sum;
+}
+
+#if defined( __x86_64__ )
+// The vector kernels widen 16-bit lanes into 32-bit accumulators. Each step adds at most 2 * 0xffff to a
+// lane, so the accumulators are drained into the 64-bit sum before they could overflow.
+constexpr size_t max_vector_steps = 32768;
+
+uint64_t sum_sse2( const uint8_t* data, size_t len, uint64_t sum )
+{
+  const __m128i zero = _mm_setzero_si128();
+  while ( len >= 16 ) {
+    const size_t steps = min( len / 16, max_vector_steps );
+    __m128i acc = zero;
+    for ( size_t i = 0; i < steps; ++i, data += 16 ) {
+      const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( data ) );
+      acc = _mm_add_epi32( acc, _mm_unpacklo_epi16( v, zero ) );
+      acc = _mm_add_epi32( acc, _mm_unpackhi_epi16( v, zero ) );
+    }
+    len -= steps * 16;
+
+    array<uint32_t, 4> lanes {};
+    _mm_storeu_si128( reinterpret_cast<__m128i*>( lanes.data() ), acc );
+    for ( const auto lane : lanes ) {
+      sum = add_with_carry( sum, lane );
+    }
+  }
+  return sum_words( data, len, sum );
+}
+
+__attribute__( ( target( "avx2" ) ) ) uint64_t sum_avx2( const uint8_t* data, size_t len, uint64_t sum )
+{
+  const __m256i zero = _mm256_setzero_si256();
+  while ( len >= 32 ) {
+    const size_t steps = min( len / 32, max_vector_steps );
+    __m256i acc = zero;
+    for ( size_t i = 0; i < steps; ++i, data += 32 ) {
+      const __m256i v = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( data ) );
+      acc = _mm256_add_epi32( acc, _mm256_unpacklo_epi16( v, zero ) );
+      acc = _mm256_add_epi32( acc, _mm256_unpackhi_epi16( v, zero ) );
+    }
+    len -= steps * 32;
+
+    array<uint32_t, 8> lanes {};
+    _mm256_storeu_si256( reinterpret_cast<__m256i*>( lanes.data() ), acc );
+    for ( const auto lane : lanes ) {
+      sum = add_with_carry( sum, lane );
+    }
+  }
+  return sum_words( data, len, sum );
+}
+#endif
+
+// Fold a host-order sum to 16 bits with end-around carry, and put it in network byte order.
+uint16_t fold( uint64_t sum )
+{
+  while ( sum > 0xffff ) {
+    sum = ( sum >> 16 ) + static_cast<uint16_t>( sum );
+  }
+  const auto folded = static_cast<uint16_t>( sum );
+  return endian::native == endian::little ? static_cast<uint16_t>( folded << 8 | folded >> 8 ) : folded;
+}
+
+} // namespace
+
+bool InternetChecksum::supported( Kernel kernel )
+{
+  switch ( kernel ) {
+    case Kernel::Scalar:
+      return true;
+#if defined( __x86_64__ )
+    case Kernel::SSE2:
+      return true;
+    case Kernel::AVX2:
+      return __builtin_cpu_supports( "avx2" );
+#endif
+    default:
+      return false;
+  }
+}
+
+InternetChecksum::Kernel InternetChecksum::fastest_kernel()
+{
+  static const Kernel fastest = supported( Kernel::AVX2 ) ? Kernel::AVX2
+                                : supported( Kernel::SSE2 ) ? Kernel::SSE2
+                                                            : Kernel::Scalar;
+  return fastest;
+}
+
+void InternetChecksum::add( std::string_view data )
+{
+  const auto* bytes = reinterpret_cast<const uint8_t*>( data.data() );
+  uint64_t sum {};
+  switch ( kernel_ ) {
+#if defined( __x86_64__ )
+    case Kernel::AVX2:
+      sum = sum_avx2( bytes, data.size(), 0 );
+      break;
+    case Kernel::SSE2:
+      sum = sum_sse2( bytes, data.size(), 0 );
+      break;
+#endif
+    default:
+      sum = sum_words( bytes, data.size(), 0 );
+  }
+
+  // after an odd number of bytes, this buffer starts in the low half of a word, so its sum is byte-swapped
+  uint16_t folded = fold( sum );
+  if ( parity_ ) {
+    folded = static_cast<uint16_t>( folded << 8 | folded >> 8 );
+  }
+  sum_ += folded;
+  parity_ ^= data.size() % 2;
+}
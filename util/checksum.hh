@@ -2,32 +2,51 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 //! The internet checksum algorithm
 class InternetChecksum
 {
-private:
-  uint32_t sum_;
-  bool parity_ {};
-
 public:
-  explicit InternetChecksum( const uint32_t sum = 0 ) : sum_( sum ) {}
-  void add( std::string_view data )
+  //! Ways of summing a buffer; all give the same result
+  enum class Kernel
   {
-    for ( const uint8_t i : data ) {
-      uint16_t val = i;
-      if ( not parity_ ) {
-        val <<= 8;
-      }
-      sum_ += val;
-      parity_ = !parity_;
-    }
+    Scalar, //!< 64-bit words with end-around carry
+    SSE2,   //!< 16-byte vectors (x86-64 only)
+    AVX2    //!< 32-byte vectors (x86-64 CPUs that support it)
+  };
+
+  static bool supported( Kernel kernel );
+  static Kernel fastest_kernel(); //!< the fastest kernel this CPU supports, picked once
+
+  explicit InternetChecksum( const uint32_t sum = 0, const Kernel kernel = fastest_kernel() )
+    : sum_( sum ), kernel_( kernel )
+  {}
+
+  void add( std::string_view data );
+
+  //! A checksum after one 16-bit word it covers changes from `old_word` to `new_word` (RFC 1624, eqn. 3)
+  static uint16_t adjust16( uint16_t cksum, uint16_t old_word, uint16_t new_word )
+  {
+    uint32_t sum = static_cast<uint16_t>( ~cksum );
+    sum += static_cast<uint16_t>( ~old_word );
+    sum += new_word;
+    sum = ( sum >> 16 ) + ( sum & 0xffff );
+    sum += sum >> 16;
+    return ~static_cast<uint16_t>( sum );
+  }
+
+  //! The same, for a 32-bit field (two words)
+  static uint16_t adjust32( uint16_t cksum, uint32_t old_value, uint32_t new_value )
+  {
+    cksum = adjust16( cksum, old_value >> 16, new_value >> 16 );
+    return adjust16( cksum, static_cast<uint16_t>( old_value ), static_cast<uint16_t>( new_value ) );
   }
 
   uint16_t value() const
   {
-    uint32_t ret = sum_;
+    uint64_t ret = sum_;
 
     while ( ret > 0xffff ) {
       ret = ( ret >> 16 ) + static_cast<uint16_t>( ret );
@@ -49,4 +68,9 @@ public:
       add( x );
     }
   }
+
+private:
+  uint64_t sum_;
+  bool parity_ {}; //!< whether an odd number of bytes has been added so far
+  Kernel kernel_;
 };
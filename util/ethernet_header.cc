@@ -1,5 +1,6 @@
 #include "ethernet_header.hh"
 
+#include <cstring>
 #include <iomanip>
 #include <sstream>
 
@@ -43,6 +44,15 @@ string EthernetHeader::to_string() const
 
 void EthernetHeader::parse( Parser& parser )
 {
+  // fast path: the whole header is in one buffer
+  if ( const string_view fixed = parser.contiguous( LENGTH ); not fixed.empty() ) {
+    memcpy( dst.data(), &fixed[0], dst.size() );
+    memcpy( src.data(), &fixed[6], src.size() );
+    type = load_big_endian<uint16_t>( &fixed[12] );
+    parser.remove_prefix( LENGTH );
+    return;
+  }
+
   // read destination address
   for ( auto& b : dst ) {
     parser.integer( b );
@@ -2,12 +2,34 @@
 #include "exception.hh"
 #include "socket.hh"
 
+#include <chrono>
+#include <climits>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
 
 using namespace std;
 
+namespace {
+uint64_t now_ms()
+{
+  return chrono::duration_cast<chrono::milliseconds>( chrono::steady_clock::now().time_since_epoch() ).count();
+}
+} // namespace
+
+// epoll reports readiness with the same bits as poll, so the two backends share the event handling
+static_assert( EPOLLIN == POLLIN and EPOLLOUT == POLLOUT and EPOLLERR == POLLERR and EPOLLHUP == POLLHUP );
+
+EventLoop::EventLoop( const Backend backend, const Dispatch dispatch )
+  : _rules( make_shared<Rules>( now_ms() ) ), _dispatch( dispatch )
+{
+  _rule_categories.reserve( 64 );
+  if ( backend == Backend::Epoll ) {
+    _epoll.emplace( CheckSystemCall( "epoll_create1", ::epoll_create1( EPOLL_CLOEXEC ) ) );
+    _epoll_events.resize( 64 );
+  }
+}
+
 unsigned int EventLoop::FDRule::service_count() const
 {
   return direction == Direction::In ? fd.read_count() : fd.write_count();
@@ -32,7 +54,7 @@ EventLoop::FDRule::FDRule( BasicRule&& base,
                            Direction s_direction,
                            CallbackT s_cancel,
                            CallbackT s_error )
-  : BasicRule( base )
+  : BasicRule( move( base ) )
   , fd( move( s_fd ) )
   , direction( s_direction )
   , cancel( move( s_cancel ) )
@@ -42,54 +64,167 @@ EventLoop::FDRule::FDRule( BasicRule&& base,
 EventLoop::RuleHandle EventLoop::add_rule( size_t category_id,
                                            FileDescriptor& fd,
                                            Direction direction,
-                                           const CallbackT& callback,
-                                           const InterestT& interest,
-                                           const CallbackT& cancel, // NOLINT(*-easily-swappable-*)
-                                           const CallbackT& error )
+                                           CallbackT callback,
+                                           InterestT interest,
+                                           CallbackT cancel, // NOLINT(*-easily-swappable-*)
+                                           CallbackT error )
 {
   if ( category_id >= _rule_categories.size() ) {
     throw out_of_range( "bad category_id" );
   }
 
-  _fd_rules.emplace_back( make_shared<FDRule>(
-    BasicRule { category_id, interest, callback }, fd.duplicate(), direction, cancel, error ) );
+  const SlotKey key = _rules->fd.emplace( BasicRule { category_id, move( interest ), move( callback ) },
+                                          fd.duplicate(),
+                                          direction,
+                                          move( cancel ),
+                                          move( error ) );
 
-  return RuleHandle { _fd_rules.back() };
+  return RuleHandle { _rules, RuleHandle::Kind::FD, key };
+}
+
+EventLoop::TimerRule::TimerRule( BasicRule&& base, uint64_t s_period_ms )
+  : BasicRule( move( base ) ), period_ms( s_period_ms )
+{}
+
+EventLoop::RuleHandle EventLoop::add_timer( const size_t category_id,
+                                            const uint64_t delay_ms,
+                                            CallbackT callback,
+                                            const uint64_t period_ms )
+{
+  if ( category_id >= _rule_categories.size() ) {
+    throw out_of_range( "bad category_id" );
+  }
+
+  const SlotKey key = _rules->timer.emplace( BasicRule { category_id, [] { return true; }, move( callback ) },
+                                             period_ms );
+  _rules->timer.find( key )->timer_id = _rules->timers.schedule( now_ms() + delay_ms, key );
+
+  return RuleHandle { _rules, RuleHandle::Kind::Timer, key };
 }
 
 EventLoop::RuleHandle EventLoop::add_rule( const size_t category_id,
-                                           const CallbackT& callback,
-                                           const InterestT& interest )
+                                           CallbackT callback,
+                                           InterestT interest )
 {
   if ( category_id >= _rule_categories.size() ) {
     throw out_of_range( "bad category_id" );
   }
 
-  _non_fd_rules.emplace_back( make_shared<BasicRule>( category_id, interest, callback ) );
+  const SlotKey key = _rules->non_fd.emplace( category_id, move( interest ), move( callback ) );
 
-  return RuleHandle { _non_fd_rules.back() };
+  return RuleHandle { _rules, RuleHandle::Kind::NonFD, key };
 }
 
+// The EventLoop erases cancelled fd and non-fd rules itself, the next time it looks at them. A timer comes off
+// the wheel right away, and is erased unless it is the one running (which run_timers() erases afterwards). One
+// already taken off the wheel to run on this tick is erased too, and run_timers() skips it.
 void EventLoop::RuleHandle::cancel()
 {
-  const shared_ptr<BasicRule> rule_shared_ptr = rule_weak_ptr_.lock();
-  if ( rule_shared_ptr ) {
-    rule_shared_ptr->cancel_requested = true;
+  const shared_ptr<Rules> rules = rules_.lock();
+  if ( not rules ) {
+    return;
+  }
+
+  switch ( kind_ ) {
+    case Kind::FD:
+      if ( FDRule* rule = rules->fd.find( key_ ) ) {
+        rule->cancel_requested = true;
+      }
+      break;
+    case Kind::NonFD:
+      if ( BasicRule* rule = rules->non_fd.find( key_ ) ) {
+        rule->cancel_requested = true;
+      }
+      break;
+    case Kind::Timer:
+      if ( TimerRule* rule = rules->timer.find( key_ ) ) {
+        rule->cancel_requested = true;
+        rules->timers.cancel( rule->timer_id );
+        if ( rules->running_timer != key_ ) {
+          rules->timer.erase( key_ );
+        }
+      }
+      break;
+  }
+}
+
+// Runs the timers that are due, and reschedules the periodic ones. Returns whether any ran.
+bool EventLoop::run_timers()
+{
+  const size_t before = _stats.last_batch;
+  const uint64_t now = now_ms();
+  _rules->timers.advance( now, [&]( const uint64_t deadline, const SlotKey key ) {
+    TimerRule* const found = _rules->timer.find( key );
+    if ( found == nullptr ) {
+      return; // cancelled by a timer that ran before it on the same tick
+    }
+    TimerRule& rule = *found;
+    _rules->running_timer = key;
+    rule.callback();
+    _rules->running_timer.reset();
+    ++_stats.callbacks;
+    ++_stats.last_batch;
+
+    if ( rule.period_ms == 0 or rule.cancel_requested ) {
+      _rules->timer.erase( key );
+      return;
+    }
+
+    // keep to the original schedule, but skip any periods that were missed entirely
+    uint64_t next = deadline + rule.period_ms;
+    if ( next <= now ) {
+      next = now + rule.period_ms;
+    }
+    rule.timer_id = _rules->timers.schedule( next, key );
+  } );
+  return _stats.last_batch > before;
+}
+
+// The poll timeout: no longer than the caller asked for, and no later than the next timer.
+int EventLoop::wait_timeout( const int timeout_ms, const bool served ) const
+{
+  if ( served ) {
+    return 0;
   }
+
+  const auto deadline = _rules->timers.next_deadline();
+  if ( not deadline.has_value() ) {
+    return timeout_ms;
+  }
+
+  const uint64_t now = now_ms();
+  const auto until_deadline
+    = static_cast<int>( min<uint64_t>( deadline.value() > now ? deadline.value() - now : 0, INT_MAX ) );
+  return timeout_ms < 0 ? until_deadline : min( timeout_ms, until_deadline );
 }
 
 // NOLINTBEGIN(*-cognitive-complexity)
 // NOLINTBEGIN(*-signed-bitwise)
 EventLoop::Result EventLoop::wait_next_event( const int timeout_ms )
 {
-  // first, handle the non-file-descriptor-related rules
+  _stats.last_batch = 0;
+
+  // with Dispatch::All, rotate the rules so that each call starts with a different one
+  if ( _dispatch == Dispatch::All ) {
+    _rules->non_fd.rotate();
+    _rules->fd.rotate();
+  }
+
+  // first, run any timers that are due
+  bool served = run_timers();
+  if ( served and _dispatch == Dispatch::One ) {
+    return Result::Success;
+  }
+
+  // then handle the non-file-descriptor-related rules
   {
-    for ( auto it = _non_fd_rules.begin(); it != _non_fd_rules.end(); ) {
-      auto& this_rule = **it;
+    auto& non_fd_rules = _rules->non_fd;
+    for ( size_t position = 0; position < non_fd_rules.size(); ) {
+      auto& this_rule = non_fd_rules[position];
       bool rule_fired = false;
 
       if ( this_rule.cancel_requested ) {
-        it = _non_fd_rules.erase( it );
+        non_fd_rules.erase_at( position );
         continue;
       }
 
@@ -103,43 +238,53 @@ EventLoop::Result EventLoop::wait_next_event( const int timeout_ms )
 
         rule_fired = true;
         this_rule.callback();
+        ++_stats.callbacks;
+        ++_stats.last_batch;
       }
 
       if ( rule_fired ) {
-        return Result::Success; /* only serve one rule on each iteration */
+        if ( _dispatch == Dispatch::One ) {
+          return Result::Success; /* only serve one rule on each iteration */
+        }
+        served = true;
       }
 
-      ++it;
+      ++position;
     }
   }
 
+  if ( _epoll.has_value() ) {
+    return wait_next_fd_event_epoll( timeout_ms, served );
+  }
+
   // now the file-descriptor-related rules. poll any "interested" file descriptors
-  vector<pollfd> pollfds {};
-  pollfds.reserve( _fd_rules.size() );
+  auto& fd_rules = _rules->fd;
+  auto& pollfds = _pollfds;
+  pollfds.clear();
   bool something_to_poll = false;
 
   // set up the pollfd for each rule
-  for ( auto it = _fd_rules.begin(); it != _fd_rules.end(); ) { // NOTE: it gets erased or incremented in loop body
-    auto& this_rule = **it;
+  for ( size_t position = 0; position < fd_rules.size(); ) { // NOTE: rule gets erased or skipped in loop body
+    auto& this_rule = fd_rules[position];
 
     if ( this_rule.cancel_requested ) {
       //      this_rule.cancel();
       //      if rule is cancelled externally, no need to call the cancellation callback
       //      this makes it easier to cancel rules and delete captured objects right away
-      it = _fd_rules.erase( it );
+      fd_rules.erase_at( position );
       continue;
     }
 
     if ( this_rule.direction == Direction::In && this_rule.fd.eof() ) {
       // no more reading on this rule, it's reached eof
       this_rule.cancel();
-      it = _fd_rules.erase( it );
+      fd_rules.erase_at( position );
       continue;
     }
 
     if ( this_rule.fd.closed() ) {
       this_rule.cancel();
-      it = _fd_rules.erase( it );
+      fd_rules.erase_at( position );
       continue;
     }
 
@@ -149,78 +294,272 @@ EventLoop::Result EventLoop::wait_next_event( const int timeout_ms )
     } else {
       pollfds.push_back( { this_rule.fd.fd_num(), 0, 0 } ); // placeholder --- we still want errors
     }
-    ++it;
+    ++position;
   }
 
-  // quit if there is nothing left to poll
-  if ( not something_to_poll ) {
-    return Result::Exit;
+  // quit if there is nothing left to poll or wait for
+  if ( not something_to_poll and _rules->timers.empty() ) {
+    return served ? Result::Success : Result::Exit;
   }
 
   // call poll -- wait until one of the fds satisfies one of the rules (writeable/readable)
-  if ( 0 == CheckSystemCall( "poll", ::poll( pollfds.data(), pollfds.size(), timeout_ms ) ) ) {
-    return Result::Timeout;
-  }
-
-  // go through the poll results
-  for ( auto [it, idx] = make_pair( _fd_rules.begin(), static_cast<size_t>( 0 ) ); it != _fd_rules.end(); ++idx ) {
-    const auto& this_pollfd = pollfds.at( idx );
-    auto& this_rule = **it;
-
-    const auto poll_error = static_cast<bool>( this_pollfd.revents & ( POLLERR | POLLNVAL ) );
-    if ( poll_error ) {
-      /* see if fd is a socket */
-      int socket_error = 0;
-      socklen_t optlen = sizeof( socket_error );
-      const int ret = getsockopt( this_rule.fd.fd_num(), SOL_SOCKET, SO_ERROR, &socket_error, &optlen );
-      if ( ret == -1 and errno == ENOTSOCK ) {
-        cerr << "error on polled file descriptor for rule \"" << _rule_categories.at( this_rule.category_id ).name
-             << "\"\n";
-      } else if ( ret == -1 ) {
-        throw unix_error( "getsockopt" );
-      } else if ( optlen != sizeof( socket_error ) ) {
-        throw runtime_error( "unexpected length from getsockopt: " + to_string( optlen ) );
-      } else if ( socket_error ) {
-        cerr << "error on polled socket for rule \"" << _rule_categories.at( this_rule.category_id ).name
-             << "\": " << strerror( socket_error ) << "\n";
-      }
+  ++_stats.waits;
+  const int poll_timeout = wait_timeout( timeout_ms, served );
+  if ( 0 == CheckSystemCall( "poll", ::poll( pollfds.data(), pollfds.size(), poll_timeout ) ) ) {
+    return run_timers() or served ? Result::Success : Result::Timeout;
+  }
 
-      this_rule.error();
-      this_rule.cancel();
-      it = _fd_rules.erase( it );
+  // go through the poll results (rules that callbacks add meanwhile come after the last pollfd, and rules that
+  // callbacks cancel meanwhile are skipped)
+  for ( size_t position = 0, idx = 0; idx < pollfds.size(); ++idx ) {
+    const auto& this_pollfd = pollfds[idx];
+
+    if ( fd_rules[position].cancel_requested ) {
+      fd_rules.erase_at( position );
       continue;
     }
 
-    const auto poll_ready = static_cast<bool>( this_pollfd.revents & this_pollfd.events );
-    const auto poll_hup = static_cast<bool>( this_pollfd.revents & POLLHUP );
-    if ( poll_hup && ( ( this_pollfd.events && !poll_ready ) or ( this_rule.direction == Direction::Out ) ) ) {
-      // if we asked for the status, and the _only_ condition was a hangup, this FD is defunct:
-      //   - if it was POLLIN and nothing is readable, no more will ever be readable
-      //   - if it was POLLOUT, it will not be writable again
-      // additionally, consider FD defunct if rule will only query for Direction::Out
+    switch ( handle_events( fd_rules[position], this_pollfd.events, this_pollfd.revents ) ) {
+      case Outcome::Served:
+        if ( _dispatch == Dispatch::One ) {
+          return Result::Success; /* only serve one rule on each iteration */
+        }
+        break;
+      case Outcome::Cancelled:
+        fd_rules.erase_at( position );
+        continue;
+      case Outcome::Idle:
+        break;
+    }
+
+    ++position; // if we got here, it means we didn't call fd_rules.erase_at()
+  }
+
+  return Result::Success;
+}
+
+EventLoop::Outcome EventLoop::handle_events( FDRule& this_rule, const int16_t events, const int16_t revents )
+{
+  const auto poll_error = static_cast<bool>( revents & ( POLLERR | POLLNVAL ) );
+  if ( poll_error ) {
+    /* see if fd is a socket */
+    int socket_error = 0;
+    socklen_t optlen = sizeof( socket_error );
+    const int ret = getsockopt( this_rule.fd.fd_num(), SOL_SOCKET, SO_ERROR, &socket_error, &optlen );
+    if ( ret == -1 and errno == ENOTSOCK ) {
+      cerr << "error on polled file descriptor for rule \"" << _rule_categories.at( this_rule.category_id ).name
+           << "\"\n";
+    } else if ( ret == -1 ) {
+      throw unix_error( "getsockopt" );
+    } else if ( optlen != sizeof( socket_error ) ) {
+      throw runtime_error( "unexpected length from getsockopt: " + to_string( optlen ) );
+    } else if ( socket_error ) {
+      cerr << "error on polled socket for rule \"" << _rule_categories.at( this_rule.category_id ).name
+           << "\": " << strerror( socket_error ) << "\n";
+    }
+
+    this_rule.error();
+    this_rule.cancel();
+    return Outcome::Cancelled;
+  }
+
+  const auto poll_ready = static_cast<bool>( revents & events );
+  const auto poll_hup = static_cast<bool>( revents & POLLHUP );
+  if ( poll_hup && ( ( events && !poll_ready ) or ( this_rule.direction == Direction::Out ) ) ) {
+    // if we asked for the status, and the _only_ condition was a hangup, this FD is defunct:
+    //   - if it was POLLIN and nothing is readable, no more will ever be readable
+    //   - if it was POLLOUT, it will not be writable again
+    // additionally, consider FD defunct if rule will only query for Direction::Out
+    this_rule.cancel();
+    return Outcome::Cancelled;
+  }
+
+  if ( poll_ready ) {
+    // an earlier callback in this batch may have changed what the rule wants
+    if ( _stats.last_batch > 0 and not this_rule.interest() ) {
+      return Outcome::Idle;
+    }
+
+    // we only want to call callback if revents includes the event we asked for
+    const auto count_before = this_rule.service_count();
+    this_rule.callback();
+    ++_stats.callbacks;
+    ++_stats.last_batch;
+
+    if ( count_before == this_rule.service_count() and ( not this_rule.fd.closed() ) and this_rule.interest() ) {
+      throw runtime_error( "EventLoop: busy wait detected: rule \""
+                           + _rule_categories.at( this_rule.category_id ).name
+                           + "\" did not read/write fd and is still interested" );
+    }
+
+    return Outcome::Served;
+  }
+
+  return Outcome::Idle;
+}
+
+// Each fd number is registered once, with data.ptr pointing at the EpollEntry that lists its rules. Rules join
+// their entry lazily (below), after rules on a closed fd that shared its number have been dropped.
+EventLoop::Result EventLoop::wait_next_fd_event_epoll( const int timeout_ms, bool served )
+{
+  bool something_to_poll = false;
+  FDRule* always_ready_rule = nullptr;
+
+  auto& fd_rules = _rules->fd;
+  for ( size_t position = 0; position < fd_rules.size(); ) { // NOTE: rule gets erased or skipped in loop body
+    auto& this_rule = fd_rules[position];
+
+    if ( this_rule.cancel_requested ) {
+      epoll_forget( this_rule );
+      fd_rules.erase_at( position );
+      continue;
+    }
+
+    if ( ( this_rule.direction == Direction::In && this_rule.fd.eof() ) or this_rule.fd.closed() ) {
       this_rule.cancel();
-      it = _fd_rules.erase( it );
+      epoll_forget( this_rule );
+      fd_rules.erase_at( position );
       continue;
     }
 
-    if ( poll_ready ) {
-      // we only want to call callback if revents includes the event we asked for
-      const auto count_before = this_rule.service_count();
-      this_rule.callback();
+    if ( not this_rule.watched ) {
+      epoll_watch( this_rule );
+    }
+
+    const bool interested = this_rule.interest();
+    if ( interested != this_rule.interested ) {
+      this_rule.interested = interested;
+      epoll_update( _epoll_entries.at( this_rule.fd.fd_num() ), this_rule.fd.fd_num() );
+    }
 
-      if ( count_before == this_rule.service_count() and ( not this_rule.fd.closed() ) and this_rule.interest() ) {
-        throw runtime_error( "EventLoop: busy wait detected: rule \""
-                             + _rule_categories.at( this_rule.category_id ).name
-                             + "\" did not read/write fd and is still interested" );
+    if ( interested ) {
+      something_to_poll = true;
+      if ( always_ready_rule == nullptr and _epoll_entries.at( this_rule.fd.fd_num() ).always_ready ) {
+        always_ready_rule = &this_rule;
       }
+    }
+    ++position;
+  }
 
-      return Result::Success; /* only serve one rule on each iteration */
+  // quit if there is nothing left to poll or wait for
+  if ( not something_to_poll and _rules->timers.empty() ) {
+    return served ? Result::Success : Result::Exit;
+  }
+
+  if ( always_ready_rule != nullptr ) {
+    const auto direction = static_cast<int16_t>( always_ready_rule->direction );
+    const Outcome outcome = handle_events( *always_ready_rule, direction, direction );
+    if ( outcome == Outcome::Cancelled ) {
+      always_ready_rule->cancel_requested = true; // already cancelled; erased on the next call
+    }
+    if ( _dispatch == Dispatch::One ) {
+      return Result::Success;
     }
+    served |= outcome == Outcome::Served;
+  }
 
-    ++it; // if we got here, it means we didn't call _fd_rules.erase()
+  ++_stats.waits;
+  const int ready = CheckSystemCall( "epoll_wait",
+                                     ::epoll_wait( _epoll->fd_num(),
+                                                   _epoll_events.data(),
+                                                   static_cast<int>( _epoll_events.size() ),
+                                                   wait_timeout( timeout_ms, served ) ) );
+  if ( ready == 0 ) {
+    return run_timers() or served ? Result::Success : Result::Timeout;
+  }
+
+  // rules only join or leave an entry above, so the entries stay put while their callbacks run
+  for ( int i = 0; i < ready; ++i ) {
+    const auto& event = _epoll_events.at( i );
+    const auto& entry = *static_cast<EpollEntry*>( event.data.ptr );
+    for ( FDRule* rule : entry.rules ) {
+      if ( rule->cancel_requested ) {
+        continue;
+      }
+      const auto events = static_cast<int16_t>( rule->interested ? static_cast<int16_t>( rule->direction ) : 0 );
+      switch ( handle_events( *rule, events, static_cast<int16_t>( event.events ) ) ) {
+        case Outcome::Served:
+          if ( _dispatch == Dispatch::One ) {
+            return Result::Success; /* only serve one rule on each iteration */
+          }
+          break;
+        case Outcome::Cancelled:
+          rule->cancel_requested = true; // already cancelled; erased on the next call
+          break;
+        case Outcome::Idle:
+          break;
+      }
+    }
   }
 
   return Result::Success;
 }
+
+void EventLoop::epoll_watch( FDRule& rule )
+{
+  const int fd_num = rule.fd.fd_num();
+  auto [it, inserted] = _epoll_entries.try_emplace( fd_num );
+  auto& entry = it->second;
+  if ( inserted ) {
+    epoll_event event {};
+    event.data.ptr = &entry;
+    if ( ::epoll_ctl( _epoll->fd_num(), EPOLL_CTL_ADD, fd_num, &event ) == -1 ) {
+      if ( errno != EPERM ) {
+        _epoll_entries.erase( it );
+        throw unix_error( "epoll_ctl" );
+      }
+      entry.always_ready = true;
+    }
+  }
+  entry.rules.push_back( &rule );
+  rule.watched = true;
+}
+
+void EventLoop::epoll_forget( FDRule& rule )
+{
+  if ( not rule.watched ) {
+    return;
+  }
+
+  const int fd_num = rule.fd.fd_num();
+  auto it = _epoll_entries.find( fd_num );
+  auto& entry = it->second;
+  erase( entry.rules, &rule );
+  rule.watched = false;
+
+  if ( not entry.rules.empty() ) {
+    if ( not rule.fd.closed() ) {
+      epoll_update( entry, fd_num );
+    }
+    return;
+  }
+
+  // closing the last descriptor of a file removes it from the epoll set already
+  if ( not entry.always_ready and not rule.fd.closed() ) {
+    CheckSystemCall( "epoll_ctl", ::epoll_ctl( _epoll->fd_num(), EPOLL_CTL_DEL, fd_num, nullptr ) );
+  }
+  _epoll_entries.erase( it );
+}
+
+// Registers the union of the entry's interested directions, if it changed.
+void EventLoop::epoll_update( EpollEntry& entry, const int fd_num )
+{
+  uint32_t events = 0;
+  for ( const FDRule* rule : entry.rules ) {
+    if ( rule->interested ) {
+      events |= static_cast<uint32_t>( rule->direction );
+    }
+  }
+
+  if ( events == entry.events or entry.always_ready ) {
+    return;
+  }
+
+  epoll_event event {};
+  event.events = events;
+  event.data.ptr = &entry;
+  CheckSystemCall( "epoll_ctl", ::epoll_ctl( _epoll->fd_num(), EPOLL_CTL_MOD, fd_num, &event ) );
+  entry.events = events;
+}
 // NOLINTEND(*-signed-bitwise)
 // NOLINTEND(*-cognitive-complexity)
@@ -1,13 +1,17 @@
 #pragma once
 
-#include <functional>
-#include <list>
 #include <memory>
+#include <optional>
 #include <ostream>
 #include <poll.h>
 #include <string_view>
+#include <sys/epoll.h>
+#include <unordered_map>
 
 #include "file_descriptor.hh"
+#include "slot_map.hh"
+#include "small_function.hh"
+#include "timer_wheel.hh"
 
 //! Waits for events on file descriptors and executes corresponding callbacks.
 class EventLoop
@@ -20,9 +24,31 @@ public:
     Out = POLLOUT //!< Callback will be triggered when Rule::fd is writable.
   };
 
+  //! How EventLoop::wait_next_event waits for the file descriptors.
+  enum class Backend
+  {
+    Poll, //!< Builds a pollfd for every rule on every call to [poll(2)](\ref man2::poll).
+    Epoll //!< Registers each fd once with [epoll(7)](\ref man7::epoll), updating it when interest changes.
+  };
+
+  //! How many ready rules each call to EventLoop::wait_next_event serves.
+  enum class Dispatch
+  {
+    One, //!< The first ready rule.
+    All  //!< Every rule found ready by one poll, starting one rule further along on each call (round-robin).
+  };
+
+  //! Counters kept by the EventLoop.
+  struct Stats
+  {
+    uint64_t waits {};     //!< calls to poll() or epoll_wait()
+    uint64_t callbacks {}; //!< rule callbacks run
+    size_t last_batch {};  //!< rule callbacks run by the latest call to EventLoop::wait_next_event
+  };
+
 private:
-  using CallbackT = std::function<void( void )>;
-  using InterestT = std::function<bool( void )>;
+  using CallbackT = SmallFunction<void( void )>;
+  using InterestT = SmallFunction<bool( void )>;
 
   struct RuleCategory
   {
@@ -32,9 +58,9 @@ private:
   struct BasicRule
   {
     size_t category_id;
+    bool cancel_requested {}; //!< kept next to interest, which the loop also reads for every rule
     InterestT interest;
     CallbackT callback;
-    bool cancel_requested {};
 
     BasicRule( size_t s_category_id, InterestT s_interest, CallbackT s_callback );
   };
@@ -45,6 +71,8 @@ private:
     Direction direction; //!< Direction::In for reading from fd, Direction::Out for writing to fd.
     CallbackT cancel;    //!< A callback that is called when the rule is cancelled (e.g. on EOF or hangup)
     CallbackT error;     //!< A callback that is called when the fd has an error before cancellation
+    bool watched {};     //!< (Backend::Epoll) whether the rule is part of its fd's EpollEntry
+    bool interested {};  //!< (Backend::Epoll) the interest() result currently registered for the rule
 
     FDRule( BasicRule&& base, FileDescriptor&& s_fd, Direction s_direction, CallbackT s_cancel, CallbackT s_error );
 
@@ -53,51 +81,112 @@ private:
     unsigned int service_count() const;
   };
 
+  struct TimerRule : public BasicRule
+  {
+    uint64_t period_ms; //!< 0 for a one-shot timer
+    uint64_t timer_id {};
+
+    TimerRule( BasicRule&& base, uint64_t s_period_ms );
+  };
+
+  //! The rules, in slots that stay put while callbacks add more. RuleHandles share them (through a weak_ptr) so
+  //! that cancelling a rule after its EventLoop is gone is harmless.
+  struct Rules
+  {
+    SlotMap<FDRule> fd {};
+    SlotMap<BasicRule> non_fd {};
+    SlotMap<TimerRule> timer {};
+    TimerWheel<SlotKey> timers; //!< pending timers, in milliseconds of steady_clock
+    std::optional<SlotKey> running_timer {};
+
+    explicit Rules( uint64_t now ) : timers( now ) {}
+  };
+
+  //! (Backend::Epoll) The rules on one fd number, which the kernel registration points to in epoll_event.data.
+  struct EpollEntry
+  {
+    std::vector<FDRule*> rules {};
+    uint32_t events {};   //!< the events currently registered with the kernel
+    bool always_ready {}; //!< epoll refuses regular files, which poll() reports as always ready
+  };
+
+  //! What became of a rule after looking at its poll()-style events.
+  enum class Outcome
+  {
+    Idle,     //!< nothing to do
+    Served,   //!< the callback ran
+    Cancelled //!< the fd hung up or failed, and the rule was cancelled
+  };
+
   std::vector<RuleCategory> _rule_categories {};
-  std::list<std::shared_ptr<FDRule>> _fd_rules {};
-  std::list<std::shared_ptr<BasicRule>> _non_fd_rules {};
+  std::shared_ptr<Rules> _rules;
+
+  Dispatch _dispatch;
+  Stats _stats {};
+
+  std::vector<pollfd> _pollfds {}; //!< (Backend::Poll) kept between calls to save reallocating it
+
+  std::optional<FileDescriptor> _epoll {};
+  std::unordered_map<int, EpollEntry> _epoll_entries {};
+  std::vector<epoll_event> _epoll_events {};
 
 public:
-  EventLoop() { _rule_categories.reserve( 64 ); }
+  explicit EventLoop( Backend backend = Backend::Poll, Dispatch dispatch = Dispatch::One );
+
+  const Stats& stats() const { return _stats; }
 
   //! Returned by each call to EventLoop::wait_next_event.
   enum class Result
   {
     Success, //!< At least one Rule was triggered.
     Timeout, //!< No rules were triggered before timeout.
-    Exit     //!< All rules have been canceled or were uninterested; make no further calls to
-             //!< EventLoop::wait_next_event.
+    Exit     //!< All rules have been canceled or were uninterested, and no timers are pending; make no
+             //!< further calls to EventLoop::wait_next_event.
   };
 
   size_t add_category( const std::string& name );
 
   class RuleHandle
   {
-    std::weak_ptr<BasicRule> rule_weak_ptr_;
-
   public:
-    template<class RuleType>
-    explicit RuleHandle( const std::shared_ptr<RuleType> x ) : rule_weak_ptr_( x )
+    enum class Kind : uint8_t
+    {
+      FD,
+      NonFD,
+      Timer
+    };
+
+    RuleHandle( const std::shared_ptr<Rules>& rules, Kind kind, SlotKey key )
+      : rules_( rules ), kind_( kind ), key_( key )
     {}
 
     void cancel();
+
+  private:
+    std::weak_ptr<Rules> rules_;
+    Kind kind_;
+    SlotKey key_;
   };
 
   RuleHandle add_rule(
     size_t category_id,
     FileDescriptor& fd,
     Direction direction,
-    const CallbackT& callback,
-    const InterestT& interest = [] { return true; },
-    const CallbackT& cancel = [] {},
-    const CallbackT& error = [] {} );
+    CallbackT callback,
+    InterestT interest = [] { return true; },
+    CallbackT cancel = [] {},
+    CallbackT error = [] {} );
 
   RuleHandle add_rule(
     size_t category_id,
-    const CallbackT& callback,
-    const InterestT& interest = [] { return true; } );
+    CallbackT callback,
+    InterestT interest = [] { return true; } );
+
+  //! Runs `callback` once, `delay_ms` from now, and then every `period_ms` if that is nonzero.
+  RuleHandle add_timer( size_t category_id, uint64_t delay_ms, CallbackT callback, uint64_t period_ms = 0 );
 
-  //! Calls [poll(2)](\ref man2::poll) and then executes callback for each ready fd.
+  //! Calls [poll(2)](\ref man2::poll) or [epoll_wait(2)](\ref man2::epoll_wait), and then executes the callback
+  //! of a ready fd (or of every ready fd, with Dispatch::All).
   Result wait_next_event( int timeout_ms );
 
   // convenience function to add category and rule at the same time
@@ -106,6 +195,22 @@ public:
   {
     return add_rule( add_category( name ), std::forward<Targs>( Fargs )... );
   }
+
+  // convenience function to add category and timer at the same time
+  template<typename... Targs>
+  auto add_timer( const std::string& name, Targs&&... Fargs )
+  {
+    return add_timer( add_category( name ), std::forward<Targs>( Fargs )... );
+  }
+
+private:
+  Outcome handle_events( FDRule& rule, int16_t events, int16_t revents );
+  bool run_timers();
+  int wait_timeout( int timeout_ms, bool served ) const;
+  Result wait_next_fd_event_epoll( int timeout_ms, bool served );
+  void epoll_watch( FDRule& rule );
+  void epoll_forget( FDRule& rule );
+  void epoll_update( EpollEntry& entry, int fd_num );
 };
 
 using Direction = EventLoop::Direction;
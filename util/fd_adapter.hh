@@ -6,9 +6,21 @@
 #include "tcp_config.hh"
 #include "tcp_segment.hh"
 
+#include <cstdint>
 #include <optional>
 #include <utility>
 
+//! The addresses and ports that tell one TCP connection from another, as seen from this end of it
+struct FourTuple
+{
+  uint32_t local_address {};
+  uint32_t remote_address {};
+  uint16_t local_port {};
+  uint16_t remote_port {};
+
+  bool operator==( const FourTuple& other ) const = default;
+};
+
 //! \brief Basic functionality for file descriptor adaptors
 //! \details See TCPOverIPv4OverTunFdAdapter for more information.
 class FdAdapterBase
@@ -17,8 +29,15 @@ private:
   FdAdapterConfig _cfg {}; //!< Configuration values
   bool _listen = false;    //!< Is the connected TCP FSM in listen state?
 
+  //! `_cfg`'s addresses and ports in numeric form, worked out on first use after each change to `_cfg`
+  mutable std::optional<FourTuple> _flow {};
+
 protected:
-  FdAdapterConfig& config_mutable() { return _cfg; }
+  FdAdapterConfig& config_mutable()
+  {
+    _flow.reset();
+    return _cfg;
+  }
 
 public:
   //! \brief Set the listening flag
@@ -34,9 +53,26 @@ public:
   const FdAdapterConfig& config() const { return _cfg; }
 
   //! \brief Get the current configuration (mutable)
-  //! \returns a mutable reference
-  FdAdapterConfig& config_mut() { return _cfg; }
+  //! \returns a mutable reference, to make a change with right away (configured_flow() may not see later ones)
+  FdAdapterConfig& config_mut()
+  {
+    _flow.reset();
+    return _cfg;
+  }
+
+  //! The configured connection's addresses and ports, as numbers, so that each segment need not convert them
+  const FourTuple& configured_flow() const
+  {
+    if ( not _flow.has_value() ) {
+      _flow = FourTuple {
+        _cfg.source.ipv4_numeric(), _cfg.destination.ipv4_numeric(), _cfg.source.port(), _cfg.destination.port() };
+    }
+    return _flow.value();
+  }
 
   //! Called periodically when time elapses
   void tick( const size_t unused [[maybe_unused]] ) {}
+
+  //! How long until tick() next has something to do (none: it never does)
+  std::optional<uint64_t> ms_until_deadline() const { return {}; }
 };
@@ -3,6 +3,7 @@
 #include "exception.hh"
 
 #include <algorithm>
+#include <array>
 #include <fcntl.h>
 #include <iostream>
 #include <stdexcept>
@@ -116,19 +117,32 @@ void FileDescriptor::read( vector<string>& buffers )
 
   buffers.back().clear();
   buffers.back().resize( kReadBufferSize );
+  read( span<string> { buffers } );
+}
+
+// a single readv() into `buffers` at their current sizes; each is then trimmed to what landed in it
+void FileDescriptor::read( span<string> buffers )
+{
+  // a few buffers fit on the stack; only long lists need the heap
+  array<iovec, 16> small {};
+  vector<iovec> large;
+  if ( buffers.size() > small.size() ) {
+    large.resize( buffers.size() );
+  }
+  const span<iovec> iovecs = large.empty() ? span<iovec> { small.data(), buffers.size() } : span<iovec> { large };
 
-  vector<iovec> iovecs;
-  iovecs.reserve( buffers.size() );
   size_t total_size = 0;
-  for ( const auto& x : buffers ) {
-    iovecs.push_back( { const_cast<char*>( x.data() ), x.size() } ); // NOLINT(*-const-cast)
-    total_size += x.size();
+  for ( size_t i = 0; i < buffers.size(); ++i ) {
+    iovecs[i] = { buffers[i].data(), buffers[i].size() };
+    total_size += buffers[i].size();
   }
 
   const ssize_t bytes_read = ::readv( fd_num(), iovecs.data(), static_cast<int>( iovecs.size() ) );
   if ( bytes_read < 0 ) {
     if ( internal_fd_->non_blocking_ and ( errno == EAGAIN or errno == EINPROGRESS ) ) {
-      buffers.clear();
+      for ( auto& buf : buffers ) {
+        buf.clear();
+      }
       return;
     }
     throw unix_error { "read" };
@@ -153,7 +167,7 @@ void FileDescriptor::read( vector<string>& buffers )
 
 size_t FileDescriptor::write( string_view buffer )
 {
-  return write( vector<string_view> { buffer } );
+  return write( span<const string_view> { &buffer, 1 } );
 }
 
 size_t FileDescriptor::write( const vector<std::string>& buffers )
@@ -168,12 +182,23 @@ size_t FileDescriptor::write( const vector<std::string>& buffers )
 
 size_t FileDescriptor::write( const vector<string_view>& buffers )
 {
-  vector<iovec> iovecs;
-  iovecs.reserve( buffers.size() );
+  return write( span<const string_view> { buffers } );
+}
+
+size_t FileDescriptor::write( span<const string_view> buffers )
+{
+  // a frame's few pieces fit on the stack; only long lists need the heap
+  array<iovec, 16> small {};
+  vector<iovec> large;
+  if ( buffers.size() > small.size() ) {
+    large.resize( buffers.size() );
+  }
+  const span<iovec> iovecs = large.empty() ? span<iovec> { small.data(), buffers.size() } : span<iovec> { large };
+
   size_t total_size = 0;
-  for ( const auto x : buffers ) {
-    iovecs.push_back( { const_cast<char*>( x.data() ), x.size() } ); // NOLINT(*-const-cast)
-    total_size += x.size();
+  for ( size_t i = 0; i < buffers.size(); ++i ) {
+    iovecs[i] = { const_cast<char*>( buffers[i].data() ), buffers[i].size() }; // NOLINT(*-const-cast)
+    total_size += buffers[i].size();
   }
 
   const ssize_t bytes_written
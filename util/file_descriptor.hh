@@ -3,6 +3,9 @@
 #include <cstddef>
 #include <limits>
 #include <memory>
+#include <span>
+#include <string>
+#include <string_view>
 #include <vector>
 
 // A reference-counted handle to a file descriptor
@@ -65,10 +68,14 @@ public:
   void read( std::string& buffer );
   void read( std::vector<std::string>& buffers );
 
+  // Read into `buffers` as they are sized (in one system call), trimming each to the bytes it received
+  void read( std::span<std::string> buffers );
+
   // Attempt to write a buffer
   // returns number of bytes written
   size_t write( std::string_view buffer );
   size_t write( const std::vector<std::string_view>& buffers );
+  size_t write( std::span<const std::string_view> buffers );
   size_t write( const std::vector<std::string>& buffers );
 
   // Close the underlying file descriptor
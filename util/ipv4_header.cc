@@ -4,6 +4,7 @@
 #include <arpa/inet.h>
 #include <array>
 #include <cstddef>
+#include <optional>
 #include <sstream>
 
 using namespace std;
@@ -12,25 +13,47 @@ using namespace std;
 void IPv4Header::parse( Parser& parser )
 {
   uint8_t first_byte {};
-  parser.integer( first_byte );
-  ver = first_byte >> 4;    // version
-  hlen = first_byte & 0x0f; // header length
-  parser.integer( tos );    // type of service
-  parser.integer( len );
-  parser.integer( id );
-
   uint16_t fo_val {};
-  parser.integer( fo_val );
+  optional<uint16_t> received_cksum; // checksum of the header bytes as received, when parsed in place
+
+  const string_view fixed = parser.contiguous( LENGTH );
+  if ( not fixed.empty() ) {
+    // fast path: the whole fixed header is in one buffer
+    InternetChecksum check;
+    check.add( fixed.substr( 0, 10 ) ); // everything but the checksum field itself
+    check.add( fixed.substr( 12 ) );
+    received_cksum = check.value();
+
+    first_byte = fixed[0];
+    tos = fixed[1];
+    len = load_big_endian<uint16_t>( &fixed[2] );
+    id = load_big_endian<uint16_t>( &fixed[4] );
+    fo_val = load_big_endian<uint16_t>( &fixed[6] );
+    ttl = fixed[8];
+    proto = fixed[9];
+    cksum = load_big_endian<uint16_t>( &fixed[10] );
+    src = load_big_endian<uint32_t>( &fixed[12] );
+    dst = load_big_endian<uint32_t>( &fixed[16] );
+    parser.remove_prefix( LENGTH );
+  } else {
+    parser.integer( first_byte );
+    parser.integer( tos ); // type of service
+    parser.integer( len );
+    parser.integer( id );
+    parser.integer( fo_val );
+    parser.integer( ttl );
+    parser.integer( proto );
+    parser.integer( cksum );
+    parser.integer( src );
+    parser.integer( dst );
+  }
+
+  ver = first_byte >> 4;                     // version
+  hlen = first_byte & 0x0f;                  // header length
   df = static_cast<bool>( fo_val & 0x4000 ); // don't fragment
   mf = static_cast<bool>( fo_val & 0x2000 ); // more fragments
   offset = fo_val & 0x1fff;                  // offset
 
-  parser.integer( ttl );
-  parser.integer( proto );
-  parser.integer( cksum );
-  parser.integer( src );
-  parser.integer( dst );
-
   if ( ver != 4 ) {
     parser.set_error();
   }
@@ -47,7 +70,11 @@ void IPv4Header::parse( Parser& parser )
 
   // Verify checksum
   const uint16_t given_cksum = cksum;
-  compute_checksum();
+  if ( received_cksum.has_value() ) {
+    cksum = received_cksum.value();
+  } else {
+    compute_checksum();
+  }
   if ( cksum != given_cksum ) {
     parser.set_error();
   }
@@ -116,6 +143,25 @@ void IPv4Header::compute_checksum()
   cksum = check.value();
 }
 
+void IPv4Header::set_ttl( uint8_t new_ttl )
+{
+  // TTL shares its header word with the protocol
+  cksum = InternetChecksum::adjust16( cksum, ttl << 8 | proto, new_ttl << 8 | proto );
+  ttl = new_ttl;
+}
+
+void IPv4Header::set_src( uint32_t new_src )
+{
+  cksum = InternetChecksum::adjust32( cksum, src, new_src );
+  src = new_src;
+}
+
+void IPv4Header::set_dst( uint32_t new_dst )
+{
+  cksum = InternetChecksum::adjust32( cksum, dst, new_dst );
+  dst = new_dst;
+}
+
 std::string IPv4Header::to_string() const
 {
   stringstream ss {};
@@ -49,6 +49,19 @@ public:
     return ret;
   }
 
+  //! \brief Read a batch from the underlying AdapterT instance (see TCPOverIPv4OverTunFdAdapter::read_batch),
+  //!        potentially dropping each segment read
+  template<class ReceiveFunction>
+  auto read_batch( size_t max_datagrams, ReceiveFunction&& receive )
+    -> decltype( _adapter.read_batch( max_datagrams, receive ) )
+  {
+    return _adapter.read_batch( max_datagrams, [&]( TCPMessage&& msg ) {
+      if ( not _should_drop( false ) ) {
+        receive( std::move( msg ) );
+      }
+    } );
+  }
+
   //! \brief Write to the underlying AdapterT instance, potentially dropping the datagram to be written
   //! \param[in] seg is the packet to either write or drop
   void write( const TCPMessage& seg )
@@ -66,4 +79,5 @@ public:
   const FdAdapterConfig& config() const { return _adapter.config(); } //!< FdAdapterBase::config passthrough
   FdAdapterConfig& config_mut() { return _adapter.config_mut(); }     //!< FdAdapterBase::config_mut passthrough
   void tick( const size_t ms_since_last_tick ) { _adapter.tick( ms_since_last_tick ); }
+  std::optional<uint64_t> ms_until_deadline() const { return _adapter.ms_until_deadline(); }
 };
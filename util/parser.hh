@@ -1,56 +1,116 @@
 #pragma once
 
+#include "checksum.hh"
+
 #include <algorithm>
+#include <array>
 #include <concepts>
 #include <cstdint>
 #include <cstring>
-#include <deque>
 #include <numeric>
 #include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
+#include <endian.h>
+
+// Read a big-endian integer from the first sizeof( T ) bytes at `bytes`
+template<std::unsigned_integral T>
+T load_big_endian( const char* bytes )
+{
+  T val {};
+  memcpy( &val, bytes, sizeof( T ) );
+  if constexpr ( sizeof( T ) == 2 ) {
+    return be16toh( val );
+  } else if constexpr ( sizeof( T ) == 4 ) {
+    return be32toh( val );
+  } else if constexpr ( sizeof( T ) == 8 ) {
+    return be64toh( val );
+  } else {
+    return val;
+  }
+}
+
 class Parser
 {
   class BufferList
   {
+    std::vector<std::string> owned_ {}; // the parser's own copy of its input, when it was given one to copy
+    std::span<std::string> buffers_ {};  // the input; those before front_ are used up
+    size_t front_ {};
+    uint64_t skip_ {}; // bytes of the front buffer already used
     uint64_t size_ {};
-    std::deque<std::string> buffer_ {};
-    uint64_t skip_ {};
 
-  public:
-    explicit BufferList( const std::vector<std::string>& buffers )
+    // move past used-up (and empty) buffers, so that a non-empty list always has bytes in its front buffer
+    void settle()
     {
-      for ( const auto& x : buffers ) {
-        append( x );
+      while ( front_ < buffers_.size() and skip_ == buffers_[front_].size() ) {
+        ++front_;
+        skip_ = 0;
       }
     }
 
+    void count()
+    {
+      for ( const auto& x : buffers_ ) {
+        size_ += x.size();
+      }
+      settle();
+    }
+
+    void clear()
+    {
+      front_ = buffers_.size();
+      skip_ = 0;
+      size_ = 0;
+    }
+
+  public:
+    explicit BufferList( const std::vector<std::string>& buffers ) : owned_( buffers ), buffers_( owned_ )
+    {
+      count();
+    }
+
+    explicit BufferList( std::span<std::string> buffers ) : buffers_( buffers ) { count(); }
+
+    // buffers_ may point into owned_
+    BufferList( const BufferList& other ) = delete;
+    BufferList& operator=( const BufferList& other ) = delete;
+
     uint64_t size() const { return size_; }
     uint64_t serialized_length() const { return size(); }
     bool empty() const { return size_ == 0; }
 
     std::string_view peek() const
     {
-      if ( buffer_.empty() ) {
+      if ( front_ == buffers_.size() ) {
         throw std::runtime_error( "peek on empty BufferList" );
       }
-      return std::string_view { buffer_.front() }.substr( skip_ );
+      return std::string_view { buffers_[front_] }.substr( skip_ );
     }
 
     void remove_prefix( uint64_t len )
     {
-      while ( len and not buffer_.empty() ) {
+      while ( len and front_ < buffers_.size() ) {
         const uint64_t to_pop_now = std::min( len, peek().size() );
         skip_ += to_pop_now;
         len -= to_pop_now;
         size_ -= to_pop_now;
-        if ( skip_ == buffer_.front().size() ) {
-          buffer_.pop_front();
-          skip_ = 0;
-        }
+        settle();
+      }
+    }
+
+    // Call `f` on each run of remaining bytes, in order
+    template<class F>
+    void for_each( F&& f ) const
+    {
+      auto tmp_skip = skip_;
+      for ( size_t i = front_; i < buffers_.size(); ++i ) {
+        f( std::string_view { buffers_[i] }.substr( tmp_skip ) );
+        tmp_skip = 0;
       }
     }
 
@@ -60,51 +120,32 @@ class Parser
       if ( empty() ) {
         return;
       }
-      std::string first_str = std::move( buffer_.front() );
-      if ( skip_ ) {
-        first_str = first_str.substr( skip_ );
-      }
+      std::string first_str = std::move( buffers_[front_] );
+      first_str.erase( 0, skip_ );
       out.emplace_back( std::move( first_str ) );
-      buffer_.pop_front();
-      for ( auto&& x : buffer_ ) {
-        out.emplace_back( std::move( x ) );
+      for ( size_t i = front_ + 1; i < buffers_.size(); ++i ) {
+        out.emplace_back( std::move( buffers_[i] ) );
       }
+      clear();
     }
 
     void dump_all( std::string& out )
     {
-      std::vector<std::string> concat;
-      dump_all( concat );
-      if ( concat.size() == 1 ) {
-        out = std::move( concat.front() );
+      if ( empty() ) {
+        out.clear();
         return;
       }
 
-      out.clear();
-      for ( const auto& s : concat ) {
-        out.append( s );
-      }
-    }
-
-    std::vector<std::string_view> buffer() const
-    {
-      if ( empty() ) {
-        return {};
-      }
-      std::vector<std::string_view> ret;
-      ret.reserve( buffer_.size() );
-      auto tmp_skip = skip_;
-      for ( const auto& x : buffer_ ) {
-        ret.push_back( std::string_view { x }.substr( tmp_skip ) );
-        tmp_skip = 0;
+      if ( buffers_[front_].size() - skip_ == size_ ) {
+        // it is all in one buffer: take that over, dropping the used part in place
+        out = std::move( buffers_[front_] );
+        out.erase( 0, skip_ );
+      } else {
+        out.clear();
+        out.reserve( size_ );
+        for_each( [&out]( std::string_view s ) { out.append( s ); } );
       }
-      return ret;
-    }
-
-    void append( std::string str )
-    {
-      size_ += str.size();
-      buffer_.push_back( std::move( str ) );
+      clear();
     }
   };
 
@@ -121,12 +162,26 @@ class Parser
 public:
   explicit Parser( const std::vector<std::string>& input ) : input_( input ) {}
 
+  // Parse `input` in place, without copying it. Whatever all_remaining() returns is moved out of `input`, so
+  // `input` must outlive the parser, and is left with unspecified contents.
+  explicit Parser( std::span<std::string> input ) : input_( input ) {}
+
   const BufferList& input() const { return input_; }
 
   bool has_error() const { return error_; }
   void set_error() { error_ = true; }
   void remove_prefix( size_t n ) { input_.remove_prefix( n ); }
 
+  // The next `len` bytes, if they all sit in the first buffer (nothing is consumed); otherwise an empty view.
+  // Fixed-layout headers use this to parse with one bounds check, falling back to integer() for fragmented input.
+  std::string_view contiguous( size_t len ) const
+  {
+    if ( has_error() or input_.empty() or input_.peek().size() < len ) {
+      return {};
+    }
+    return input_.peek().substr( 0, len );
+  }
+
   template<std::unsigned_integral T>
   void integer( T& out )
   {
@@ -135,6 +190,12 @@ public:
       return;
     }
 
+    if ( const auto view = input_.peek(); view.size() >= sizeof( T ) ) {
+      out = load_big_endian<T>( view.data() );
+      input_.remove_prefix( sizeof( T ) );
+      return;
+    }
+
     if constexpr ( sizeof( T ) == 1 ) {
       out = static_cast<uint8_t>( input_.peek().front() );
       input_.remove_prefix( 1 );
@@ -166,7 +227,13 @@ public:
 
   void all_remaining( std::vector<std::string>& out ) { input_.dump_all( out ); }
   void all_remaining( std::string& out ) { input_.dump_all( out ); }
-  std::vector<std::string_view> buffer() const { return input_.buffer(); }
+
+  // Call `f` on each run of the bytes not yet parsed, in order (without consuming them)
+  template<class F>
+  void for_each_remaining( F&& f ) const
+  {
+    input_.for_each( std::forward<F>( f ) );
+  }
 };
 
 class Serializer
@@ -174,15 +241,70 @@ class Serializer
   std::vector<std::string> output_ {};
   std::string buffer_ {};
 
+  // Frame mode: bytes are written straight into a caller's buffer, and payloads are referenced where they are
+  struct Piece
+  {
+    size_t frame_pos; // for frame bytes, where they start; for a payload, how much of the frame came before it
+    bool in_frame;
+  };
+  static constexpr size_t MAX_PIECES = 8;
+
+  bool frame_mode_ {};
+  std::span<char> frame_ {};
+  size_t frame_used_ {};    // bytes of frame_ written so far
+  size_t frame_flushed_ {}; // bytes of frame_ already listed in views_
+  std::array<std::string_view, MAX_PIECES> views_ {};
+  std::array<Piece, MAX_PIECES> pieces_ {};
+  size_t num_pieces_ {};
+
+  void add_piece( std::string_view view, Piece piece )
+  {
+    if ( num_pieces_ == MAX_PIECES ) {
+      throw std::runtime_error( "Serializer: too many pieces in frame" );
+    }
+    views_.at( num_pieces_ ) = view;
+    pieces_.at( num_pieces_ ) = piece;
+    ++num_pieces_;
+  }
+
+  void flush_frame()
+  {
+    if ( frame_used_ > frame_flushed_ ) {
+      add_piece( { frame_.data() + frame_flushed_, frame_used_ - frame_flushed_ }, { frame_flushed_, true } );
+      frame_flushed_ = frame_used_;
+    }
+  }
+
+  void write_frame( const void* data, size_t len )
+  {
+    if ( len > frame_.size() - frame_used_ ) {
+      throw std::runtime_error( "Serializer: frame buffer too small" );
+    }
+    memcpy( frame_.data() + frame_used_, data, len );
+    frame_used_ += len;
+  }
+
 public:
   Serializer() = default;
   explicit Serializer( std::string&& buffer ) : buffer_( std::move( buffer ) ) {}
 
+  // Frame mode: serialize into `frame` without allocating, for output with views()
+  explicit Serializer( std::span<char> frame ) : frame_mode_( true ), frame_( frame ) {}
+
   template<std::unsigned_integral T>
   void integer( const T val )
   {
     constexpr uint64_t len = sizeof( T );
 
+    if ( frame_mode_ ) {
+      std::array<uint8_t, len> bytes {};
+      for ( uint64_t i = 0; i < len; ++i ) {
+        bytes.at( i ) = val >> ( ( len - i - 1 ) * 8 );
+      }
+      write_frame( bytes.data(), len );
+      return;
+    }
+
     for ( uint64_t i = 0; i < len; ++i ) {
       const uint8_t byte_val = val >> ( ( len - i - 1 ) * 8 );
       buffer_.push_back( byte_val );
@@ -191,6 +313,11 @@ public:
 
   void buffer( std::string buf )
   {
+    if ( frame_mode_ ) {
+      write_frame( buf.data(), buf.size() );
+      return;
+    }
+
     flush();
     if ( not buf.empty() ) {
       output_.push_back( std::move( buf ) );
@@ -204,6 +331,20 @@ public:
     }
   }
 
+  // A payload: referenced in place in frame mode (so it must outlive the output), otherwise copied like buffer()
+  void payload( std::string_view data )
+  {
+    if ( not frame_mode_ ) {
+      buffer( std::string { data } );
+      return;
+    }
+
+    flush_frame();
+    if ( not data.empty() ) {
+      add_piece( data, { frame_used_, false } );
+    }
+  }
+
   void flush()
   {
     if ( not buffer_.empty() ) {
@@ -217,6 +358,47 @@ public:
     flush();
     return output_;
   }
+
+  // Frame mode: how many bytes of the frame buffer have been written
+  size_t frame_position() const { return frame_used_; }
+
+  // Frame mode: overwrite a 16-bit field already written at `pos`, e.g. a checksum once the data it covers is known
+  void patch( size_t pos, uint16_t val )
+  {
+    if ( pos + 2 > frame_used_ ) {
+      throw std::runtime_error( "Serializer: patch beyond the bytes written" );
+    }
+    frame_[pos] = static_cast<char>( val >> 8 );
+    frame_[pos + 1] = static_cast<char>( val );
+  }
+
+  // Frame mode: the Internet checksum of everything serialized since frame position `from`, payloads included
+  uint16_t checksum( size_t from, uint32_t initial_sum = 0 ) const
+  {
+    InternetChecksum check { initial_sum };
+    for ( size_t i = 0; i < num_pieces_; ++i ) {
+      const auto& piece = pieces_.at( i );
+      if ( piece.in_frame ) {
+        const size_t start = std::max( from, piece.frame_pos );
+        if ( start < piece.frame_pos + views_.at( i ).size() ) {
+          check.add( views_.at( i ).substr( start - piece.frame_pos ) );
+        }
+      } else if ( piece.frame_pos >= from ) {
+        check.add( views_.at( i ) );
+      }
+    }
+    if ( const size_t start = std::max( from, frame_flushed_ ); start < frame_used_ ) {
+      check.add( { frame_.data() + start, frame_used_ - start } );
+    }
+    return check.value();
+  }
+
+  // Frame mode: the serialized bytes, in order, as views of the frame buffer and of the payloads (for writev)
+  std::span<const std::string_view> views()
+  {
+    flush_frame();
+    return { views_.data(), num_pieces_ };
+  }
 };
 
 // Helper to serialize any object (without constructing a Serializer of the caller's own)
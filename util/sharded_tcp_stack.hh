@@ -0,0 +1,101 @@
+#pragma once
+
+#include "address.hh"
+#include "file_descriptor.hh"
+#include "spsc_ring.hh"
+#include "tcp_config.hh"
+#include "tcp_over_ip.hh"
+#include "tcp_stack.hh"
+#include "toeplitz.hh"
+#include "tun.hh"
+#include "tuntap_adapter.hh"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+//! Several TCPStacks sharing one TUN device, each on its own worker thread, in the manner of receive-side scaling.
+//! \details A reader thread reads each datagram from the device and steers its segment to one shard. It picks the
+//! shard with the Toeplitz hash of the segment's four-tuple, through a 128-entry indirection table, as a network
+//! card would, and hands the segment over on that shard's single-producer, single-consumer ring. Each connection
+//! therefore lives on one worker, which writes its segments straight to the device, so the workers share nothing.
+//! The application runs on the workers as well, through a function each one calls after every event.
+class ShardedTCPStack
+{
+public:
+  //! Called on a worker thread, with that worker's shard, each time the shard has handled its pending events
+  using ServeFunction = std::function<void( TCPStack& shard )>;
+
+  //! \param[in] tun is the device, which the reader and every worker get their own file descriptor for
+  //! \param[in] local_address is this end's IPv4 address
+  //! \param[in] num_shards is the number of worker threads (and TCPStacks)
+  //! \param[in] config is the configuration of every connection's TCPPeer
+  ShardedTCPStack( TunFD&& tun, const Address& local_address, size_t num_shards, const TCPConfig& config = {} );
+
+  //! Accept connections to `port` on every shard (call before start())
+  void listen( uint16_t port );
+
+  //! Start the reader and the workers. Until stop(), the shards belong to the worker threads.
+  void start( ServeFunction serve );
+
+  //! Stop all the threads and wait for them to finish
+  void stop();
+
+  ~ShardedTCPStack() { stop(); }
+
+  ShardedTCPStack( const ShardedTCPStack& other ) = delete;
+  ShardedTCPStack& operator=( const ShardedTCPStack& other ) = delete;
+
+  size_t num_shards() const { return _shards.size(); }
+
+  //! The shard that serves the connection `flow`
+  size_t shard_of( const FourTuple& flow ) const { return _indirection[_hash( flow ) % _indirection.size()]; }
+
+  //! The number of segments dropped because their shard's ring was full
+  uint64_t dropped() const { return _dropped.load( std::memory_order_relaxed ); }
+
+private:
+  static constexpr size_t RING_CAPACITY = 4096;
+
+  //! A segment on its way from the reader to a shard
+  struct Inbound
+  {
+    FourTuple flow {};
+    TCPMessage msg {};
+  };
+
+  struct Shard
+  {
+    TCPStack stack;
+    SPSCRing<Inbound> ring { RING_CAPACITY };
+    FileDescriptor wakeup;                //!< an eventfd the reader signals when the worker may be asleep
+    std::string wakeup_buffer { "01234567" }; //!< room to read the eventfd's counter into
+    std::atomic<bool> sleeping {};        //!< the worker found its ring empty and may be about to sleep
+    std::thread thread {};
+
+    Shard( TCPOverIPv4OverTunFdAdapter&& adapter,
+           const Address& local_address,
+           const TCPConfig& config,
+           TCPStack::FlowOwner owner );
+  };
+
+  TCPOverIPv4OverTunFdAdapter _reader;
+  ToeplitzHash _hash {};
+  std::array<size_t, 128> _indirection {}; //!< low bits of the hash -> shard
+  std::vector<std::unique_ptr<Shard>> _shards {};
+
+  std::atomic<bool> _stopping {};
+  std::atomic<uint64_t> _dropped {};
+  FileDescriptor _reader_wakeup; //!< an eventfd that stop() signals
+  std::string _reader_wakeup_buffer { "01234567" };
+  std::thread _reader_thread {};
+
+  void read_loop();
+  void serve_loop( Shard& shard, const ServeFunction& serve );
+};
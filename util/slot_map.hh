@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+//! Names a value in a SlotMap. Once the value is erased, the key goes stale instead of naming its successor.
+struct SlotKey
+{
+  uint32_t index {};
+  uint32_t generation {};
+
+  bool operator==( const SlotKey& other ) const = default;
+};
+
+//! Keeps values in slots that never move, and remembers the order they were added in.
+//! \details Slots are allocated 64 at a time and reused after an erase, so once a SlotMap has grown to its
+//! working size, adding and erasing values does not allocate. A value's address stays valid until it is erased,
+//! even while other values are added.
+template<class T, size_t ChunkSize = 64>
+class SlotMap
+{
+public:
+  //! Construct a value in a free slot, after all the others in order
+  template<class... Targs>
+  SlotKey emplace( Targs&&... args );
+
+  //! The value named by `key`, or nullptr if it has been erased
+  T* find( SlotKey key );
+
+  //! Erase the value named by `key`, if it is still there
+  void erase( SlotKey key );
+
+  size_t size() const { return order_.size(); }
+  bool empty() const { return order_.empty(); }
+
+  //! The value at `position` in order
+  T& operator[]( size_t position ) { return *order_[physical( position )]->value; }
+
+  //! Erase the value at `position`, keeping the rest in order
+  void erase_at( size_t position );
+
+  //! Move the first value to the end of the order
+  void rotate();
+
+private:
+  struct Slot
+  {
+    std::optional<T> value {};
+    uint32_t index {};
+    uint32_t generation {};
+  };
+
+  std::vector<std::unique_ptr<std::array<Slot, ChunkSize>>> chunks_ {};
+  std::vector<uint32_t> free_ {};
+  std::vector<Slot*> order_ {}; //!< the slots holding values, in order starting from order_[first_]
+  size_t first_ {};
+
+  Slot& slot( uint32_t index ) { return ( *chunks_[index / ChunkSize] )[index % ChunkSize]; }
+  size_t physical( size_t position ) const
+  {
+    const size_t i = first_ + position;
+    return i < order_.size() ? i : i - order_.size();
+  }
+  void release( Slot& s );
+};
+
+template<class T, size_t ChunkSize>
+template<class... Targs>
+SlotKey SlotMap<T, ChunkSize>::emplace( Targs&&... args )
+{
+  if ( free_.empty() ) {
+    const auto first = static_cast<uint32_t>( chunks_.size() * ChunkSize );
+    chunks_.push_back( std::make_unique<std::array<Slot, ChunkSize>>() );
+    free_.reserve( chunks_.size() * ChunkSize );
+    order_.reserve( chunks_.size() * ChunkSize );
+    for ( auto index = static_cast<uint32_t>( first + ChunkSize ); index > first; --index ) {
+      slot( index - 1 ).index = index - 1;
+      free_.push_back( index - 1 );
+    }
+  }
+
+  Slot& s = slot( free_.back() );
+  s.value.emplace( std::forward<Targs>( args )... );
+  free_.pop_back();
+  if ( first_ == 0 ) {
+    order_.push_back( &s );
+  } else {
+    order_.insert( order_.begin() + static_cast<std::ptrdiff_t>( first_++ ), &s );
+  }
+  return { s.index, s.generation };
+}
+
+template<class T, size_t ChunkSize>
+T* SlotMap<T, ChunkSize>::find( SlotKey key )
+{
+  if ( key.index >= chunks_.size() * ChunkSize ) {
+    return nullptr;
+  }
+  Slot& s = slot( key.index );
+  return s.generation == key.generation and s.value.has_value() ? &s.value.value() : nullptr;
+}
+
+template<class T, size_t ChunkSize>
+void SlotMap<T, ChunkSize>::erase( SlotKey key )
+{
+  if ( find( key ) != nullptr ) {
+    const auto it = std::find( order_.begin(), order_.end(), &slot( key.index ) );
+    erase_at( ( static_cast<size_t>( it - order_.begin() ) + order_.size() - first_ ) % order_.size() );
+  }
+}
+
+template<class T, size_t ChunkSize>
+void SlotMap<T, ChunkSize>::erase_at( size_t position )
+{
+  const size_t i = physical( position );
+  Slot& s = *order_[i];
+  order_.erase( order_.begin() + static_cast<std::ptrdiff_t>( i ) );
+  if ( i < first_ ) {
+    --first_;
+  }
+  if ( first_ == order_.size() ) {
+    first_ = 0;
+  }
+  release( s );
+}
+
+template<class T, size_t ChunkSize>
+void SlotMap<T, ChunkSize>::rotate()
+{
+  if ( ++first_ >= order_.size() ) {
+    first_ = 0;
+  }
+}
+
+template<class T, size_t ChunkSize>
+void SlotMap<T, ChunkSize>::release( Slot& s )
+{
+  s.value.reset();
+  ++s.generation;
+  free_.push_back( s.index );
+}
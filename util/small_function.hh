@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template<class Signature, size_t Capacity = 4 * sizeof( void* )>
+class SmallFunction;
+
+//! A move-only std::function that keeps callables of up to `Capacity` bytes inside itself.
+//! \details Lambdas that capture a few references or pointers (as EventLoop rules do) fit, so calling, moving
+//! and destroying one never touch the heap. Bigger callables are allocated once, when the SmallFunction is made.
+template<class R, class... Args, size_t Capacity>
+class SmallFunction<R( Args... ), Capacity>
+{
+public:
+  SmallFunction() = default;
+
+  template<class F>
+    requires( not std::is_same_v<std::decay_t<F>, SmallFunction>
+              and std::is_invocable_r_v<R, std::decay_t<F>&, Args...> )
+  SmallFunction( F&& f ) // NOLINT(*-explicit-*, *-forwarding-reference-overload)
+  {
+    using Callable = std::decay_t<F>;
+    if constexpr ( fits_inline<Callable> ) {
+      ::new ( storage_ ) Callable( std::forward<F>( f ) );
+      ops_ = &inline_ops<Callable>;
+    } else {
+      ::new ( storage_ ) Callable*( new Callable( std::forward<F>( f ) ) ); // NOLINT(*-owning-memory)
+      ops_ = &heap_ops<Callable>;
+    }
+    invoke_ = ops_->invoke;
+  }
+
+  SmallFunction( SmallFunction&& other ) noexcept : ops_( other.ops_ ), invoke_( other.invoke_ )
+  {
+    if ( ops_ ) {
+      ops_->relocate( other.storage_, storage_ );
+      other.ops_ = nullptr;
+      other.invoke_ = nullptr;
+    }
+  }
+
+  SmallFunction& operator=( SmallFunction&& other ) noexcept
+  {
+    if ( this != &other ) {
+      reset();
+      if ( other.ops_ ) {
+        other.ops_->relocate( other.storage_, storage_ );
+        ops_ = std::exchange( other.ops_, nullptr );
+        invoke_ = std::exchange( other.invoke_, nullptr );
+      }
+    }
+    return *this;
+  }
+
+  SmallFunction( const SmallFunction& other ) = delete;
+  SmallFunction& operator=( const SmallFunction& other ) = delete;
+
+  ~SmallFunction() { reset(); }
+
+  explicit operator bool() const { return ops_ != nullptr; }
+
+  R operator()( Args... args )
+  {
+    if ( not invoke_ ) {
+      throw std::bad_function_call {};
+    }
+    return invoke_( storage_, std::forward<Args>( args )... );
+  }
+
+private:
+  struct Ops
+  {
+    R ( *invoke )( void* storage, Args&&... args );
+    void ( *relocate )( void* from, void* to ) noexcept; //!< move into `to`, and destroy what is left in `from`
+    void ( *destroy )( void* storage ) noexcept;
+  };
+
+  template<class F>
+  static constexpr bool fits_inline = sizeof( F ) <= Capacity and alignof( F ) <= alignof( std::max_align_t )
+                                      and std::is_nothrow_move_constructible_v<F>;
+
+  template<class F>
+  static constexpr Ops inline_ops {
+    []( void* storage, Args&&... args ) -> R {
+      return std::invoke( *static_cast<F*>( storage ), std::forward<Args>( args )... );
+    },
+    []( void* from, void* to ) noexcept {
+      ::new ( to ) F( std::move( *static_cast<F*>( from ) ) );
+      static_cast<F*>( from )->~F();
+    },
+    []( void* storage ) noexcept { static_cast<F*>( storage )->~F(); } };
+
+  template<class F>
+  static constexpr Ops heap_ops {
+    []( void* storage, Args&&... args ) -> R {
+      return std::invoke( **static_cast<F**>( storage ), std::forward<Args>( args )... );
+    },
+    []( void* from, void* to ) noexcept { ::new ( to ) F*( *static_cast<F**>( from ) ); },
+    []( void* storage ) noexcept { delete *static_cast<F**>( storage ); } }; // NOLINT(*-owning-memory)
+
+  void reset()
+  {
+    if ( ops_ ) {
+      ops_->destroy( storage_ );
+      ops_ = nullptr;
+      invoke_ = nullptr;
+    }
+  }
+
+  alignas( std::max_align_t ) std::byte storage_[Capacity] {}; // NOLINT(*-c-arrays)
+  const Ops* ops_ {};
+  R ( *invoke_ )( void* storage, Args&&... args ) {}; //!< a copy of ops_->invoke, to save a load on each call
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+//! A fixed-size queue between exactly one producer thread and one consumer thread, without locks.
+//! \details The producer only writes `tail_` and the consumer only writes `head_`, each on its own cache line.
+//! Each side also keeps its last sight of the other's index, and only reloads it (pulling the other side's cache
+//! line over) when that copy says the ring is full or empty.
+template<class T>
+class SPSCRing
+{
+public:
+  //! Room for `capacity` values, rounded up to a power of two
+  explicit SPSCRing( size_t capacity )
+    : slots_( std::bit_ceil( std::max( capacity, size_t { 2 } ) ) ), mask_( slots_.size() - 1 )
+  {}
+
+  size_t capacity() const { return slots_.size(); }
+
+  //! (Producer) Add `value` at the back. Returns false, leaving `value` alone, if the ring is full.
+  bool push( T&& value )
+  {
+    const size_t tail = tail_.load( std::memory_order_relaxed );
+    if ( tail - head_seen_ == slots_.size() ) {
+      head_seen_ = head_.load( std::memory_order_acquire );
+      if ( tail - head_seen_ == slots_.size() ) {
+        return false;
+      }
+    }
+    slots_[tail & mask_] = std::move( value );
+    tail_.store( tail + 1, std::memory_order_release );
+    return true;
+  }
+
+  //! (Consumer) Move the front value into `value`. Returns false if the ring is empty.
+  bool pop( T& value )
+  {
+    const size_t head = head_.load( std::memory_order_relaxed );
+    if ( head == tail_seen_ ) {
+      tail_seen_ = tail_.load( std::memory_order_acquire );
+      if ( head == tail_seen_ ) {
+        return false;
+      }
+    }
+    value = std::move( slots_[head & mask_] );
+    head_.store( head + 1, std::memory_order_release );
+    return true;
+  }
+
+  //! (Consumer) Is the ring empty? Always looks at the producer's latest index.
+  bool empty() const { return head_.load( std::memory_order_relaxed ) == tail_.load( std::memory_order_acquire ); }
+
+private:
+  static constexpr size_t CACHE_LINE = 64;
+
+  std::vector<T> slots_;
+  size_t mask_;
+
+  alignas( CACHE_LINE ) std::atomic<size_t> head_ {}; //!< the next slot to pop (written by the consumer)
+  size_t tail_seen_ {};                               //!< the consumer's copy of `tail_`
+
+  alignas( CACHE_LINE ) std::atomic<size_t> tail_ {}; //!< the next slot to fill (written by the producer)
+  size_t head_seen_ {};                               //!< the producer's copy of `head_`
+};
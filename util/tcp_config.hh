@@ -1,6 +1,8 @@
 #pragma once
 
 #include "address.hh"
+#include "byte_stream.hh"
+#include "congestion_control.hh"
 #include "wrapping_integers.hh"
 
 #include <cstddef>
@@ -15,11 +17,50 @@ public:
   static constexpr size_t MAX_PAYLOAD_SIZE = 1000;  //!< Conservative max payload size for real Internet
   static constexpr uint16_t TIMEOUT_DFLT = 1000;    //!< Default re-transmit timeout is 1 second
   static constexpr unsigned MAX_RETX_ATTEMPTS = 8;  //!< Maximum re-transmit attempts before giving up
+  static constexpr uint8_t MAX_WINDOW_SCALE = 14;   //!< Largest window-scale shift (RFC 7323): windows up to 1 GiB
 
   uint16_t rt_timeout = TIMEOUT_DFLT;      //!< Initial value of the retransmission timeout, in milliseconds
   size_t recv_capacity = DEFAULT_CAPACITY; //!< Receive capacity, in bytes
   size_t send_capacity = DEFAULT_CAPACITY; //!< Sender capacity, in bytes
   Wrap32 isn { 137 };                      //!< Default initial sequence number
+  uint16_t ack_delay = 0;                  //!< Delay ACKs of in-order data by up to this many ms (0: ACK at once)
+
+  //! Adapt the retransmission timeout to the measured RTT (RFC 6298), between rto_min and rto_max; if not, every
+  //! new ACK resets it to rt_timeout
+  bool adaptive_rto = false;
+  uint64_t rto_min = 200;   //!< Lower bound on the adaptive RTO, in ms (RFC 6298 suggests 1 s; Linux uses 200 ms)
+  uint64_t rto_max = 60000; //!< Upper bound on the adaptive RTO (and its backoff), in ms
+
+  //! Retransmit the first outstanding segment after three duplicate ACKs, and recover from the loss as NewReno
+  //! does (RFC 6582); if not, only the retransmission timer retransmits
+  bool fast_retransmit = false;
+
+  //! Permit SACK on the SYN (RFC 2018): the receiver reports the ranges it holds beyond a gap, and the sender
+  //! (recovering with fast_retransmit) retransmits only the holes between them
+  bool sack = false;
+
+  //! Offer window scaling on the SYN (RFC 7323), so that the window advertised can cover a recv_capacity beyond
+  //! 64 KiB (up to 1 GiB); if not, it stops at 65,535 bytes
+  bool window_scaling = false;
+
+  //! The window-scale shift offered on the SYN: the smallest that lets the window cover recv_capacity (none
+  //! without window_scaling)
+  std::optional<uint8_t> window_scale() const
+  {
+    if ( not window_scaling ) {
+      return {};
+    }
+    uint8_t shift = 0;
+    while ( shift < MAX_WINDOW_SCALE and ( recv_capacity >> shift ) > UINT16_MAX ) {
+      ++shift;
+    }
+    return shift;
+  }
+
+  //! Congestion control for the sender (none: send whatever the receiver's window allows)
+  CongestionControl::Algorithm congestion_control = CongestionControl::Algorithm::None;
+
+  ByteStream::Mode stream_mode = ByteStream::Mode::Chunked; //!< How the outbound and inbound ByteStreams buffer data
 };
 
 //! Config for classes derived from FdAdapter
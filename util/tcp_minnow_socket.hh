@@ -58,6 +58,10 @@ public:
   // Return peer address from underlying datagram adapter
   const Address& peer_address() const { return _datagram_adapter.config().destination; }
 
+  //! What the TCP thread's event loop has done (read it once the thread has finished, e.g. after
+  //! wait_until_closed())
+  const EventLoop::Stats& eventloop_stats() const { return _eventloop.stats(); }
+
 protected:
   //! Adapter to underlying datagram socket (e.g., UDP or IP)
   AdaptT _datagram_adapter;
@@ -73,7 +77,10 @@ private:
   std::optional<TCPPeer> _tcp {};
 
   //! eventloop that handles all the events (new inbound datagram, new outbound bytes, new inbound bytes)
-  EventLoop _eventloop {};
+  EventLoop _eventloop { EventLoop::Backend::Poll, EventLoop::Dispatch::One };
+
+  //! eventloop category for the timer armed by _tcp_loop, created by _initialize_TCP
+  size_t _timer_category {};
 
   //! Process events while specified condition is true
   void _tcp_loop( const std::function<bool()>& condition );
@@ -15,7 +15,11 @@
 #include <unistd.h>
 #include <utility>
 
-static constexpr size_t TCP_TICK_MS = 10;
+//! The TCP thread sleeps until its next timer is due, but checks for an abort at least this often
+static constexpr int TCP_ABORT_CHECK_MS = 100;
+
+//! The most datagrams the TCP thread takes from the adapter before it replies and goes back to the event loop
+static constexpr size_t TCP_READ_BATCH = 64;
 
 inline uint64_t timestamp_ms()
 {
@@ -29,16 +33,46 @@ template<TCPDatagramAdapter AdaptT>
 void TCPMinnowSocket<AdaptT>::_tcp_loop( const std::function<bool()>& condition )
 {
   auto base_time = timestamp_ms();
-  while ( condition() ) {
-    auto ret = _eventloop.wait_next_event( TCP_TICK_MS );
-    if ( ret == EventLoop::Result::Exit or _abort ) {
-      break;
-    }
 
+  // Instead of waking on a fixed tick, keep one timer armed for whenever the TCPPeer (or the adapter beneath it)
+  // next has something to do, and tell them how much time has passed whenever the loop wakes for any reason.
+  std::optional<EventLoop::RuleHandle> timer;
+  std::optional<uint64_t> timer_deadline;
+
+  while ( condition() ) {
     if ( not _tcp.has_value() ) {
       throw std::runtime_error( "_tcp_loop entered before TCPPeer initialized" );
     }
 
+    std::optional<uint64_t> deadline;
+    if ( _tcp.value().active() ) {
+      std::optional<uint64_t> wait = _tcp.value().ms_until_deadline();
+      if ( const auto adapter_wait = _datagram_adapter.ms_until_deadline() ) {
+        wait = std::min( wait.value_or( adapter_wait.value() ), adapter_wait.value() );
+      }
+      if ( wait.has_value() ) {
+        deadline = base_time + wait.value();
+      }
+    }
+
+    if ( deadline != timer_deadline ) {
+      if ( timer.has_value() ) {
+        timer->cancel();
+        timer.reset();
+      }
+      if ( deadline.has_value() ) {
+        const auto now = timestamp_ms();
+        const auto delay = deadline.value() > now ? deadline.value() - now : 0;
+        timer = _eventloop.add_timer( _timer_category, delay, [&] { timer_deadline.reset(); } );
+      }
+      timer_deadline = deadline;
+    }
+
+    auto ret = _eventloop.wait_next_event( TCP_ABORT_CHECK_MS );
+    if ( ret == EventLoop::Result::Exit or _abort ) {
+      break;
+    }
+
     if ( _tcp.value().active() ) {
       const auto next_time = timestamp_ms();
       _tcp.value().tick( next_time - base_time, [&]( auto x ) { _datagram_adapter.write( x ); } );
@@ -46,6 +80,10 @@ void TCPMinnowSocket<AdaptT>::_tcp_loop( const std::function<bool()>& condition
       base_time = next_time;
     }
   }
+
+  if ( timer.has_value() ) {
+    timer->cancel();
+  }
 }
 
 //! \param[in] data_socket_pair is a pair of connected AF_UNIX SOCK_STREAM sockets
@@ -59,6 +97,9 @@ TCPMinnowSocket<AdaptT>::TCPMinnowSocket( std::pair<FileDescriptor, FileDescript
 {
   _thread_data.set_blocking( false );
   set_blocking( false );
+  if constexpr ( BatchTCPDatagramAdapter<AdaptT> ) {
+    _datagram_adapter.fd().set_blocking( false ); // read_batch() reads until nothing is left
+  }
 }
 
 template<TCPDatagramAdapter AdaptT>
@@ -67,6 +108,7 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
   _tcp.emplace( config );
 
   // Set up the event loop
+  _timer_category = _eventloop.add_category( "TCP timer" );
 
   // There are three events to handle:
   //
@@ -86,7 +128,13 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
     _datagram_adapter.fd(),
     Direction::In,
     [&] {
-      if ( auto seg = _datagram_adapter.read() ) {
+      if constexpr ( BatchTCPDatagramAdapter<AdaptT> ) {
+        // take every segment already waiting, and answer them together: a burst then costs one poll and one
+        // cumulative ACK, rather than one of each per segment
+        _datagram_adapter.read_batch( TCP_READ_BATCH,
+                                      [&]( TCPMessage&& seg ) { _tcp->receive( std::move( seg ) ); } );
+        _tcp->reply( [&]( auto x ) { _datagram_adapter.write( x ); } );
+      } else if ( auto seg = _datagram_adapter.read() ) {
         _tcp->receive( std::move( seg.value() ), [&]( auto x ) { _datagram_adapter.write( x ); } );
       }
 
@@ -143,14 +191,10 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
     Direction::Out,
     [&] {
       Reader& inbound = _tcp->inbound_reader();
-      // Write from the inbound_stream into
-      // the pipe, handling the possibility of a partial
-      // write (i.e., only pop what was actually written).
-      if ( inbound.bytes_buffered() ) {
-        const std::string_view buffer = inbound.peek();
-        const auto bytes_written = _thread_data.write( buffer );
-        inbound.pop( bytes_written );
-      }
+      // Write everything buffered in the inbound_stream into
+      // the pipe with one writev, handling the possibility of a
+      // partial write (i.e., only pop what was actually written).
+      drain( inbound, _thread_data );
 
       if ( inbound.is_finished() or inbound.has_error() ) {
         _thread_data.shutdown( SHUT_WR );
@@ -27,37 +27,54 @@ optional<TCPMessage> TCPOverIPv4Adapter::unwrap_tcp_in_ip( const InternetDatagra
 {
   // is the IPv4 datagram for us?
   // Note: it's valid to bind to address "0" (INADDR_ANY) and reply from actual address contacted
-  if ( not listening() and ( ip_dgram.header.dst != config().source.ipv4_numeric() ) ) {
+  if ( not listening() and ( ip_dgram.header.dst != configured_flow().local_address ) ) {
     return {};
   }
 
   // is the IPv4 datagram from our peer?
-  if ( not listening() and ( ip_dgram.header.src != config().destination.ipv4_numeric() ) ) {
+  if ( not listening() and ( ip_dgram.header.src != configured_flow().remote_address ) ) {
     return {};
   }
 
-  // does the IPv4 datagram claim that its payload is a TCP segment?
-  if ( ip_dgram.header.proto != IPv4Header::PROTO_TCP ) {
+  // is the payload a valid TCP segment?
+  FourTuple flow;
+  return for_this_connection( unwrap_tcp_in_ip( ip_dgram, flow ), flow );
+}
+
+//! \details As above, but the datagram is parsed straight out of `datagram`'s buffers, and the payload is moved
+//! out of them rather than copied.
+optional<TCPMessage> TCPOverIPv4Adapter::unwrap_tcp_in_ip( Parser& datagram )
+{
+  FourTuple flow;
+  auto msg = unwrap_tcp_in_ip( datagram, flow );
+
+  // is the IPv4 datagram for us, and from our peer?
+  if ( msg.has_value() and not listening()
+       and ( flow.local_address != configured_flow().local_address
+             or flow.remote_address != configured_flow().remote_address ) ) {
     return {};
   }
 
-  // is the payload a valid TCP segment?
-  TCPSegment tcp_seg;
-  if ( not parse( tcp_seg, ip_dgram.payload, ip_dgram.header.pseudo_checksum() ) ) {
+  return for_this_connection( move( msg ), flow );
+}
+
+// The port checks of unwrap_tcp_in_ip(), once a segment has been parsed and its addresses checked
+optional<TCPMessage> TCPOverIPv4Adapter::for_this_connection( optional<TCPMessage> msg, const FourTuple& flow )
+{
+  if ( not msg.has_value() ) {
     return {};
   }
 
   // is the TCP segment for us?
-  if ( tcp_seg.udinfo.dst_port != config().source.port() ) {
+  if ( flow.local_port != configured_flow().local_port ) {
     return {};
   }
 
   // should we target this source addr/port (and use its destination addr as our source) in reply?
   if ( listening() ) {
-    if ( tcp_seg.message.sender.SYN and not tcp_seg.message.sender.RST ) {
-      config_mutable().source = Address { inet_ntoa( { htobe32( ip_dgram.header.dst ) } ), config().source.port() };
-      config_mutable().destination
-        = Address { inet_ntoa( { htobe32( ip_dgram.header.src ) } ), tcp_seg.udinfo.src_port };
+    if ( msg->sender.SYN and not msg->sender.RST ) {
+      config_mutable().source = Address::from_ipv4_numeric( flow.local_address, flow.local_port );
+      config_mutable().destination = Address::from_ipv4_numeric( flow.remote_address, flow.remote_port );
       set_listening( false );
     } else {
       return {};
@@ -65,11 +82,47 @@ optional<TCPMessage> TCPOverIPv4Adapter::unwrap_tcp_in_ip( const InternetDatagra
   }
 
   // is the TCP segment from our peer?
-  if ( tcp_seg.udinfo.src_port != config().destination.port() ) {
+  if ( flow.remote_port != configured_flow().remote_port ) {
     return {};
   }
 
-  return tcp_seg.message;
+  return msg;
+}
+
+optional<TCPMessage> TCPOverIPv4Adapter::unwrap_tcp_in_ip( const InternetDatagram& ip_dgram, FourTuple& flow )
+{
+  // does the IPv4 datagram claim that its payload is a TCP segment?
+  if ( ip_dgram.header.proto != IPv4Header::PROTO_TCP ) {
+    return {};
+  }
+
+  // is the payload a valid TCP segment?
+  TCPSegment tcp_seg;
+  if ( not parse( tcp_seg, ip_dgram.payload, ip_dgram.header.pseudo_checksum() ) ) {
+    return {};
+  }
+
+  flow = { ip_dgram.header.dst, ip_dgram.header.src, tcp_seg.udinfo.dst_port, tcp_seg.udinfo.src_port };
+  return move( tcp_seg.message );
+}
+
+optional<TCPMessage> TCPOverIPv4Adapter::unwrap_tcp_in_ip( Parser& datagram, FourTuple& flow )
+{
+  IPv4Header header;
+  header.parse( datagram );
+  if ( datagram.has_error() or header.proto != IPv4Header::PROTO_TCP ) {
+    return {};
+  }
+
+  // the rest of the datagram is the TCP segment, parsed by the same Parser so that its payload is not copied
+  TCPSegment tcp_seg;
+  tcp_seg.parse( datagram, header.pseudo_checksum() );
+  if ( datagram.has_error() ) {
+    return {};
+  }
+
+  flow = { header.dst, header.src, tcp_seg.udinfo.dst_port, tcp_seg.udinfo.src_port };
+  return move( tcp_seg.message );
 }
 
 //! Takes a TCP segment, sets port numbers as necessary, and wraps it in an IPv4 datagram
@@ -78,14 +131,15 @@ InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip( const TCPMessage& msg )
 {
   TCPSegment seg { .message = msg };
   // set the port numbers in the TCP segment
-  seg.udinfo.src_port = config().source.port();
-  seg.udinfo.dst_port = config().destination.port();
+  seg.udinfo.src_port = configured_flow().local_port;
+  seg.udinfo.dst_port = configured_flow().remote_port;
 
   // create an Internet Datagram and set its addresses and length
   InternetDatagram ip_dgram;
-  ip_dgram.header.src = config().source.ipv4_numeric();
-  ip_dgram.header.dst = config().destination.ipv4_numeric();
-  ip_dgram.header.len = ip_dgram.header.hlen * 4 + 20 /* tcp header len */ + seg.message.sender.payload.size();
+  ip_dgram.header.src = configured_flow().local_address;
+  ip_dgram.header.dst = configured_flow().remote_address;
+  ip_dgram.header.len
+    = ip_dgram.header.hlen * 4 + TCPSegment::header_length( seg.message ) + seg.message.sender.payload.size();
 
   // set payload, calculating TCP checksum using information from IP header
   seg.compute_checksum( ip_dgram.header.pseudo_checksum() );
@@ -94,3 +148,24 @@ InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip( const TCPMessage& msg )
 
   return ip_dgram;
 }
+
+void TCPOverIPv4Adapter::wrap_tcp_in_ip( const TCPMessage& msg, Serializer& frame )
+{
+  wrap_tcp_in_ip( msg, configured_flow(), frame );
+}
+
+void TCPOverIPv4Adapter::wrap_tcp_in_ip( const TCPMessage& msg, const FourTuple& flow, Serializer& frame )
+{
+  IPv4Header header;
+  header.src = flow.local_address;
+  header.dst = flow.remote_address;
+  header.len = header.hlen * 4 + TCPSegment::header_length( msg ) + msg.sender.payload.size();
+
+  const size_t ip_start = frame.frame_position();
+  header.serialize( frame );
+  frame.patch( ip_start + 10, frame.checksum( ip_start ) ); // header checksum
+
+  const size_t tcp_start = frame.frame_position();
+  TCPSegment::serialize( frame, msg, { flow.local_port, flow.remote_port, 0 } );
+  frame.patch( tcp_start + 16, frame.checksum( tcp_start, header.pseudo_checksum() ) ); // TCP checksum
+}
@@ -12,5 +12,23 @@ class TCPOverIPv4Adapter : public FdAdapterBase
 public:
   std::optional<TCPMessage> unwrap_tcp_in_ip( const InternetDatagram& ip_dgram );
 
+  //! Parse any TCP segment out of `ip_dgram`, whichever connection it belongs to, and set `flow` to the
+  //! connection's four-tuple from the receiver's side
+  static std::optional<TCPMessage> unwrap_tcp_in_ip( const InternetDatagram& ip_dgram, FourTuple& flow );
+
+  //! The same two, parsing a whole serialized datagram in place (see Parser's std::span constructor)
+  std::optional<TCPMessage> unwrap_tcp_in_ip( Parser& datagram );
+  static std::optional<TCPMessage> unwrap_tcp_in_ip( Parser& datagram, FourTuple& flow );
+
   InternetDatagram wrap_tcp_in_ip( const TCPMessage& msg );
+
+  //! Serialize the IPv4 datagram carrying `msg` into `frame` (a Serializer in frame mode) in one pass, filling in
+  //! both checksums as it goes. The payload is referenced rather than copied.
+  void wrap_tcp_in_ip( const TCPMessage& msg, Serializer& frame );
+
+  //! As above, but for the connection `flow` rather than the configured one
+  static void wrap_tcp_in_ip( const TCPMessage& msg, const FourTuple& flow, Serializer& frame );
+
+private:
+  std::optional<TCPMessage> for_this_connection( std::optional<TCPMessage> msg, const FourTuple& flow );
 };
@@ -7,6 +7,8 @@
 #include "tcp_sender.hh"
 #include "tcp_sender_message.hh"
 
+#include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <optional>
 
@@ -32,9 +34,33 @@ public:
   {
     cumulative_time_ += t;
     sender_.tick( t, make_send( transmit ) );
+    if ( ack_deadline_.has_value() and cumulative_time_ >= ack_deadline_.value() ) {
+      send( sender_.make_empty_message(), transmit );
+    }
   }
   bool has_ackno() const { return receiver_.send().ackno.has_value(); }
 
+  /* How long until tick() next has something to do: retransmit, send a delayed ACK, or stop lingering (none if
+     nothing is pending) */
+  std::optional<uint64_t> ms_until_deadline() const
+  {
+    std::optional<uint64_t> deadline = sender_.ms_until_deadline();
+
+    if ( ack_deadline_.has_value() ) {
+      const uint64_t ack_end = std::max( ack_deadline_.value(), cumulative_time_ );
+      deadline = std::min( deadline.value_or( UINT64_MAX ), ack_end - cumulative_time_ );
+    }
+
+    const bool streams_finished = not sender_.sequence_numbers_in_flight() and sender_.reader().is_finished()
+                                  and receiver_.writer().is_closed();
+    const uint64_t linger_end = time_of_last_receipt_ + 10UL * cfg_.rt_timeout;
+    if ( linger_after_streams_finish_ and streams_finished and cumulative_time_ < linger_end ) {
+      deadline = std::min( deadline.value_or( UINT64_MAX ), linger_end - cumulative_time_ );
+    }
+
+    return deadline;
+  }
+
   /* Is the peer still active? */
   bool active() const
   {
@@ -53,12 +79,21 @@ public:
       return;
     }
 
+    receive( std::move( msg ) );
+    reply( transmit );
+  }
+
+  /* Take in a segment, but hold back the reply: after a burst of segments, one reply() answers them all, with a
+     single cumulative acknowledgment */
+  void receive( TCPMessage msg )
+  {
+    if ( not active() ) {
+      return;
+    }
+
     // Record time in case this peer has to linger after streams finish.
     time_of_last_receipt_ = cumulative_time_;
 
-    // If SenderMessage occupies a sequence number, make sure to reply.
-    need_send_ |= ( msg.sender.sequence_length() > 0 );
-
     // If SenderMessage is a "keep-alive" (with intentionally invalid seqno), make sure to reply.
     // (N.B. orthodox TCP rules require a reply on any unacceptable segment.)
     const auto our_ackno = receiver_.send().ackno;
@@ -69,13 +104,41 @@ public:
       linger_after_streams_finish_ = false;
     }
 
+    const uint64_t length = msg.sender.sequence_length();
+    const bool SYN = msg.sender.SYN;
+    const auto window_scale = msg.sender.window_scale;
+    const bool plain_data = not( msg.sender.SYN or msg.sender.FIN or msg.sender.payload.empty() );
+    const bool had_gap = receiver_.reassembler().bytes_pending() > 0;
+
     // Give incoming TCPSenderMessage to receiver.
     receiver_.receive( std::move( msg.sender ) );
 
-    // Give incoming TCPReceiverMessage to sender.
-    sender_.receive( msg.receiver );
+    // If SenderMessage occupies a sequence number, make sure to reply: at once, or (for data that arrived in order,
+    // was all accepted, neither filled nor left a gap, and stopped short of the end of the window we last offered,
+    // so the sender can still send more) with the next segment or by the delayed-ACK deadline.
+    if ( length > 0 ) {
+      const bool delay = cfg_.ack_delay > 0 and plain_data and our_ackno.has_value() and not had_gap
+                         and receiver_.send().ackno == our_ackno.value() + length
+                         and receiver_.reassembler().bytes_pending() == 0
+                         and receiver_.writer().bytes_pushed() < window_end_;
+      if ( delay and ++segments_unacknowledged_ < ACK_EVERY_SEGMENTS ) {
+        ack_deadline_ = ack_deadline_.value_or( cumulative_time_ + cfg_.ack_delay );
+      } else {
+        need_send_ = true;
+      }
+    }
+
+    // Give incoming TCPReceiverMessage to sender. (Only an empty segment can be a duplicate ACK. The window in a
+    // SYN is never scaled; the peer's SYN says how the windows after it are.)
+    sender_.receive( msg.receiver, length > 0 );
+    if ( SYN ) {
+      sender_.set_peer_window_scale( window_scale );
+    }
+  }
 
-    // Send reply if needed.
+  /* Send whatever the segments received so far allow (carrying the latest ackno), or a bare ACK if they need one */
+  void reply( const TransmitFunction& transmit )
+  {
     push( transmit );
     if ( need_send_ ) {
       send( sender_.make_empty_message(), transmit );
@@ -88,16 +151,36 @@ public:
 
 private:
   TCPConfig cfg_;
-  TCPSender sender_ { ByteStream { cfg_.send_capacity }, cfg_.isn, cfg_.rt_timeout };
-  TCPReceiver receiver_ { Reassembler { ByteStream { cfg_.recv_capacity } } };
+  TCPSender sender_ { ByteStream { cfg_.send_capacity, cfg_.stream_mode },
+                      cfg_.isn,
+                      cfg_.rt_timeout,
+                      CongestionControl::make( cfg_.congestion_control, TCPConfig::MAX_PAYLOAD_SIZE ),
+                      cfg_.adaptive_rto ? std::optional { TCPSender::RTOBounds { cfg_.rto_min, cfg_.rto_max } }
+                                        : std::nullopt,
+                      cfg_.fast_retransmit,
+                      cfg_.sack,
+                      cfg_.window_scale() };
+  TCPReceiver receiver_ { Reassembler { ByteStream { cfg_.recv_capacity, cfg_.stream_mode } },
+                          cfg_.sack,
+                          cfg_.window_scale() };
 
   bool need_send_ {};
 
+  // delayed ACKs (when cfg_.ack_delay is set): acknowledge at least every this many segments of data
+  static constexpr uint64_t ACK_EVERY_SEGMENTS = 2;
+  uint64_t segments_unacknowledged_ {};     // segments of data received since the last segment sent
+  std::optional<uint64_t> ack_deadline_ {}; // when to send an ACK, if nothing has carried one by then
+  uint64_t window_end_ {};                  // the end of the receive window last offered, as a stream index
+
   void send( const TCPSenderMessage& sender_message, const TransmitFunction& transmit )
   {
-    TCPMessage msg { sender_message, receiver_.send() };
+    TCPMessage msg { sender_message, receiver_.send( sender_message.SYN ) };
+    const uint8_t shift = sender_message.SYN ? 0 : receiver_.window_shift();
+    window_end_ = receiver_.writer().bytes_pushed() + ( uint64_t { msg.receiver.window_size } << shift );
     transmit( std::move( msg ) );
     need_send_ = false;
+    segments_unacknowledged_ = 0;
+    ack_deadline_.reset();
   }
 
   bool linger_after_streams_finish_ { true }; // one peer may need to linger to make sure all closure conditions met
@@ -3,25 +3,40 @@
 #include "wrapping_integers.hh"
 
 #include <optional>
+#include <vector>
 
 /*
  * The TCPReceiverMessage structure contains the information sent from a TCP receiver to its sender.
  *
- * It contains three fields:
+ * It contains four fields:
  *
  * 1) The acknowledgment number (ackno): the *next* sequence number needed by the TCP Receiver.
  *    This is an optional field that is empty if the TCPReceiver hasn't yet received the Initial Sequence Number.
  *
  * 2) The window size. This is the number of sequence numbers that the TCP receiver is interested
  *    to receive, starting from the ackno if present. The maximum value is 65,535 (UINT16_MAX from
- *    the <cstdint> header).
+ *    the <cstdint> header), unless both SYNs offered window scaling: after the SYNs, it is then shifted
+ *    right by the shift the receiver's side offered.
  *
  * 3) The RST (reset) flag. If set, the stream has suffered an error and the connection should be aborted.
+ *
+ * 4) SACK blocks (RFC 2018), if the sender permitted them on its SYN: up to four ranges of sequence numbers
+ *    the receiver holds beyond the ackno, with the block holding the most recently received segment first.
  */
 
+// A range of sequence numbers [left, right) the receiver holds, with a gap before it
+struct SACKBlock
+{
+  Wrap32 left { 0 };
+  Wrap32 right { 0 };
+};
+
 struct TCPReceiverMessage
 {
+  static constexpr size_t MAX_SACK_BLOCKS = 4; // as many as fit in the 40 bytes of TCP options
+
   std::optional<Wrap32> ackno {};
   uint16_t window_size {};
   bool RST {};
+  std::vector<SACKBlock> sack {};
 };
@@ -2,9 +2,19 @@
 #include "checksum.hh"
 #include "wrapping_integers.hh"
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
 
 static constexpr uint32_t TCPHeaderMinLen = 5; // 32-bit words
+static constexpr uint32_t TCPHeaderMaxLen = 15;
+
+// option kinds (RFC 9293, RFC 2018, RFC 7323)
+static constexpr uint8_t TCPOptionEnd = 0;
+static constexpr uint8_t TCPOptionNoOp = 1;
+static constexpr uint8_t TCPOptionWindowScale = 3;
+static constexpr uint8_t TCPOptionSACKPermitted = 4;
+static constexpr uint8_t TCPOptionSACK = 5;
 
 using namespace std;
 
@@ -12,50 +22,103 @@ void TCPSegment::parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum
 {
   /* verify checksum */
   InternetChecksum check { datagram_layer_pseudo_checksum };
-  check.add( parser.buffer() );
+  parser.for_each_remaining( [&check]( string_view bytes ) { check.add( bytes ); } );
   if ( check.value() ) {
     parser.set_error();
     return;
   }
 
-  uint32_t raw32 {};
-  uint16_t raw16 {};
-  uint8_t octet {};
-
-  parser.integer( udinfo.src_port );
-  parser.integer( udinfo.dst_port );
-
-  parser.integer( raw32 );
-  message.sender.seqno = Wrap32 { raw32 };
-
-  parser.integer( raw32 );
-  message.receiver.ackno = Wrap32 { raw32 };
-
-  parser.integer( octet );
-  const uint8_t data_offset = octet >> 4;
+  uint32_t seqno {};
+  uint32_t ackno {};
+  uint8_t data_offset_byte {};
+  uint8_t flags {};
+  uint16_t urgent_pointer {};
+
+  const string_view fixed = parser.contiguous( TCPHeaderMinLen * 4 );
+  if ( not fixed.empty() ) {
+    // fast path: the whole fixed header is in one buffer
+    udinfo.src_port = load_big_endian<uint16_t>( &fixed[0] );
+    udinfo.dst_port = load_big_endian<uint16_t>( &fixed[2] );
+    seqno = load_big_endian<uint32_t>( &fixed[4] );
+    ackno = load_big_endian<uint32_t>( &fixed[8] );
+    data_offset_byte = fixed[12];
+    flags = fixed[13];
+    message.receiver.window_size = load_big_endian<uint16_t>( &fixed[14] );
+    udinfo.cksum = load_big_endian<uint16_t>( &fixed[16] );
+    parser.remove_prefix( TCPHeaderMinLen * 4 );
+  } else {
+    parser.integer( udinfo.src_port );
+    parser.integer( udinfo.dst_port );
+    parser.integer( seqno );
+    parser.integer( ackno );
+    parser.integer( data_offset_byte );
+    parser.integer( flags );
+    parser.integer( message.receiver.window_size );
+    parser.integer( udinfo.cksum );
+    parser.integer( urgent_pointer );
+  }
 
-  parser.integer( octet ); // flags
-  if ( not( octet & 0b0001'0000 ) ) {
+  message.sender.seqno = Wrap32 { seqno };
+  message.receiver.ackno = Wrap32 { ackno };
+  const uint8_t data_offset = data_offset_byte >> 4;
+  if ( not( flags & 0b0001'0000 ) ) {
     message.receiver.ackno.reset(); // no ACK
   }
 
-  message.sender.RST = message.receiver.RST = octet & 0b0000'0100;
-  message.sender.SYN = octet & 0b0000'0010;
-  message.sender.FIN = octet & 0b0000'0001;
+  message.sender.RST = message.receiver.RST = flags & 0b0000'0100;
+  message.sender.SYN = flags & 0b0000'0010;
+  message.sender.FIN = flags & 0b0000'0001;
 
-  parser.integer( message.receiver.window_size );
-  parser.integer( udinfo.cksum );
-  parser.integer( raw16 ); // urgent pointer
-
-  // skip any options or anything extra in the header
   if ( data_offset < TCPHeaderMinLen ) {
     parser.set_error();
+    return;
   }
-  parser.remove_prefix( data_offset * 4 - TCPHeaderMinLen * 4 );
+  parse_options( parser, ( data_offset - TCPHeaderMinLen ) * 4 );
 
   parser.all_remaining( message.sender.payload );
 }
 
+// Read the window-scale, SACK-permitted and SACK options, and skip any others
+void TCPSegment::parse_options( Parser& parser, size_t length )
+{
+  message.sender.SACK_permitted = false;
+  message.sender.window_scale.reset();
+  message.receiver.sack.clear();
+  if ( length == 0 ) {
+    return;
+  }
+  std::array<char, ( TCPHeaderMaxLen - TCPHeaderMinLen ) * 4> options {};
+  parser.string( { options.data(), length } );
+
+  for ( size_t i = 0; i < length and not parser.has_error(); ) {
+    const auto kind = static_cast<uint8_t>( options[i] );
+    if ( kind == TCPOptionEnd ) {
+      break;
+    }
+    if ( kind == TCPOptionNoOp ) {
+      ++i;
+      continue;
+    }
+
+    const auto option_length = i + 1 < length ? static_cast<uint8_t>( options[i + 1] ) : 0;
+    if ( option_length < 2 or i + option_length > length ) {
+      parser.set_error();
+      break;
+    }
+    if ( kind == TCPOptionWindowScale and option_length == 3 ) {
+      message.sender.window_scale = static_cast<uint8_t>( options[i + 2] );
+    } else if ( kind == TCPOptionSACKPermitted ) {
+      message.sender.SACK_permitted = true;
+    } else if ( kind == TCPOptionSACK ) {
+      for ( size_t block = i + 2; block + 8 <= i + option_length; block += 8 ) {
+        message.receiver.sack.push_back( { Wrap32 { load_big_endian<uint32_t>( &options[block] ) },
+                                           Wrap32 { load_big_endian<uint32_t>( &options[block + 4] ) } } );
+      }
+    }
+    i += option_length;
+  }
+}
+
 class Wrap32Serializable : public Wrap32
 {
 public:
@@ -63,12 +126,47 @@ public:
 };
 
 void TCPSegment::serialize( Serializer& serializer ) const
+{
+  serialize( serializer, message, udinfo );
+}
+
+namespace {
+
+bool sack_permitted( const TCPMessage& message )
+{
+  return message.sender.SYN and message.sender.SACK_permitted;
+}
+
+bool window_scale( const TCPMessage& message )
+{
+  return message.sender.SYN and message.sender.window_scale.has_value();
+}
+
+// the SACK blocks that fit in the options, after any others (each padded with no-ops to four bytes)
+size_t sack_blocks( const TCPMessage& message )
+{
+  const size_t room = ( TCPHeaderMaxLen - TCPHeaderMinLen ) * 4 - ( sack_permitted( message ) ? 4 : 0 )
+                      - ( window_scale( message ) ? 4 : 0 );
+  return min( { message.receiver.sack.size(), TCPReceiverMessage::MAX_SACK_BLOCKS, ( room - 4 ) / 8 } );
+}
+
+} // namespace
+
+size_t TCPSegment::header_length( const TCPMessage& message )
+{
+  // each option is padded with no-ops to a multiple of four bytes
+  return TCPHeaderMinLen * 4 + ( sack_permitted( message ) ? 4 : 0 ) + ( window_scale( message ) ? 4 : 0 )
+         + ( sack_blocks( message ) ? 4 + 8 * sack_blocks( message ) : 0 );
+}
+
+// Serialize a segment without needing a TCPSegment (and a copy of the payload) to hold it
+void TCPSegment::serialize( Serializer& serializer, const TCPMessage& message, const UserDatagramInfo& udinfo )
 {
   serializer.integer( udinfo.src_port );
   serializer.integer( udinfo.dst_port );
   serializer.integer( Wrap32Serializable { message.sender.seqno }.raw_value() );
   serializer.integer( Wrap32Serializable { message.receiver.ackno.value_or( Wrap32 { 0 } ) }.raw_value() );
-  serializer.integer( uint8_t { TCPHeaderMinLen << 4 } ); // data offset
+  serializer.integer( static_cast<uint8_t>( header_length( message ) / 4 << 4 ) ); // data offset
   const bool reset = message.sender.RST or message.receiver.RST;
   const uint8_t flags = ( message.receiver.ackno.has_value() ? 0b0001'0000U : 0 ) | ( reset ? 0b0000'0100U : 0 )
                         | ( message.sender.SYN ? 0b0000'0010U : 0 ) | ( message.sender.FIN ? 0b0000'0001U : 0 );
@@ -76,7 +174,24 @@ void TCPSegment::serialize( Serializer& serializer ) const
   serializer.integer( message.receiver.window_size );
   serializer.integer( udinfo.cksum );
   serializer.integer( uint16_t { 0 } ); // urgent pointer
-  serializer.buffer( message.sender.payload );
+
+  if ( sack_permitted( message ) ) {
+    serializer.integer( uint32_t { TCPOptionNoOp << 24 | TCPOptionNoOp << 16 | TCPOptionSACKPermitted << 8 | 2 } );
+  }
+  if ( window_scale( message ) ) {
+    serializer.integer( static_cast<uint32_t>( TCPOptionNoOp << 24 | TCPOptionWindowScale << 16 | 3 << 8
+                                               | message.sender.window_scale.value() ) );
+  }
+  if ( const size_t blocks = sack_blocks( message ) ) {
+    serializer.integer( static_cast<uint32_t>( TCPOptionNoOp << 24 | TCPOptionNoOp << 16 | TCPOptionSACK << 8
+                                               | ( 2 + 8 * blocks ) ) );
+    for ( size_t i = 0; i < blocks; ++i ) {
+      serializer.integer( Wrap32Serializable { message.receiver.sack[i].left }.raw_value() );
+      serializer.integer( Wrap32Serializable { message.receiver.sack[i].right }.raw_value() );
+    }
+  }
+
+  serializer.payload( message.sender.payload );
 }
 
 void TCPSegment::compute_checksum( uint32_t datagram_layer_pseudo_checksum )
@@ -89,3 +204,20 @@ void TCPSegment::compute_checksum( uint32_t datagram_layer_pseudo_checksum )
   check.add( s.output() );
   udinfo.cksum = check.value();
 }
+
+void TCPSegment::set_src_port( uint16_t port )
+{
+  udinfo.cksum = InternetChecksum::adjust16( udinfo.cksum, udinfo.src_port, port );
+  udinfo.src_port = port;
+}
+
+void TCPSegment::set_dst_port( uint16_t port )
+{
+  udinfo.cksum = InternetChecksum::adjust16( udinfo.cksum, udinfo.dst_port, port );
+  udinfo.dst_port = port;
+}
+
+void TCPSegment::adjust_checksum_for_address( uint32_t old_address, uint32_t new_address )
+{
+  udinfo.cksum = InternetChecksum::adjust32( udinfo.cksum, old_address, new_address );
+}
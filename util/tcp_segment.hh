@@ -18,6 +18,20 @@ struct TCPSegment
 
   void parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum );
   void serialize( Serializer& serializer ) const;
+  static void serialize( Serializer& serializer, const TCPMessage& message, const UserDatagramInfo& udinfo );
+
+  // Length of the header (with the options the message needs) that serialize() writes, in bytes
+  static size_t header_length( const TCPMessage& message );
 
   void compute_checksum( uint32_t datagram_layer_pseudo_checksum );
+
+  // Rewrite a port and adjust the (already correct) checksum to match, without re-summing the segment (RFC 1624)
+  void set_src_port( uint16_t port );
+  void set_dst_port( uint16_t port );
+
+  // Adjust the checksum for an address in the pseudo-header changing, e.g. after IPv4Header::set_src
+  void adjust_checksum_for_address( uint32_t old_address, uint32_t new_address );
+
+private:
+  void parse_options( Parser& parser, size_t length );
 };
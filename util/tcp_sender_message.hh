@@ -2,12 +2,14 @@
 
 #include "wrapping_integers.hh"
 
+#include <cstdint>
+#include <optional>
 #include <string>
 
 /*
  * The TCPSenderMessage structure contains the information sent from a TCP sender to its receiver.
  *
- * It contains five fields:
+ * It contains seven fields:
  *
  * 1) The sequence number (seqno) of the beginning of the segment. If the SYN flag is set, this is the
  *    sequence number of the SYN flag. Otherwise, it's the sequence number of the beginning of the payload.
@@ -20,6 +22,12 @@
  * 4) The FIN flag. If set, the payload represents the ending of the byte stream.
  *
  * 5) The RST (reset) flag. If set, the stream has suffered an error and the connection should be aborted.
+ *
+ * 6) The SACK-permitted option (RFC 2018). Only on a SYN: the sender understands SACK blocks, so the receiver
+ *    may send them.
+ *
+ * 7) The window-scale option (RFC 7323). Only on a SYN: the sending side will shift the windows it advertises
+ *    right by this many bits (once the other side's SYN has offered the option too).
  */
 
 struct TCPSenderMessage
@@ -32,6 +40,9 @@ struct TCPSenderMessage
 
   bool RST {};
 
+  bool SACK_permitted {};
+  std::optional<uint8_t> window_scale {};
+
   // How many sequence numbers does this segment use?
   size_t sequence_length() const { return SYN + payload.size() + FIN; }
 };
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "address.hh"
+#include "eventloop.hh"
+#include "slot_map.hh"
+#include "tcp_config.hh"
+#include "tcp_over_ip.hh"
+#include "tcp_peer.hh"
+#include "tuntap_adapter.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+//! Many TCP connections over one TUN device, all served by one EventLoop on the caller's thread.
+//! \details Each inbound segment goes to its connection's TCPPeer by a hash-table lookup of its four-tuple. A SYN
+//! to a listening port makes a new connection, which waits in that port's accept queue once its handshake is
+//! done. Rather than ticking every connection periodically, each one keeps an EventLoop timer armed for its next
+//! deadline (a retransmission, or the end of lingering), and is told how much time has passed whenever it is used.
+class TCPStack
+{
+public:
+  //! Names a connection. It goes stale when the stack frees the connection, which is never before close().
+  using ConnectionId = SlotKey;
+
+  //! Says whether a flow belongs to this stack, when it is one of several sharing a TUN device
+  using FlowOwner = std::function<bool( const FourTuple& flow )>;
+
+  //! \param[in] adapter carries the IPv4 datagrams of every connection
+  //! \param[in] local_address is this end's IPv4 address; segments to any other address are ignored
+  //! \param[in] config is the configuration of every connection's TCPPeer (its addresses are not used)
+  //! \param[in] owner, if set, makes this stack one shard of several (see ShardedTCPStack). It then leaves
+  //! reading the device to someone else, who hands it the segments of its own flows through receive(), and
+  //! connect() only opens flows that `owner` accepts.
+  TCPStack( TCPOverIPv4OverTunFdAdapter&& adapter,
+            const Address& local_address,
+            const TCPConfig& config = {},
+            FlowOwner owner = {} );
+
+  // the event loop's rules and timers refer to the stack by address
+  TCPStack( const TCPStack& other ) = delete;
+  TCPStack& operator=( const TCPStack& other ) = delete;
+
+  //! Accept connections to `port`
+  void listen( uint16_t port );
+
+  //! The oldest connection to `port` that has finished its handshake and not yet been accepted
+  std::optional<ConnectionId> accept( uint16_t port );
+
+  //! Open a connection from an unused local port to `destination`
+  ConnectionId connect( const Address& destination );
+
+  //! The connection's outbound stream (call push() after writing to it)
+  Writer& outbound_writer( ConnectionId id ) { return connection( id ).peer.outbound_writer(); }
+
+  //! The connection's inbound stream
+  Reader& inbound_reader( ConnectionId id ) { return connection( id ).peer.inbound_reader(); }
+
+  //! The connection's addresses and ports
+  const FourTuple& flow( ConnectionId id ) { return connection( id ).flow; }
+
+  //! Is the connection still open? (See TCPPeer::active.)
+  bool active( ConnectionId id ) { return connection( id ).peer.active(); }
+
+  //! Handle a segment of the connection `flow` (from this end's point of view)
+  void receive( const FourTuple& flow, TCPMessage msg );
+
+  //! Send whatever has been written to the outbound stream, as far as the peer's window allows
+  void push( ConnectionId id );
+
+  //! The application is done with the connection: end its outbound stream, and free it (making `id` stale) as
+  //! soon as TCP is done with it too
+  void close( ConnectionId id );
+
+  //! Replace the contents of `ids` with the connections that have had something happen (inbound data, the
+  //! handshake or a stream finishing, an error) since the last call, each listed once. Connections the
+  //! application has closed are left out.
+  void take_active( std::vector<ConnectionId>& ids );
+
+  //! Wait for and handle the next event (see EventLoop::wait_next_event)
+  EventLoop::Result wait_next_event( int timeout_ms ) { return _eventloop.wait_next_event( timeout_ms ); }
+
+  //! The event loop, for adding the application's own rules
+  EventLoop& eventloop() { return _eventloop; }
+
+  //! The number of connections the stack holds, including those lingering or waiting to be accepted
+  size_t size() const { return _connections.size(); }
+
+private:
+  struct Connection
+  {
+    FourTuple flow;
+    TCPPeer peer;
+    uint64_t last_tick;                                 //!< when `peer` was last told how much time had passed
+    std::optional<EventLoop::RuleHandle> timer {};      //!< fires at `timer_deadline`
+    std::optional<uint64_t> timer_deadline {};          //!< the peer's next deadline, as a timestamp
+    bool established {};                                //!< the handshake has finished
+    bool visible {};                                    //!< the application knows the connection's id
+    bool listed {};                                     //!< the connection is in `_active`
+    bool closed {};                                     //!< the application has called close()
+
+    Connection( const FourTuple& flow_, const TCPConfig& config, uint64_t now )
+      : flow( flow_ ), peer( config ), last_tick( now )
+    {}
+  };
+
+  struct FourTupleHash
+  {
+    size_t operator()( const FourTuple& flow ) const;
+  };
+
+  TCPOverIPv4OverTunFdAdapter _adapter;
+  uint32_t _local_address;
+  TCPConfig _config;
+  FlowOwner _owner;
+  EventLoop _eventloop { EventLoop::Backend::Poll, EventLoop::Dispatch::All };
+  size_t _timer_category;
+
+  SlotMap<Connection> _connections {};
+  std::unordered_map<FourTuple, ConnectionId, FourTupleHash> _flows {};
+  std::unordered_map<uint16_t, std::deque<ConnectionId>> _listeners {}; //!< port -> accept queue
+  std::vector<ConnectionId> _active {};
+  uint16_t _next_port;
+
+  Connection& connection( ConnectionId id );
+  ConnectionId open( const FourTuple& flow, uint64_t now );
+  void read_adapter();
+  void tick( Connection& c, uint64_t now );
+  void notify( ConnectionId id, Connection& c );
+  void update( ConnectionId id, Connection& c, uint64_t now );
+};
@@ -0,0 +1,272 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+//! A hierarchical timing wheel (Varghese and Lauck), counting time in ticks (EventLoop uses milliseconds).
+//! \details Level 0 has a slot for each of the next 64 ticks, and every level above spans 64 times more time
+//! with the same 64 slots. A timer waits on the lowest level that reaches its deadline, and moves down
+//! ("cascades") when the level below wraps around to its slot, so scheduling, cancelling and expiring a timer
+//! all take constant time. Timers more than 64^4 ticks away wait in an overflow list.
+template<class T>
+class TimerWheel
+{
+public:
+  //! Names a scheduled timer. It is safe to cancel an Id whose timer has already fired or been cancelled.
+  using Id = uint64_t;
+
+  explicit TimerWheel( uint64_t now = 0 ) : now_( now ) { heads_.fill( NIL ); }
+
+  uint64_t now() const { return now_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  //! Schedule `value` to expire at `deadline`, or on the next tick if that has passed
+  Id schedule( uint64_t deadline, T value );
+
+  //! Remove a pending timer. Returns false if it had already fired or been cancelled.
+  bool cancel( Id id );
+
+  //! The deadline of the earliest pending timer
+  std::optional<uint64_t> next_deadline() const;
+
+  //! Move time forward to `now`, calling `expire( deadline, T&& value )` for each timer due by then
+  template<class F>
+  void advance( uint64_t now, F&& expire );
+
+private:
+  static constexpr unsigned BITS = 6;
+  static constexpr size_t SLOTS = 1 << BITS;
+  static constexpr uint64_t MASK = SLOTS - 1;
+  static constexpr unsigned LEVELS = 4;
+  static constexpr size_t OVERFLOW_LIST = LEVELS * SLOTS;
+  static constexpr uint32_t NIL = std::numeric_limits<uint32_t>::max();
+
+  struct Node
+  {
+    uint64_t deadline {};
+    std::optional<T> value {}; //!< empty while the node is free
+    uint32_t generation {};
+    uint32_t list {};
+    uint32_t prev { NIL };
+    uint32_t next { NIL };
+  };
+
+  uint64_t now_;
+  size_t size_ {};
+  std::vector<Node> nodes_ {};
+  std::vector<uint32_t> free_ {};
+  std::array<uint32_t, LEVELS * SLOTS + 1> heads_ {}; //!< first node of each slot's list, and of the overflow
+  std::vector<T> due_ {};                              //!< the values expiring on the current tick
+
+  std::optional<uint64_t> next_event( bool exact ) const;
+  void place( uint32_t index );
+  void link( uint32_t index, size_t list );
+  void unlink( uint32_t index );
+  void cascade( size_t list );
+  template<class F>
+  void tick( F&& expire );
+};
+
+template<class T>
+typename TimerWheel<T>::Id TimerWheel<T>::schedule( uint64_t deadline, T value )
+{
+  uint32_t index {};
+  if ( free_.empty() ) {
+    index = static_cast<uint32_t>( nodes_.size() );
+    nodes_.emplace_back();
+  } else {
+    index = free_.back();
+    free_.pop_back();
+  }
+
+  Node& node = nodes_[index];
+  node.deadline = std::max( deadline, now_ + 1 );
+  node.value.emplace( std::move( value ) );
+  place( index );
+  ++size_;
+  return static_cast<Id>( node.generation ) << 32 | index;
+}
+
+template<class T>
+bool TimerWheel<T>::cancel( Id id )
+{
+  const auto index = static_cast<uint32_t>( id );
+  if ( index >= nodes_.size() or nodes_[index].generation != id >> 32 or not nodes_[index].value.has_value() ) {
+    return false;
+  }
+
+  unlink( index );
+  nodes_[index].value.reset();
+  ++nodes_[index].generation;
+  free_.push_back( index );
+  --size_;
+  return true;
+}
+
+template<class T>
+std::optional<uint64_t> TimerWheel<T>::next_deadline() const
+{
+  return next_event( true );
+}
+
+// With `exact`, the earliest deadline. Otherwise, the earliest tick at which a timer expires or cascades.
+template<class T>
+std::optional<uint64_t> TimerWheel<T>::next_event( bool exact ) const
+{
+  if ( empty() ) {
+    return {};
+  }
+
+  std::optional<uint64_t> earliest;
+  auto consider = [&]( uint64_t cascade_time, size_t list ) {
+    uint64_t time = cascade_time;
+    if ( exact ) {
+      time = std::numeric_limits<uint64_t>::max();
+      for ( uint32_t index = heads_[list]; index != NIL; index = nodes_[index].next ) {
+        time = std::min( time, nodes_[index].deadline );
+      }
+    }
+    earliest = std::min( earliest.value_or( time ), time );
+  };
+
+  // level 0 holds timers to the tick; the slot for `now_` has already been expired
+  for ( uint64_t k = 1; k < SLOTS; ++k ) {
+    if ( heads_[( now_ + k ) & MASK] != NIL ) {
+      consider( now_ + k, ( now_ + k ) & MASK );
+      break;
+    }
+  }
+
+  // each slot of an upper level covers a later stretch of time than the one before it
+  for ( unsigned level = 1; level < LEVELS; ++level ) {
+    const unsigned shift = BITS * level;
+    for ( uint64_t k = 1; k <= SLOTS; ++k ) {
+      const size_t list = level * SLOTS + ( ( ( now_ >> shift ) + k ) & MASK );
+      if ( heads_[list] != NIL ) {
+        consider( ( ( now_ >> shift ) + k ) << shift, list );
+        break;
+      }
+    }
+  }
+
+  if ( heads_[OVERFLOW_LIST] != NIL ) {
+    consider( ( ( now_ >> ( BITS * LEVELS ) ) + 1 ) << ( BITS * LEVELS ), OVERFLOW_LIST );
+  }
+
+  return earliest;
+}
+
+template<class T>
+template<class F>
+void TimerWheel<T>::advance( uint64_t now, F&& expire )
+{
+  while ( now_ < now ) {
+    // skip straight past ticks where nothing expires or cascades
+    const auto next = next_event( false );
+    if ( not next.has_value() or next.value() > now ) {
+      now_ = now;
+      return;
+    }
+    now_ = next.value() - 1;
+    tick( expire );
+  }
+}
+
+template<class T>
+template<class F>
+void TimerWheel<T>::tick( F&& expire )
+{
+  ++now_;
+
+  // when a level wraps around, bring the next slot of the level above down
+  if ( ( now_ & MASK ) == 0 ) {
+    unsigned level = 1;
+    for ( ; level < LEVELS; ++level ) {
+      const uint64_t slot = ( now_ >> ( BITS * level ) ) & MASK;
+      cascade( level * SLOTS + slot );
+      if ( slot != 0 ) {
+        break;
+      }
+    }
+    if ( level == LEVELS ) {
+      cascade( OVERFLOW_LIST );
+    }
+  }
+
+  // take every timer due now off the wheel before running any callbacks, since they may schedule or cancel
+  due_.clear();
+  const size_t slot = now_ & MASK;
+  while ( heads_[slot] != NIL ) {
+    const uint32_t index = heads_[slot];
+    unlink( index );
+    due_.push_back( std::move( nodes_[index].value.value() ) );
+    nodes_[index].value.reset();
+    ++nodes_[index].generation;
+    free_.push_back( index );
+    --size_;
+  }
+
+  for ( auto& value : due_ ) {
+    expire( now_, std::move( value ) );
+  }
+}
+
+template<class T>
+void TimerWheel<T>::place( uint32_t index )
+{
+  const uint64_t deadline = nodes_[index].deadline;
+  const uint64_t delta = deadline - now_;
+  for ( unsigned level = 0; level < LEVELS; ++level ) {
+    if ( delta < uint64_t { 1 } << ( BITS * ( level + 1 ) ) ) {
+      link( index, level * SLOTS + ( ( deadline >> ( BITS * level ) ) & MASK ) );
+      return;
+    }
+  }
+  link( index, OVERFLOW_LIST );
+}
+
+template<class T>
+void TimerWheel<T>::link( uint32_t index, size_t list )
+{
+  Node& node = nodes_[index];
+  node.list = static_cast<uint32_t>( list );
+  node.prev = NIL;
+  node.next = heads_[list];
+  if ( node.next != NIL ) {
+    nodes_[node.next].prev = index;
+  }
+  heads_[list] = index;
+}
+
+template<class T>
+void TimerWheel<T>::unlink( uint32_t index )
+{
+  const Node& node = nodes_[index];
+  if ( node.prev != NIL ) {
+    nodes_[node.prev].next = node.next;
+  } else {
+    heads_[node.list] = node.next;
+  }
+  if ( node.next != NIL ) {
+    nodes_[node.next].prev = node.prev;
+  }
+}
+
+template<class T>
+void TimerWheel<T>::cascade( size_t list )
+{
+  uint32_t index = heads_[list];
+  heads_[list] = NIL;
+  while ( index != NIL ) {
+    const uint32_t next = nodes_[index].next;
+    place( index );
+    index = next;
+  }
+}
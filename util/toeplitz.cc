@@ -0,0 +1,42 @@
+#include "toeplitz.hh"
+
+using namespace std;
+
+ToeplitzHash::ToeplitzHash( const Key& key )
+{
+  // the 32 bits of the key starting at bit `offset`, counting from the most significant bit of key[0]
+  auto window = [&key]( size_t offset ) {
+    uint64_t bits = 0;
+    for ( size_t i = 0; i < 8; ++i ) {
+      const size_t index = offset / 8 + i;
+      bits = bits << 8 | ( index < key.size() ? key[index] : 0 );
+    }
+    return static_cast<uint32_t>( bits >> ( 32 - offset % 8 ) );
+  };
+
+  for ( size_t byte = 0; byte < INPUT_LENGTH; ++byte ) {
+    for ( size_t value = 0; value < 256; ++value ) {
+      uint32_t hash = 0;
+      for ( size_t bit = 0; bit < 8; ++bit ) {
+        if ( value & ( 0x80U >> bit ) ) {
+          hash ^= window( byte * 8 + bit );
+        }
+      }
+      tables_[byte][value] = hash;
+    }
+  }
+}
+
+uint32_t ToeplitzHash::operator()( const FourTuple& flow ) const
+{
+  const array<uint32_t, 3> words { flow.remote_address,
+                                   flow.local_address,
+                                   static_cast<uint32_t>( flow.remote_port ) << 16 | flow.local_port };
+  uint32_t hash = 0;
+  for ( size_t word = 0; word < words.size(); ++word ) {
+    for ( size_t byte = 0; byte < 4; ++byte ) {
+      hash ^= tables_[word * 4 + byte][( words[word] >> ( 24 - 8 * byte ) ) & 0xff];
+    }
+  }
+  return hash;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "tcp_over_ip.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+//! The Toeplitz hash that network cards use for receive-side scaling (RSS), applied to a TCP connection's
+//! four-tuple. Both ends of a connection hash it the way the card would hash the segments they receive: remote
+//! address, local address, remote port, local port, each in network byte order.
+//! \details Each input bit that is set XORs in the 32 bits of the key that start at that bit's position. The
+//! constructor folds that into a table for each of the 12 input bytes, so hashing takes 12 lookups.
+class ToeplitzHash
+{
+public:
+  static constexpr size_t KEY_LENGTH = 40;
+  using Key = std::array<uint8_t, KEY_LENGTH>;
+
+  //! The key from Microsoft's RSS specification, which many drivers also use by default
+  static constexpr Key DEFAULT_KEY {
+    0x6d, 0x5a, 0x56, 0xda, 0x25, 0x5b, 0x0e, 0xc2, 0x41, 0x67,
+    0x25, 0x3d, 0x43, 0xa3, 0x8f, 0xb0, 0xd0, 0xca, 0x2b, 0xcb,
+    0xae, 0x7b, 0x30, 0xb4, 0x77, 0xcb, 0x2d, 0xa3, 0x80, 0x30,
+    0xf2, 0x0c, 0x6a, 0x42, 0xb7, 0x3b, 0xbe, 0xac, 0x01, 0xfa };
+
+  explicit ToeplitzHash( const Key& key = DEFAULT_KEY );
+
+  uint32_t operator()( const FourTuple& flow ) const;
+
+private:
+  static constexpr size_t INPUT_LENGTH = 12;
+
+  std::array<std::array<uint32_t, 256>, INPUT_LENGTH> tables_ {};
+};
@@ -3,6 +3,7 @@
 #include "file_descriptor.hh"
 
 #include <string>
+#include <utility>
 
 //! A FileDescriptor to a [Linux TUN/TAP](https://www.kernel.org/doc/Documentation/networking/tuntap.txt) device
 class TunTapFD : public FileDescriptor
@@ -11,6 +12,10 @@ public:
   //! Open an existing persistent [TUN or TAP
   //! device](https://www.kernel.org/doc/Documentation/networking/tuntap.txt).
   explicit TunTapFD( const std::string& devname, bool is_tun );
+
+  //! Stand in for a device with `fd`, which must carry one datagram (or frame) per read and write, like one end of
+  //! a SOCK_SEQPACKET socketpair. For tests.
+  explicit TunTapFD( FileDescriptor&& fd ) : FileDescriptor( std::move( fd ) ) {}
 };
 
 //! A FileDescriptor to a [Linux TUN](https://www.kernel.org/doc/Documentation/networking/tuntap.txt) device
@@ -19,6 +24,9 @@ class TunFD : public TunTapFD
 public:
   //! Open an existing persistent [TUN device](https://www.kernel.org/doc/Documentation/networking/tuntap.txt).
   explicit TunFD( const std::string& devname ) : TunTapFD( devname, true ) {}
+
+  //! Stand in for a TUN device with a file descriptor that carries IPv4 datagrams (see TunTapFD)
+  explicit TunFD( FileDescriptor&& fd ) : TunTapFD( std::move( fd ) ) {}
 };
 
 //! A FileDescriptor to a [Linux TAP](https://www.kernel.org/doc/Documentation/networking/tuntap.txt) device
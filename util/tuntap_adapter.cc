@@ -1,20 +1,58 @@
 #include "tuntap_adapter.hh"
+#include "buffer_pool.hh"
 #include "parser.hh"
 
+#include <span>
+
 using namespace std;
 
 optional<TCPMessage> TCPOverIPv4OverTunFdAdapter::read()
 {
-  vector<string> strs( 2 );
-  strs.front().resize( IPv4Header::LENGTH );
-  _tun.read( strs );
-
-  InternetDatagram ip_dgram;
-  const vector<string> buffers = { strs.at( 0 ), strs.at( 1 ) };
-  if ( parse( ip_dgram, buffers ) ) {
-    return unwrap_tcp_in_ip( ip_dgram );
+  if ( not read_datagram() ) {
+    return {};
+  }
+  Parser datagram { span { _datagram } };
+  return unwrap_tcp_in_ip( datagram );
+}
+
+optional<TCPMessage> TCPOverIPv4OverTunFdAdapter::read( FourTuple& flow )
+{
+  if ( not read_datagram() ) {
+    return {};
   }
-  return {};
+  Parser datagram { span { _datagram } };
+  return unwrap_tcp_in_ip( datagram, flow );
+}
+
+//! \details The datagram's first HEADERS_LENGTH bytes (just the headers, for a TCP segment without options) go
+//! into `_datagram[0]`, and the rest into a pooled buffer in `_datagram[1]`, so that a payload can become the
+//! TCPMessage's as it is. A buffer whose contents are moved out is replaced from the pool on the next read.
+bool TCPOverIPv4OverTunFdAdapter::read_datagram()
+{
+  auto& [headers, rest] = _datagram;
+  headers.resize( HEADERS_LENGTH );
+  if ( BufferPool::is_buffer( rest ) ) {
+    rest.resize( BufferPool::BUFFER_SIZE );
+  } else {
+    rest = BufferPool::local().take();
+  }
+  _tun.read( span { _datagram } );
+  return not headers.empty();
+}
+
+void TCPOverIPv4OverTunFdAdapter::write( const TCPMessage& seg )
+{
+  // headers go into _frame and the payload is written from where it is, in a single writev
+  Serializer frame { _frame };
+  wrap_tcp_in_ip( seg, frame );
+  _tun.write( frame.views() );
+}
+
+void TCPOverIPv4OverTunFdAdapter::write( const TCPMessage& seg, const FourTuple& flow )
+{
+  Serializer frame { _frame };
+  wrap_tcp_in_ip( seg, flow, frame );
+  _tun.write( frame.views() );
 }
 
 //! Specialize LossyFdAdapter to TCPOverIPv4OverTunFdAdapter
@@ -4,7 +4,11 @@
 #include "tcp_segment.hh"
 #include "tun.hh"
 
+#include <array>
+#include <cstddef>
 #include <optional>
+#include <span>
+#include <string>
 #include <unordered_map>
 #include <utility>
 
@@ -19,21 +23,61 @@ concept TCPDatagramAdapter = requires( T a, TCPMessage seg ) {
   } -> std::same_as<std::optional<TCPMessage>>;
 };
 
+//! An adapter that can also take every datagram already waiting in one go (see read_batch())
+template<class T>
+concept BatchTCPDatagramAdapter
+  = TCPDatagramAdapter<T> and requires( T a, size_t max_datagrams, void ( *receive )( TCPMessage&& ) ) {
+      {
+        a.read_batch( max_datagrams, receive )
+      } -> std::same_as<size_t>;
+    };
+
 //! \brief A FD adapter for IPv4 datagrams read from and written to a TUN device
 class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter
 {
 private:
   TunFD _tun;
+  std::array<char, 120> _frame {}; //!< room for the IPv4 and TCP headers (with options) of an outbound datagram
+
+  static constexpr size_t HEADERS_LENGTH = 40; //!< IPv4 and TCP headers, without options
+  std::array<std::string, 2> _datagram {};     //!< an inbound datagram: its first HEADERS_LENGTH bytes; the rest
+
+  //! Read one datagram into `_datagram`; false if there was none to read
+  bool read_datagram();
 
 public:
   //! Construct from a TunFD
   explicit TCPOverIPv4OverTunFdAdapter( TunFD&& tun ) : _tun( std::move( tun ) ) {}
 
-  //! Attempts to read and parse an IPv4 datagram containing a TCP segment related to the current connection
+  //! Attempts to read and parse an IPv4 datagram containing a TCP segment related to the current connection.
+  //! The datagram is read with one system call and parsed where it lands; its payload is handed over in a buffer
+  //! from the BufferPool, without being copied.
   std::optional<TCPMessage> read();
 
+  //! Reads the datagrams waiting on the TUN device (which must be non-blocking), up to `max_datagrams`, and gives
+  //! each TCP segment for the current connection to `receive`. Returns the number of datagrams read.
+  template<class ReceiveFunction>
+  size_t read_batch( size_t max_datagrams, ReceiveFunction&& receive )
+  {
+    size_t count = 0;
+    while ( count < max_datagrams and read_datagram() ) {
+      ++count;
+      Parser datagram { std::span { _datagram } };
+      if ( auto msg = unwrap_tcp_in_ip( datagram ) ) {
+        receive( std::move( msg.value() ) );
+      }
+    }
+    return count;
+  }
+
   //! Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
-  void write( const TCPMessage& seg ) { _tun.write( serialize( wrap_tcp_in_ip( seg ) ) ); }
+  void write( const TCPMessage& seg );
+
+  //! Reads an IPv4 datagram carrying a TCP segment for any connection, and sets `flow` to say which
+  std::optional<TCPMessage> read( FourTuple& flow );
+
+  //! Writes a TCP segment for the connection `flow` to the TUN device
+  void write( const TCPMessage& seg, const FourTuple& flow );
 
   //! Access the underlying TUN device
   explicit operator TunFD&() { return _tun; }
@@ -47,3 +91,5 @@ public:
 
 static_assert( TCPDatagramAdapter<TCPOverIPv4OverTunFdAdapter> );
 static_assert( TCPDatagramAdapter<LossyFdAdapter<TCPOverIPv4OverTunFdAdapter>> );
+static_assert( BatchTCPDatagramAdapter<TCPOverIPv4OverTunFdAdapter> );
+static_assert( BatchTCPDatagramAdapter<LossyFdAdapter<TCPOverIPv4OverTunFdAdapter>> );